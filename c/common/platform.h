@@ -15,6 +15,7 @@
     * BROTLI_BUILD_PORTABLE disables dangerous optimizations, like unaligned
       read and overlapping memcpy; this reduces decompression speed by 5%
     * BROTLI_BUILD_NO_RBIT disables "rbit" optimization for ARM CPUs
+    * BROTLI_BUILD_NO_SIMD disables SIMD code paths in encoder
     * BROTLI_DEBUG dumps file name and line number when decoder detects stream
       or memory error
     * BROTLI_ENABLE_LOG enables asserts and dumps various state information
@@ -210,6 +211,14 @@ OR:
 #define BROTLI_TARGET_NEON
 #endif
 
+/* SSE2 is a part of x86-64 baseline. This is the only switch for SSE2 code
+   paths, so that BROTLI_BUILD_NO_SIMD turns them all off. */
+#if !defined(BROTLI_BUILD_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define BROTLI_TARGET_SSE2
+#endif
+
 #if defined(__i386) || defined(_M_IX86)
 #define BROTLI_TARGET_X86
 #endif
@@ -555,6 +564,18 @@ static BROTLI_INLINE uint32_t BrotliBsr32Msvc(uint32_t x) {
 #define BROTLI_BSR32 BrotliBsr32Msvc
 #endif /* __builtin_clz */
 
+/* BROTLI_PREFETCH hints that the cache line at address P is going to be read
+   soon. Address is not dereferenced, so it need not be valid. */
+#if BROTLI_GNUC_HAS_BUILTIN(__builtin_prefetch, 3, 1, 0) || \
+    BROTLI_INTEL_VERSION_CHECK(16, 0, 0)
+#define BROTLI_PREFETCH(P) __builtin_prefetch((P), 0, 3)
+#elif BROTLI_MSVC_VERSION_CHECK(18, 0, 0) && \
+    (defined(BROTLI_TARGET_X86) || defined(BROTLI_TARGET_X64))
+#define BROTLI_PREFETCH(P) _mm_prefetch((const char*)(P), _MM_HINT_T0)
+#else
+#define BROTLI_PREFETCH(P) BROTLI_UNUSED(P)
+#endif /* __builtin_prefetch */
+
 /* Default brotli_alloc_func */
 BROTLI_COMMON_API void* BrotliDefaultAllocFunc(void* opaque, size_t size);
 
@@ -17,6 +17,7 @@
 #include "../common/version.h"
 #include "./bit_reader.h"
 #include "./huffman.h"
+#include "./mirror.h"
 #include "./prefix.h"
 #include "./state.h"
 
@@ -45,6 +46,10 @@ extern "C" {
         5 prefix + 24 base + 8 suffix */
 static const uint32_t kRingBufferWriteAheadSlack = 42;
 
+/* Literal pair table is built only for blocks at least that long; building
+   costs about as much as decoding that many literals one by one. */
+static const uint32_t kLiteralPairsMinBlockLength = 2048;
+
 static const uint8_t kCodeLengthCodeOrder[BROTLI_CODE_LENGTH_CODES] = {
   1, 2, 3, 4, 0, 5, 17, 6, 16, 7, 8, 9, 10, 11, 12, 13, 14, 15,
 };
@@ -70,6 +75,10 @@ BROTLI_BOOL BrotliDecoderSetParameter(
       state->large_window = TO_BROTLI_BOOL(!!value);
       return BROTLI_TRUE;
 
+    case BROTLI_DECODER_PARAM_MIRRORED_RING_BUFFER:
+      state->mirror_ringbuffer = !!value ? 1 : 0;
+      return BROTLI_TRUE;
+
     default: return BROTLI_FALSE;
   }
 }
@@ -110,6 +119,80 @@ void BrotliDecoderDestroyInstance(BrotliDecoderState* state) {
   }
 }
 
+void BrotliDecoderReset(BrotliDecoderState* state) {
+  BrotliDecoderStateReset(state);
+}
+
+BROTLI_BOOL BrotliDecoderAttachDictionary(BrotliDecoderState* state,
+    size_t data_size, const uint8_t data[BROTLI_ARRAY_PARAM(data_size)]) {
+  BrotliDecoderCompoundDictionary* addon = &state->compound_dictionary;
+  int index = addon->num_chunks;
+  if (state->state != BROTLI_STATE_UNINITED) return BROTLI_FALSE;
+  if (index == BROTLI_DECODER_MAX_COMPOUND_DICTS) return BROTLI_FALSE;
+  if (data_size == 0 || !data) return BROTLI_FALSE;
+  if (data_size > (size_t)(BROTLI_MAX_ALLOWED_DISTANCE - addon->total_size)) {
+    return BROTLI_FALSE;
+  }
+  addon->chunks[index] = data;
+  addon->total_size += (int)data_size;
+  addon->chunk_offsets[index + 1] = addon->total_size;
+  addon->num_chunks++;
+  return BROTLI_TRUE;
+}
+
+BROTLI_BOOL BrotliDecoderSetCommandCallback(BrotliDecoderState* state,
+    brotli_decoder_command_func callback, void* opaque) {
+  if (state->state != BROTLI_STATE_UNINITED) return BROTLI_FALSE;
+  state->command_func = callback;
+  state->command_opaque = opaque;
+  return BROTLI_TRUE;
+}
+
+size_t BrotliDecoderEstimatePeakMemoryUsage(int window_bits,
+    size_t output_size) {
+  /* Per-tree table size; see BrotliDecoderHuffmanTreeGroupInit. */
+  const size_t kTableSlack = 376;
+  const size_t max_htrees = 256;
+  size_t ringbuffer_size;
+  size_t distance_alphabet_size = BROTLI_DISTANCE_ALPHABET_SIZE(
+      BROTLI_MAX_NPOSTFIX, BROTLI_MAX_NDIRECT, BROTLI_MAX_DISTANCE_BITS);
+  size_t tables_size;
+  if (window_bits < BROTLI_LARGE_MIN_WBITS) {
+    window_bits = BROTLI_LARGE_MIN_WBITS;
+  } else if (window_bits > BROTLI_LARGE_MAX_WBITS) {
+    window_bits = BROTLI_LARGE_MAX_WBITS;
+  }
+  if (window_bits > (int)BROTLI_MAX_DISTANCE_BITS) {
+    /* "Large window" stream. */
+    distance_alphabet_size = BrotliCalculateDistanceCodeLimit(
+        BROTLI_MAX_ALLOWED_DISTANCE, BROTLI_MAX_NPOSTFIX,
+        BROTLI_MAX_NDIRECT).max_alphabet_size;
+  }
+  /* Same as in BrotliCalculateRingBufferSize with "canny" allocation. */
+  ringbuffer_size = (size_t)1 << window_bits;
+  if (output_size != 0) {
+    const size_t min_size = BROTLI_MAX(size_t, output_size, 1024);
+    while ((ringbuffer_size >> 1) >= min_size) ringbuffer_size >>= 1;
+  }
+  /* Ring buffer grows while output is produced; old and new ones coexist
+     while data is copied. */
+  ringbuffer_size += (ringbuffer_size >> 1) + 2 * kRingBufferWriteAheadSlack;
+  /* Literal, insert-and-copy and distance tree groups; each has up to 256
+     trees. */
+  tables_size = max_htrees * (sizeof(HuffmanCode*) * 3 + sizeof(HuffmanCode) *
+      (BROTLI_NUM_LITERAL_SYMBOLS + BROTLI_NUM_COMMAND_SYMBOLS +
+       distance_alphabet_size + 3 * kTableSlack));
+  /* Block type and length trees. */
+  tables_size += sizeof(HuffmanCode) * 3 *
+      (BROTLI_HUFFMAN_MAX_SIZE_258 + BROTLI_HUFFMAN_MAX_SIZE_26);
+  /* Literal and distance context maps, context modes. */
+  tables_size += max_htrees * ((1 << BROTLI_LITERAL_CONTEXT_BITS) +
+      (1 << BROTLI_DISTANCE_CONTEXT_BITS) + 1);
+  /* Literal pair table. */
+  tables_size += sizeof(uint32_t) << BROTLI_HUFFMAN_PAIR_TABLE_BITS;
+  return sizeof(BrotliDecoderState) + ringbuffer_size + tables_size;
+}
+
 /* Saves error code and converts it to BrotliDecoderResult. */
 static BROTLI_NOINLINE BrotliDecoderResult SaveErrorCode(
     BrotliDecoderState* s, BrotliDecoderErrorCode e) {
@@ -1192,6 +1275,27 @@ static BROTLI_INLINE void PrepareLiteralDecoding(BrotliDecoderState* s) {
   s->context_lookup = BROTLI_CONTEXT_LUT(context_mode);
 }
 
+/* Builds pair table for the current literal tree, if the block is long
+   enough. Pairs are used if they cover at least a quarter of table keys;
+   that is roughly the probability to decode a pair with a single look-up.
+   Returns BROTLI_TRUE if pairs are to be used. Table is allocated on first
+   use; if that fails, literals are decoded one by one. */
+static BROTLI_BOOL BROTLI_NOINLINE PrepareLiteralPairs(BrotliDecoderState* s) {
+  uint32_t num_pairs;
+  if (s->block_length[0] < kLiteralPairsMinBlockLength) return BROTLI_FALSE;
+  if (!s->literal_pairs) {
+    s->literal_pairs = (uint32_t*)BROTLI_DECODER_ALLOC(s,
+        sizeof(uint32_t) << BROTLI_HUFFMAN_PAIR_TABLE_BITS);
+    if (!s->literal_pairs) return BROTLI_FALSE;
+  }
+  num_pairs = BrotliBuildHuffmanPairTable(
+      s->literal_pairs, s->literal_htree, HUFFMAN_TABLE_BITS);
+  s->literal_pairs_htree = s->literal_htree;
+  s->literal_pairs_useful =
+      (num_pairs << 2) >= (1U << BROTLI_HUFFMAN_PAIR_TABLE_BITS);
+  return TO_BROTLI_BOOL(s->literal_pairs_useful);
+}
+
 /* Decodes the block type and updates the state for literal context.
    Reads 3..54 bits. */
 static BROTLI_INLINE BROTLI_BOOL DecodeLiteralBlockSwitchInternal(
@@ -1255,7 +1359,8 @@ static BROTLI_BOOL BROTLI_NOINLINE SafeDecodeDistanceBlockSwitch(
 }
 
 static size_t UnwrittenBytes(const BrotliDecoderState* s, BROTLI_BOOL wrap) {
-  size_t pos = wrap && s->pos > s->ringbuffer_size ?
+  /* Mirrored ring buffer never needs wrapping to hand out output. */
+  size_t pos = wrap && !s->ringbuffer_mapping && s->pos > s->ringbuffer_size ?
       (size_t)s->ringbuffer_size : (size_t)(s->pos);
   size_t partial_pos_rb = (s->rb_roundtrips * (size_t)s->ringbuffer_size) + pos;
   return partial_pos_rb - s->partial_pos_out;
@@ -1267,8 +1372,9 @@ static size_t UnwrittenBytes(const BrotliDecoderState* s, BROTLI_BOOL wrap) {
 static BrotliDecoderErrorCode BROTLI_NOINLINE WriteRingBuffer(
     BrotliDecoderState* s, size_t* available_out, uint8_t** next_out,
     size_t* total_out, BROTLI_BOOL force) {
-  uint8_t* start =
-      s->ringbuffer + (s->partial_pos_out & (size_t)s->ringbuffer_mask);
+  /* Output lags at most one round behind, see wrapping below. */
+  uint8_t* start = s->ringbuffer +
+      (s->partial_pos_out - s->rb_roundtrips * (size_t)s->ringbuffer_size);
   size_t to_write = UnwrittenBytes(s, BROTLI_TRUE);
   size_t num_written = *available_out;
   if (num_written > to_write) {
@@ -1281,7 +1387,8 @@ static BrotliDecoderErrorCode BROTLI_NOINLINE WriteRingBuffer(
     *next_out = start;
   } else {
     if (next_out) {
-      memcpy(*next_out, start, num_written);
+      /* Output decoded in place is not copied. */
+      if (*next_out != start) memcpy(*next_out, start, num_written);
       *next_out += num_written;
     }
   }
@@ -1301,10 +1408,18 @@ static BrotliDecoderErrorCode BROTLI_NOINLINE WriteRingBuffer(
   }
   /* Wrap ring buffer only if it has reached its maximal size. */
   if (s->ringbuffer_size == (1 << s->window_bits) &&
-      s->pos >= s->ringbuffer_size) {
+      s->pos >= s->ringbuffer_size && !s->ringbuffer_is_output) {
     s->pos -= s->ringbuffer_size;
     s->rb_roundtrips++;
-    s->should_wrap_ringbuffer = (size_t)s->pos != 0 ? 1 : 0;
+    if (s->ringbuffer_mapping) {
+      /* Move to the other half; bytes written past the end are already
+         there. */
+      s->ringbuffer = s->ringbuffer_mapping +
+          (s->rb_roundtrips & 1) * (size_t)s->ringbuffer_size;
+      s->ringbuffer_end = s->ringbuffer + s->ringbuffer_size;
+    } else {
+      s->should_wrap_ringbuffer = (size_t)s->pos != 0 ? 1 : 0;
+    }
   }
   return BROTLI_DECODER_SUCCESS;
 }
@@ -1316,6 +1431,41 @@ static void BROTLI_NOINLINE WrapRingBuffer(BrotliDecoderState* s) {
   }
 }
 
+/* Maps mirrored ring buffer, if it is requested and possible; otherwise
+   releases the mirrored spare ring buffer, if any.
+
+   Mirrored ring buffer occupies twice the window size. Positions are masked
+   with twice the window size too, and |s->ringbuffer| is moved to the other
+   half on each wrap. This way positions from the previous round are located
+   right before |s->ringbuffer|, and writing past the end does not clobber
+   output that is not yet pushed. */
+static BROTLI_BOOL MapMirroredRingBuffer(BrotliDecoderState* s) {
+  const size_t size = 2 * (size_t)s->new_ringbuffer_size;
+  BROTLI_BOOL is_wanted = TO_BROTLI_BOOL(s->mirror_ringbuffer &&
+      s->new_ringbuffer_size == (1 << s->window_bits) && s->window_bits < 30);
+  uint8_t* mapping = NULL;
+  if (s->spare_ringbuffer_mapped) {
+    if (is_wanted && s->spare_ringbuffer_size == s->new_ringbuffer_size) {
+      mapping = s->spare_ringbuffer;
+      s->spare_ringbuffer = NULL;
+      s->spare_ringbuffer_mapped = 0;
+    } else {
+      BrotliDecoderStateFreeSpareRingBuffer(s);
+    }
+  }
+  if (!is_wanted) return BROTLI_FALSE;
+  if (!mapping) mapping = BrotliMapMirrored(size);
+  if (!mapping) return BROTLI_FALSE;
+  mapping[size - 2] = 0;
+  mapping[size - 1] = 0;
+  s->ringbuffer_mapping = mapping;
+  s->ringbuffer = mapping;
+  s->ringbuffer_size = s->new_ringbuffer_size;
+  s->ringbuffer_mask = (int)size - 1;
+  s->ringbuffer_end = s->ringbuffer + s->ringbuffer_size;
+  return BROTLI_TRUE;
+}
+
 /* Allocates ring-buffer.
 
    s->ringbuffer_size MUST be updated by BrotliCalculateRingBufferSize before
@@ -1326,17 +1476,35 @@ static void BROTLI_NOINLINE WrapRingBuffer(BrotliDecoderState* s) {
 static BROTLI_BOOL BROTLI_NOINLINE BrotliEnsureRingBuffer(
     BrotliDecoderState* s) {
   uint8_t* old_ringbuffer = s->ringbuffer;
+  uint8_t* new_ringbuffer = NULL;
   if (s->ringbuffer_size == s->new_ringbuffer_size) {
     return BROTLI_TRUE;
   }
 
-  s->ringbuffer = (uint8_t*)BROTLI_DECODER_ALLOC(s,
-      (size_t)(s->new_ringbuffer_size) + kRingBufferWriteAheadSlack);
-  if (s->ringbuffer == 0) {
-    /* Restore previous value. */
-    s->ringbuffer = old_ringbuffer;
-    return BROTLI_FALSE;
+  if (!old_ringbuffer && MapMirroredRingBuffer(s)) {
+    return BROTLI_TRUE;
+  }
+
+  if (!old_ringbuffer && s->spare_ringbuffer) {
+    /* Reuse ring buffer of the previous stream (see BrotliDecoderReset). */
+    if (s->spare_ringbuffer_size >= s->new_ringbuffer_size) {
+      /* Bigger ring buffer saves reallocations; window size is the limit. */
+      if (s->spare_ringbuffer_size <= (1 << s->window_bits)) {
+        s->new_ringbuffer_size = s->spare_ringbuffer_size;
+      }
+      new_ringbuffer = s->spare_ringbuffer;
+      s->spare_ringbuffer = NULL;
+    } else {
+      BROTLI_DECODER_FREE(s, s->spare_ringbuffer);
+    }
+  }
+
+  if (!new_ringbuffer) {
+    new_ringbuffer = (uint8_t*)BROTLI_DECODER_ALLOC(s,
+        (size_t)(s->new_ringbuffer_size) + kRingBufferWriteAheadSlack);
+    if (new_ringbuffer == 0) return BROTLI_FALSE;
   }
+  s->ringbuffer = new_ringbuffer;
   s->ringbuffer[s->new_ringbuffer_size - 2] = 0;
   s->ringbuffer[s->new_ringbuffer_size - 1] = 0;
 
@@ -1375,7 +1543,7 @@ static BrotliDecoderErrorCode BROTLI_NOINLINE CopyUncompressedBlockToOutput(
         BrotliCopyBytes(&s->ringbuffer[s->pos], &s->br, (size_t)nbytes);
         s->pos += nbytes;
         s->meta_block_remaining_len -= nbytes;
-        if (s->pos < 1 << s->window_bits) {
+        if (s->pos < 1 << s->window_bits || s->ringbuffer_is_output) {
           if (s->meta_block_remaining_len == 0) {
             return BROTLI_DECODER_SUCCESS;
           }
@@ -1423,6 +1591,11 @@ static void BROTLI_NOINLINE BrotliCalculateRingBufferSize(
     return;
   }
 
+  /* Output buffer of one-shot decompression is never replaced. */
+  if (s->ringbuffer_is_output) {
+    return;
+  }
+
   /* Metadata blocks does not touch ring buffer. */
   if (s->is_metadata) {
     return;
@@ -1436,7 +1609,7 @@ static void BROTLI_NOINLINE BrotliCalculateRingBufferSize(
   output_size += s->meta_block_remaining_len;
   min_size = min_size < output_size ? output_size : min_size;
 
-  if (!!s->canny_ringbuffer_allocation) {
+  if (!!s->canny_ringbuffer_allocation && !s->mirror_ringbuffer) {
     /* Reduce ring buffer size to save memory when server is unscrupulous.
        In worst case memory usage might be 1.5x bigger for a short period of
        ring buffer reallocation. */
@@ -1719,6 +1892,40 @@ static BROTLI_INLINE BROTLI_BOOL CheckInputAmount(
   return BrotliCheckInputAmount(br, num);
 }
 
+/* Starts a copy of |length| bytes from the attached dictionaries; |address|
+   is an offset in the concatenation of them. Copy must not cross the chunk
+   boundary. */
+static BROTLI_BOOL InitializeCompoundDictionaryCopy(BrotliDecoderState* s,
+    int address, int length) {
+  BrotliDecoderCompoundDictionary* addon = &s->compound_dictionary;
+  int index = addon->num_chunks - 1;
+  while (address < addon->chunk_offsets[index]) index--;
+  if (addon->chunk_offsets[index + 1] - address < length) return BROTLI_FALSE;
+  /* Update the recent distances cache. */
+  s->dist_rb[s->dist_rb_idx & 3] = s->distance_code;
+  ++s->dist_rb_idx;
+  s->meta_block_remaining_len -= length;
+  addon->br_index = index;
+  addon->br_offset = address - addon->chunk_offsets[index];
+  addon->br_length = length;
+  addon->br_copied = 0;
+  return BROTLI_TRUE;
+}
+
+/* Continues pending dictionary copy; stops at the end of ring buffer.
+   Returns the number of bytes written. */
+static int CopyFromCompoundDictionary(BrotliDecoderState* s, int pos) {
+  BrotliDecoderCompoundDictionary* addon = &s->compound_dictionary;
+  const uint8_t* copy_src = addon->chunks[addon->br_index] + addon->br_offset;
+  int space = s->ringbuffer_size - pos;
+  int length = addon->br_length - addon->br_copied;
+  if (length > space) length = space;
+  memcpy(&s->ringbuffer[pos], copy_src, (size_t)length);
+  addon->br_offset += length;
+  addon->br_copied += length;
+  return length;
+}
+
 #define BROTLI_SAFE(METHOD)                       \
   {                                               \
     if (safe) {                                   \
@@ -1731,10 +1938,20 @@ static BROTLI_INLINE BROTLI_BOOL CheckInputAmount(
     }                                             \
   }
 
+/* Reports the command being decoded to the client, if requested. */
+static BROTLI_INLINE void ReportCommand(
+    BrotliDecoderState* s, int copy_length, int distance) {
+  if (BROTLI_PREDICT_FALSE(s->command_func != NULL)) {
+    s->command_func(s->command_opaque, (size_t)s->command_insert_length,
+                    (size_t)copy_length, (size_t)distance);
+  }
+}
+
 static BROTLI_INLINE BrotliDecoderErrorCode ProcessCommandsInternal(
     int safe, BrotliDecoderState* s) {
   int pos = s->pos;
   int i = s->loop_counter;
+  const int compound_dictionary_size = s->compound_dictionary.total_size;
   BrotliDecoderErrorCode result = BROTLI_DECODER_SUCCESS;
   BrotliBitReader* br = &s->br;
 
@@ -1776,6 +1993,7 @@ CommandBegin:
   BROTLI_SAFE(ReadCommand(s, br, &i));
   BROTLI_LOG(("[ProcessCommandsInternal] pos = %d insert = %d copy = %d\n",
               pos, i, s->copy_length));
+  s->command_insert_length = i;
   if (i == 0) {
     goto CommandPostDecodeLiterals;
   }
@@ -1789,6 +2007,37 @@ CommandInner:
   if (s->trivial_literal_context) {
     uint32_t bits;
     uint32_t value;
+    if (!safe && i > 2 && (s->literal_pairs_htree == s->literal_htree ?
+        s->literal_pairs_useful : PrepareLiteralPairs(s))) {
+      /* Decode two literals per look-up, while far enough from the end of
+         command, block and ring buffer; the last literal is left for the
+         regular loop below. */
+      const uint32_t* pairs = s->literal_pairs;
+      uint8_t* ringbuffer = s->ringbuffer;
+      int start = pos;
+      int end = pos + i - 1;
+      if ((uint32_t)(end - pos) > s->block_length[0]) {
+        end = pos + (int)s->block_length[0];
+      }
+      if (end > s->ringbuffer_size - 1) end = s->ringbuffer_size - 1;
+      while (end - pos >= 2) {
+        uint32_t entry;
+        if (!CheckInputAmount(safe, br, 28)) break;
+        entry = pairs[BrotliGetBits(br, BROTLI_HUFFMAN_PAIR_TABLE_BITS)];
+        ringbuffer[pos] = (uint8_t)entry;
+        ringbuffer[pos + 1] = (uint8_t)(entry >> 8);
+        BrotliDropBits(br, (entry >> 16) & 0xFF);
+        if (BROTLI_PREDICT_FALSE((entry >> 24) == 0)) {
+          /* First code is longer than root table bits. */
+          ringbuffer[pos] = (uint8_t)ReadSymbol(s->literal_htree, br);
+          ++pos;
+        } else {
+          pos += (int)(entry >> 24);
+        }
+      }
+      i -= pos - start;
+      s->block_length[0] -= (uint32_t)(pos - start);
+    }
     PreloadSymbol(safe, s->literal_htree, br, &bits, &value);
     do {
       if (!CheckInputAmount(safe, br, 28)) {  /* 162 bits + 7 bytes */
@@ -1822,8 +2071,15 @@ CommandInner:
       }
     } while (--i != 0);
   } else {
-    uint8_t p1 = s->ringbuffer[(pos - 1) & s->ringbuffer_mask];
-    uint8_t p2 = s->ringbuffer[(pos - 2) & s->ringbuffer_mask];
+    uint8_t p1 = 0;
+    uint8_t p2 = 0;
+    if (BROTLI_PREDICT_TRUE(pos >= 2) || !s->ringbuffer_is_output) {
+      p1 = s->ringbuffer[(pos - 1) & s->ringbuffer_mask];
+      p2 = s->ringbuffer[(pos - 2) & s->ringbuffer_mask];
+    } else if (pos == 1) {
+      /* Output buffer has no zeroed bytes before the start. */
+      p1 = s->ringbuffer[0];
+    }
     do {
       const HuffmanCode* hc;
       uint8_t context;
@@ -1864,6 +2120,7 @@ CommandInner:
   }
   BROTLI_LOG_UINT(s->meta_block_remaining_len);
   if (BROTLI_PREDICT_FALSE(s->meta_block_remaining_len <= 0)) {
+    ReportCommand(s, 0, 0);
     s->state = BROTLI_STATE_METABLOCK_DONE;
     goto saveStateAndReturn;
   }
@@ -1903,9 +2160,22 @@ CommandPostDecodeLiterals:
           pos, s->distance_code, i, s->meta_block_remaining_len));
       return BROTLI_FAILURE(BROTLI_DECODER_ERROR_FORMAT_DISTANCE);
     }
-    if (i >= BROTLI_MIN_DICTIONARY_WORD_LENGTH &&
-        i <= BROTLI_MAX_DICTIONARY_WORD_LENGTH) {
-      int address = s->distance_code - s->max_distance - 1;
+    if (s->distance_code - s->max_distance - 1 < compound_dictionary_size) {
+      int address = compound_dictionary_size -
+          (s->distance_code - s->max_distance);
+      if (!InitializeCompoundDictionaryCopy(s, address, i)) {
+        return BROTLI_FAILURE(BROTLI_DECODER_ERROR_COMPOUND_DICTIONARY);
+      }
+      ReportCommand(s, i, 0);
+      pos += CopyFromCompoundDictionary(s, pos);
+      if (pos >= s->ringbuffer_size) {
+        s->state = BROTLI_STATE_COMMAND_POST_WRITE_1;
+        goto saveStateAndReturn;
+      }
+    } else if (i >= BROTLI_MIN_DICTIONARY_WORD_LENGTH &&
+               i <= BROTLI_MAX_DICTIONARY_WORD_LENGTH) {
+      int address = s->distance_code - s->max_distance - 1 -
+          compound_dictionary_size;
       const BrotliDictionary* words = s->dictionary;
       const BrotliTransforms* transforms = s->transforms;
       int offset = (int)s->dictionary->offsets_by_length[i];
@@ -1923,17 +2193,32 @@ CommandPostDecodeLiterals:
       if (transform_idx < (int)transforms->num_transforms) {
         const uint8_t* word = &words->data[offset];
         int len = i;
+        uint8_t* word_dst = &s->ringbuffer[pos];
+        /* Longest transformed word: 5 prefix + 24 base + 8 suffix. */
+        uint8_t word_buf[40];
+        if (BROTLI_PREDICT_FALSE(s->ringbuffer_is_output) &&
+            s->ringbuffer_size - pos < (int)kRingBufferWriteAheadSlack) {
+          /* Output buffer has no slack; word is checked before copying. */
+          word_dst = word_buf;
+        }
         if (transform_idx == transforms->cutOffTransforms[0]) {
-          memcpy(&s->ringbuffer[pos], word, (size_t)len);
+          memcpy(word_dst, word, (size_t)len);
           BROTLI_LOG(("[ProcessCommandsInternal] dictionary word: [%.*s]\n",
                       len, word));
         } else {
-          len = BrotliTransformDictionaryWord(&s->ringbuffer[pos], word, len,
+          len = BrotliTransformDictionaryWord(word_dst, word, len,
               transforms, transform_idx);
           BROTLI_LOG(("[ProcessCommandsInternal] dictionary word: [%.*s],"
                       " transform_idx = %d, transformed: [%.*s]\n",
-                      i, word, transform_idx, len, &s->ringbuffer[pos]));
+                      i, word, transform_idx, len, word_dst));
+        }
+        if (word_dst == word_buf) {
+          if (len > s->ringbuffer_size - pos) {
+            return BROTLI_FAILURE(BROTLI_DECODER_ERROR_FORMAT_BLOCK_LENGTH_2);
+          }
+          memcpy(&s->ringbuffer[pos], word_buf, (size_t)len);
         }
+        ReportCommand(s, len, 0);
         pos += len;
         s->meta_block_remaining_len -= len;
         if (pos >= s->ringbuffer_size) {
@@ -1958,21 +2243,35 @@ CommandPostDecodeLiterals:
     uint8_t* copy_src = &s->ringbuffer[src_start];
     int dst_end = pos + i;
     int src_end = src_start + i;
+    ReportCommand(s, i, s->distance_code);
     /* Update the recent distances cache. */
     s->dist_rb[s->dist_rb_idx & 3] = s->distance_code;
     ++s->dist_rb_idx;
     s->meta_block_remaining_len -= i;
+    if (BROTLI_PREDICT_FALSE(pos > s->ringbuffer_size - 32) &&
+        s->ringbuffer_is_output) {
+      /* Output buffer has no slack for 16-byte copies below. */
+      goto CommandPostWrapCopy;
+    }
     /* There are 32+ bytes of slack in the ring-buffer allocation.
        Also, we have 16 short codes, that make these 16 bytes irrelevant
        in the ring-buffer. Let's copy over them as a first guess. */
     memmove16(copy_dst, copy_src);
-    if (src_end > pos && dst_end > src_start) {
-      /* Regions intersect. */
-      goto CommandPostWrapCopy;
-    }
-    if (dst_end >= s->ringbuffer_size || src_end >= s->ringbuffer_size) {
-      /* At least one region wraps. */
-      goto CommandPostWrapCopy;
+    if (s->ringbuffer_mapping) {
+      /* Both regions are linear in mirrored ring buffer; writing past its end
+         only requires pushing the output before the next command. */
+      if (s->distance_code < i || dst_end > s->ringbuffer_mask) {
+        goto CommandPostWrapCopy;
+      }
+    } else {
+      if (src_end > pos && dst_end > src_start) {
+        /* Regions intersect. */
+        goto CommandPostWrapCopy;
+      }
+      if (dst_end >= s->ringbuffer_size || src_end >= s->ringbuffer_size) {
+        /* At least one region wraps. */
+        goto CommandPostWrapCopy;
+      }
     }
     pos += i;
     if (i > 16) {
@@ -1984,6 +2283,11 @@ CommandPostDecodeLiterals:
         memmove16(copy_dst + 16, copy_src + 16);
       }
     }
+    if (pos >= s->ringbuffer_size) {
+      i = 0;
+      s->state = BROTLI_STATE_COMMAND_POST_WRITE_2;
+      goto saveStateAndReturn;
+    }
   }
   BROTLI_LOG_UINT(s->meta_block_remaining_len);
   if (s->meta_block_remaining_len <= 0) {
@@ -2045,6 +2349,16 @@ BrotliDecoderResult BrotliDecoderDecompress(
   if (!BrotliDecoderStateInit(&s, 0, 0, 0)) {
     return BROTLI_DECODER_RESULT_ERROR;
   }
+  if (available_out != 0 && available_out < ((size_t)1 << 30)) {
+    /* Whole output is at hand; use it as history window instead of
+       allocating ring buffer and copying from it. */
+    s.ringbuffer = decoded_buffer;
+    s.ringbuffer_size = (int)available_out;
+    s.new_ringbuffer_size = s.ringbuffer_size;
+    s.ringbuffer_mask = ~0;
+    s.ringbuffer_end = decoded_buffer + available_out;
+    s.ringbuffer_is_output = 1;
+  }
   result = BrotliDecoderDecompressStream(
       &s, &available_in, &next_in, &available_out, &next_out, &total_out);
   *decoded_size = total_out;
@@ -2201,10 +2515,13 @@ BrotliDecoderResult BrotliDecoderDecompressStream(
         /* Maximum distance, see section 9.1. of the spec. */
         s->max_backward_distance = (1 << s->window_bits) - BROTLI_WINDOW_GAP;
 
-        /* Allocate memory for both block_type_trees and block_len_trees. */
-        s->block_type_trees = (HuffmanCode*)BROTLI_DECODER_ALLOC(s,
-            sizeof(HuffmanCode) * 3 *
-                (BROTLI_HUFFMAN_MAX_SIZE_258 + BROTLI_HUFFMAN_MAX_SIZE_26));
+        /* Allocate memory for both block_type_trees and block_len_trees;
+           after BrotliDecoderReset it is already allocated. */
+        if (s->block_type_trees == 0) {
+          s->block_type_trees = (HuffmanCode*)BROTLI_DECODER_ALLOC(s,
+              sizeof(HuffmanCode) * 3 *
+                  (BROTLI_HUFFMAN_MAX_SIZE_258 + BROTLI_HUFFMAN_MAX_SIZE_26));
+        }
         if (s->block_type_trees == 0) {
           result = BROTLI_FAILURE(BROTLI_DECODER_ERROR_ALLOC_BLOCK_TYPE_TREES);
           break;
@@ -2244,8 +2561,17 @@ BrotliDecoderResult BrotliDecoderDecompressStream(
           s->state = BROTLI_STATE_METABLOCK_DONE;
           break;
         }
+        if (s->ringbuffer_is_output &&
+            s->meta_block_remaining_len > s->ringbuffer_size - s->pos) {
+          /* Output buffer is too small. Checking whole metablocks ahead
+             also guarantees that valid commands never write past it. */
+          result = BROTLI_DECODER_NEEDS_MORE_OUTPUT;
+          break;
+        }
         BrotliCalculateRingBufferSize(s);
         if (s->is_uncompressed) {
+          s->command_insert_length = s->meta_block_remaining_len;
+          ReportCommand(s, 0, 0);
           s->state = BROTLI_STATE_UNCOMPRESSED;
           break;
         }
@@ -2481,6 +2807,11 @@ BrotliDecoderResult BrotliDecoderDecompressStream(
           s->max_distance = s->max_backward_distance;
         }
         if (s->state == BROTLI_STATE_COMMAND_POST_WRITE_1) {
+          BrotliDecoderCompoundDictionary* addon = &s->compound_dictionary;
+          if (addon->br_length != addon->br_copied) {
+            s->pos += CopyFromCompoundDictionary(s, s->pos);
+            if (s->pos >= s->ringbuffer_size) continue;
+          }
           if (s->meta_block_remaining_len == 0) {
             /* Next metablock, if any. */
             s->state = BROTLI_STATE_METABLOCK_DONE;
@@ -2493,6 +2824,7 @@ BrotliDecoderResult BrotliDecoderDecompressStream(
         } else {  /* BROTLI_STATE_COMMAND_INNER_WRITE */
           if (s->loop_counter == 0) {
             if (s->meta_block_remaining_len == 0) {
+              ReportCommand(s, 0, 0);
               s->state = BROTLI_STATE_METABLOCK_DONE;
             } else {
               s->state = BROTLI_STATE_COMMAND_POST_DECODE_LITERALS;
@@ -334,6 +334,37 @@ uint32_t BrotliBuildSimpleHuffmanTable(HuffmanCode* table,
   return goal_size;
 }
 
+uint32_t BrotliBuildHuffmanPairTable(uint32_t* pair_table,
+                                     const HuffmanCode* root_table,
+                                     int root_bits) {
+  const uint32_t root_mask = (1U << root_bits) - 1;
+  const uint32_t table_size = 1U << BROTLI_HUFFMAN_PAIR_TABLE_BITS;
+  uint32_t num_pairs = 0;
+  uint32_t key;
+  for (key = 0; key < table_size; ++key) {
+    const HuffmanCode* first = &root_table[key & root_mask];
+    uint32_t entry = 0;
+    BROTLI_HC_MARK_TABLE_FOR_FAST_LOAD(first);
+    if (BROTLI_HC_FAST_LOAD_BITS(first) <= (uint32_t)root_bits) {
+      const uint32_t bits = BROTLI_HC_FAST_LOAD_BITS(first);
+      const HuffmanCode* second = &root_table[(key >> bits) & root_mask];
+      BROTLI_HC_MARK_TABLE_FOR_FAST_LOAD(second);
+      entry = (1U << 24) | (bits << 16) | BROTLI_HC_FAST_LOAD_VALUE(first);
+      if (BROTLI_HC_FAST_LOAD_BITS(second) <= (uint32_t)root_bits &&
+          bits + BROTLI_HC_FAST_LOAD_BITS(second) <=
+              BROTLI_HUFFMAN_PAIR_TABLE_BITS) {
+        entry = (2U << 24) |
+            ((bits + BROTLI_HC_FAST_LOAD_BITS(second)) << 16) |
+            ((uint32_t)BROTLI_HC_FAST_LOAD_VALUE(second) << 8) |
+            BROTLI_HC_FAST_LOAD_VALUE(first);
+        ++num_pairs;
+      }
+    }
+    pair_table[key] = entry;
+  }
+  return num_pairs;
+}
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
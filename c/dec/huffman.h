@@ -103,6 +103,20 @@ BROTLI_INTERNAL uint32_t BrotliBuildHuffmanTable(HuffmanCode* root_table,
 BROTLI_INTERNAL uint32_t BrotliBuildSimpleHuffmanTable(HuffmanCode* table,
     int root_bits, uint16_t* symbols, uint32_t num_symbols);
 
+/* Pair table is indexed with the next BROTLI_HUFFMAN_PAIR_TABLE_BITS bits of
+   input. Each entry holds the number of decoded symbols (0..2) in bits 24..31,
+   the total length of their codes in bits 16..23, the first symbol in bits
+   0..7 and the second symbol in bits 8..15. 0 symbols means that the first code
+   is longer than root bits and has to be decoded with the regular table. */
+#define BROTLI_HUFFMAN_PAIR_TABLE_BITS 10
+
+/* Builds a table for decoding two symbols of an alphabet of at most 256
+   symbols with a single look-up, from the root table of regular Huffman table.
+   Pair is formed only if both codes fit the root table.
+   Returns the number of entries holding pairs. */
+BROTLI_INTERNAL uint32_t BrotliBuildHuffmanPairTable(uint32_t* pair_table,
+    const HuffmanCode* root_table, int root_bits);
+
 /* Contains a collection of Huffman trees with the same alphabet size. */
 /* alphabet_size_limit is needed due to simple codes, since
    log2(alphabet_size_max) could be greater than log2(alphabet_size_limit). */
@@ -0,0 +1,91 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Memory mapped twice, back to back, used for mirrored ring buffer. */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  /* syscall, MAP_ANONYMOUS */
+#endif
+
+#include "./mirror.h"
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+
+#if defined(BROTLI_DECODER_NO_MIRRORING)
+/* Mirroring is explicitly disabled. */
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(SYS_memfd_create)
+#define BROTLI_MIRROR_MEMFD
+#endif
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+#if defined(BROTLI_MIRROR_MEMFD)
+
+uint8_t* BrotliMapMirrored(size_t size) {
+  const unsigned int kMemfdCloexec = 1;  /* MFD_CLOEXEC */
+  long page_size = sysconf(_SC_PAGESIZE);
+  uint8_t* result;
+  int fd;
+  if (page_size <= 0 || size == 0 || (size % (size_t)page_size) != 0) {
+    return NULL;
+  }
+  if (size > (~(size_t)0 >> 2)) return NULL;
+  fd = (int)syscall(SYS_memfd_create, "brotli-ringbuffer", kMemfdCloexec);
+  if (fd < 0) return NULL;
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    return NULL;
+  }
+  /* Reserve address range for both views, then place them over it. */
+  result = (uint8_t*)mmap(NULL, 2 * size, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (result == (uint8_t*)MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+  if (mmap(result, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           fd, 0) == MAP_FAILED ||
+      mmap(result + size, size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(result, 2 * size);
+    close(fd);
+    return NULL;
+  }
+  /* Mappings keep the memory alive. */
+  close(fd);
+  return result;
+}
+
+void BrotliUnmapMirrored(uint8_t* mapping, size_t size) {
+  if (mapping) munmap(mapping, 2 * size);
+}
+
+#else  /* BROTLI_MIRROR_MEMFD */
+
+uint8_t* BrotliMapMirrored(size_t size) {
+  BROTLI_UNUSED(size);
+  return NULL;
+}
+
+void BrotliUnmapMirrored(uint8_t* mapping, size_t size) {
+  BROTLI_UNUSED(mapping);
+  BROTLI_UNUSED(size);
+}
+
+#endif  /* BROTLI_MIRROR_MEMFD */
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
@@ -0,0 +1,34 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Memory mapped twice, back to back, used for mirrored ring buffer. */
+
+#ifndef BROTLI_DEC_MIRROR_H_
+#define BROTLI_DEC_MIRROR_H_
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/* Maps |size| bytes of zeroed memory twice: bytes at |result[i]| and
+   |result[size + i]| are the same for any |i| in [0, size). |size| has to be
+   a multiple of page size.
+
+   Returns NULL if platform does not support such mappings, or mapping
+   fails. */
+BROTLI_INTERNAL uint8_t* BrotliMapMirrored(size_t size);
+
+/* Releases memory obtained with BrotliMapMirrored(|size|). */
+BROTLI_INTERNAL void BrotliUnmapMirrored(uint8_t* mapping, size_t size);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
+
+#endif  /* BROTLI_DEC_MIRROR_H_ */
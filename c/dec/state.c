@@ -10,6 +10,7 @@
 
 #include <brotli/types.h>
 #include "./huffman.h"
+#include "./mirror.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
@@ -46,9 +47,13 @@ BROTLI_BOOL BrotliDecoderStateInit(BrotliDecoderState* s,
   s->block_type_trees = NULL;
   s->block_len_trees = NULL;
   s->ringbuffer = NULL;
+  s->ringbuffer_mapping = NULL;
   s->ringbuffer_size = 0;
   s->new_ringbuffer_size = 0;
   s->ringbuffer_mask = 0;
+  s->spare_ringbuffer = NULL;
+  s->spare_ringbuffer_size = 0;
+  s->spare_ringbuffer_mapped = 0;
 
   s->context_map = NULL;
   s->context_modes = NULL;
@@ -68,6 +73,8 @@ BROTLI_BOOL BrotliDecoderStateInit(BrotliDecoderState* s,
   s->is_metadata = 0;
   s->should_wrap_ringbuffer = 0;
   s->canny_ringbuffer_allocation = 1;
+  s->mirror_ringbuffer = 0;
+  s->ringbuffer_is_output = 0;
 
   s->window_bits = 0;
   s->max_distance = 0;
@@ -84,6 +91,20 @@ BROTLI_BOOL BrotliDecoderStateInit(BrotliDecoderState* s,
   s->dictionary = BrotliGetDictionary();
   s->transforms = BrotliGetTransforms();
 
+  s->compound_dictionary.num_chunks = 0;
+  s->compound_dictionary.total_size = 0;
+  s->compound_dictionary.br_length = 0;
+  s->compound_dictionary.br_copied = 0;
+  s->compound_dictionary.chunk_offsets[0] = 0;
+
+  s->command_func = NULL;
+  s->command_opaque = NULL;
+  s->command_insert_length = 0;
+
+  s->literal_pairs_htree = NULL;
+  s->literal_pairs_useful = 0;
+  s->literal_pairs = NULL;
+
   return BROTLI_TRUE;
 }
 
@@ -106,6 +127,7 @@ void BrotliDecoderStateMetablockBegin(BrotliDecoderState* s) {
   s->dist_context_map = NULL;
   s->context_map_slice = NULL;
   s->literal_htree = NULL;
+  s->literal_pairs_htree = NULL;
   s->dist_context_map_slice = NULL;
   s->dist_htree_index = 0;
   s->context_lookup = NULL;
@@ -126,11 +148,57 @@ void BrotliDecoderStateCleanupAfterMetablock(BrotliDecoderState* s) {
   BROTLI_DECODER_FREE(s, s->distance_hgroup.htrees);
 }
 
+void BrotliDecoderStateFreeSpareRingBuffer(BrotliDecoderState* s) {
+  if (s->spare_ringbuffer_mapped) {
+    BrotliUnmapMirrored(s->spare_ringbuffer,
+                        2 * (size_t)s->spare_ringbuffer_size);
+    s->spare_ringbuffer = NULL;
+  } else {
+    BROTLI_DECODER_FREE(s, s->spare_ringbuffer);
+  }
+  s->spare_ringbuffer_mapped = 0;
+}
+
 void BrotliDecoderStateCleanup(BrotliDecoderState* s) {
   BrotliDecoderStateCleanupAfterMetablock(s);
 
-  BROTLI_DECODER_FREE(s, s->ringbuffer);
+  if (s->ringbuffer_mapping) {
+    BrotliUnmapMirrored(s->ringbuffer_mapping, 2 * (size_t)s->ringbuffer_size);
+    s->ringbuffer_mapping = NULL;
+    s->ringbuffer = NULL;
+  } else if (s->ringbuffer_is_output) {
+    /* Owned by the caller. */
+    s->ringbuffer = NULL;
+  } else {
+    BROTLI_DECODER_FREE(s, s->ringbuffer);
+  }
+  BrotliDecoderStateFreeSpareRingBuffer(s);
   BROTLI_DECODER_FREE(s, s->block_type_trees);
+  BROTLI_DECODER_FREE(s, s->literal_pairs);
+}
+
+void BrotliDecoderStateReset(BrotliDecoderState* s) {
+  uint8_t* ringbuffer = s->ringbuffer;
+  int ringbuffer_size = s->ringbuffer_size;
+  BROTLI_BOOL ringbuffer_mapped = TO_BROTLI_BOOL(!!s->ringbuffer_mapping);
+  HuffmanCode* block_type_trees = s->block_type_trees;
+  if (!ringbuffer) {
+    ringbuffer = s->spare_ringbuffer;
+    ringbuffer_size = s->spare_ringbuffer_size;
+    ringbuffer_mapped = TO_BROTLI_BOOL(s->spare_ringbuffer_mapped);
+  } else {
+    if (ringbuffer_mapped) ringbuffer = s->ringbuffer_mapping;
+    BrotliDecoderStateFreeSpareRingBuffer(s);
+  }
+  BrotliDecoderStateCleanupAfterMetablock(s);
+  BROTLI_DECODER_FREE(s, s->literal_pairs);
+  /* Never fails, as memory manager functions are already set. */
+  BrotliDecoderStateInit(s, s->alloc_func, s->free_func,
+                         s->memory_manager_opaque);
+  s->spare_ringbuffer = ringbuffer;
+  s->spare_ringbuffer_size = ringbuffer_size;
+  s->spare_ringbuffer_mapped = ringbuffer_mapped ? 1 : 0;
+  s->block_type_trees = block_type_trees;
 }
 
 BROTLI_BOOL BrotliDecoderHuffmanTreeGroupInit(BrotliDecoderState* s,
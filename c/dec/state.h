@@ -13,6 +13,7 @@
 #include "../common/dictionary.h"
 #include "../common/platform.h"
 #include "../common/transform.h"
+#include <brotli/decode.h>
 #include <brotli/types.h>
 #include "./bit_reader.h"
 #include "./huffman.h"
@@ -233,6 +234,24 @@ typedef struct BrotliMetablockBodyArena {
   uint32_t dist_offset[544];
 } BrotliMetablockBodyArena;
 
+/* Maximal number of raw dictionaries that could be attached to decoder. */
+#define BROTLI_DECODER_MAX_COMPOUND_DICTS 15
+
+/* Raw dictionaries attached to decoder. Dictionaries are logically
+   concatenated, and the result is placed right before the beginning of the
+   stream. Memory is owned by the caller; it is only read by decoder. */
+typedef struct BrotliDecoderCompoundDictionary {
+  int num_chunks;
+  int total_size;
+  /* Pending copy: chunk index, offset in chunk, length and progress. */
+  int br_index;
+  int br_offset;
+  int br_length;
+  int br_copied;
+  const uint8_t* chunks[BROTLI_DECODER_MAX_COMPOUND_DICTS];
+  int chunk_offsets[BROTLI_DECODER_MAX_COMPOUND_DICTS + 1];
+} BrotliDecoderCompoundDictionary;
+
 struct BrotliDecoderStateStruct {
   BrotliRunningState state;
 
@@ -263,6 +282,10 @@ struct BrotliDecoderStateStruct {
   int error_code;
   uint8_t* ringbuffer;
   uint8_t* ringbuffer_end;
+  /* Start of mirrored ring buffer mapping, or NULL if ring buffer is allocated
+     on heap. Mirrored ring buffer is twice as big as window; |ringbuffer|
+     points to its first or second half, so that history is always linear. */
+  uint8_t* ringbuffer_mapping;
   HuffmanCode* htree_command;
   const uint8_t* context_lookup;
   uint8_t* context_map_slice;
@@ -317,11 +340,21 @@ struct BrotliDecoderStateStruct {
   unsigned int is_metadata : 1;
   unsigned int should_wrap_ringbuffer : 1;
   unsigned int canny_ringbuffer_allocation : 1;
+  unsigned int mirror_ringbuffer : 1;
+  unsigned int spare_ringbuffer_mapped : 1;
+  /* Set if |ringbuffer| is the output buffer of one-shot decompression. It
+     never wraps, and decoded bytes are already in place. */
+  unsigned int ringbuffer_is_output : 1;
   unsigned int large_window : 1;
   unsigned int size_nibbles : 8;
   uint32_t window_bits;
 
   int new_ringbuffer_size;
+  /* Ring buffer left by BrotliDecoderStateReset; it is reused for the next
+     stream, if it is big enough. If |spare_ringbuffer_mapped| is set, it is
+     the start of a mirrored mapping. */
+  uint8_t* spare_ringbuffer;
+  int spare_ringbuffer_size;
 
   uint32_t num_literal_htrees;
   uint8_t* context_map;
@@ -329,9 +362,22 @@ struct BrotliDecoderStateStruct {
 
   const BrotliDictionary* dictionary;
   const BrotliTransforms* transforms;
+  BrotliDecoderCompoundDictionary compound_dictionary;
+
+  brotli_decoder_command_func command_func;
+  void* command_opaque;
+  /* Insert length of the command being decoded; reported with its copy. */
+  int command_insert_length;
 
   uint32_t trivial_literal_contexts[8];  /* 256 bits */
 
+  /* Literal tree |literal_pairs| is built for, or NULL. Pairs are decoded
+     only if |literal_pairs_useful| is set, i.e. tree is short enough. */
+  const HuffmanCode* literal_pairs_htree;
+  int literal_pairs_useful;
+  /* Allocated when the first pair table is built, as few streams need it. */
+  uint32_t* literal_pairs;
+
   union {
     BrotliMetablockHeaderArena header;
     BrotliMetablockBodyArena body;
@@ -344,6 +390,9 @@ typedef struct BrotliDecoderStateStruct BrotliDecoderStateInternal;
 BROTLI_INTERNAL BROTLI_BOOL BrotliDecoderStateInit(BrotliDecoderState* s,
     brotli_alloc_func alloc_func, brotli_free_func free_func, void* opaque);
 BROTLI_INTERNAL void BrotliDecoderStateCleanup(BrotliDecoderState* s);
+BROTLI_INTERNAL void BrotliDecoderStateReset(BrotliDecoderState* s);
+BROTLI_INTERNAL void BrotliDecoderStateFreeSpareRingBuffer(
+    BrotliDecoderState* s);
 BROTLI_INTERNAL void BrotliDecoderStateMetablockBegin(BrotliDecoderState* s);
 BROTLI_INTERNAL void BrotliDecoderStateCleanupAfterMetablock(
     BrotliDecoderState* s);
@@ -22,30 +22,6 @@
 extern "C" {
 #endif
 
-static BROTLI_INLINE size_t ComputeDistanceCode(size_t distance,
-                                                size_t max_distance,
-                                                const int* dist_cache) {
-  if (distance <= max_distance) {
-    size_t distance_plus_3 = distance + 3;
-    size_t offset0 = distance_plus_3 - (size_t)dist_cache[0];
-    size_t offset1 = distance_plus_3 - (size_t)dist_cache[1];
-    if (distance == (size_t)dist_cache[0]) {
-      return 0;
-    } else if (distance == (size_t)dist_cache[1]) {
-      return 1;
-    } else if (offset0 < 7) {
-      return (0x9750468 >> (4 * offset0)) & 0xF;
-    } else if (offset1 < 7) {
-      return (0xFDB1ACE >> (4 * offset1)) & 0xF;
-    } else if (distance == (size_t)dist_cache[2]) {
-      return 2;
-    } else if (distance == (size_t)dist_cache[3]) {
-      return 3;
-    }
-  }
-  return distance + BROTLI_NUM_DISTANCE_SHORT_CODES - 1;
-}
-
 #define EXPAND_CAT(a, b) CAT(a, b)
 #define CAT(a, b) a ## b
 #define FN(X) EXPAND_CAT(X, HASHER())
@@ -98,6 +74,11 @@ static BROTLI_INLINE size_t ComputeDistanceCode(size_t distance,
 #include "./backward_references_inc.h"
 #undef HASHER
 
+#define HASHER() H68
+/* NOLINTNEXTLINE(build/include) */
+#include "./backward_references_inc.h"
+#undef HASHER
+
 #define HASHER() H35
 /* NOLINTNEXTLINE(build/include) */
 #include "./backward_references_inc.h"
@@ -123,6 +104,7 @@ static BROTLI_INLINE size_t ComputeDistanceCode(size_t distance,
 void BrotliCreateBackwardReferences(size_t num_bytes,
     size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
     ContextLut literal_context_lut, const BrotliEncoderParams* params,
+    BROTLI_BOOL is_high_entropy,
     Hasher* hasher, int* dist_cache, size_t* last_insert_len,
     Command* commands, size_t* num_commands, size_t* num_literals) {
   switch (params->hasher.type) {
@@ -130,7 +112,8 @@ void BrotliCreateBackwardReferences(size_t num_bytes,
     case N:                                                       \
       CreateBackwardReferencesNH ## N(num_bytes,                  \
           position, ringbuffer, ringbuffer_mask,                  \
-          literal_context_lut, params, hasher, dist_cache,        \
+          literal_context_lut, params, is_high_entropy,           \
+          hasher, dist_cache,                                     \
           last_insert_len, commands, num_commands, num_literals); \
       return;
     FOR_GENERIC_HASHERS(CASE_)
@@ -22,6 +22,7 @@
 #include "./params.h"
 #include "./prefix.h"
 #include "./quality.h"
+#include "./worker.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
@@ -418,7 +419,7 @@ static size_t UpdateNodes(
   size_t min_len;
   size_t result = 0;
   size_t k;
-  size_t gap = 0;
+  size_t gap = params->compound.total_size;
 
   EvaluateNode(block_start + stream_offset, pos, max_backward_limit, gap,
       starting_dist_cache, model, queue, nodes);
@@ -517,7 +518,13 @@ static size_t UpdateNodes(
         uint32_t distextra;
         uint32_t distnumextra;
         float dist_cost;
-        size_t max_match_len;
+        size_t max_match_len = BackwardMatchLength(&match);
+        if (max_match_len > max_len) {
+          /* Matches are found for the whole block, but the search might be
+             limited to its range. Dictionary words could not be truncated. */
+          if (is_dictionary_match) continue;
+          max_match_len = max_len;
+        }
         PrefixEncodeCopyDistance(
             dist_code, params->dist.num_direct_distance_codes,
             params->dist.distance_postfix_bits, &dist_symbol, &distextra);
@@ -528,7 +535,6 @@ static size_t UpdateNodes(
         /* Try all copy lengths up until the maximum copy length corresponding
            to this distance. If the distance refers to the static dictionary, or
            the maximum length is long enough, try only one maximum length. */
-        max_match_len = BackwardMatchLength(&match);
         if (len < max_match_len &&
             (is_dictionary_match || max_match_len > max_zopfli_len)) {
           len = max_match_len;
@@ -577,7 +583,7 @@ void BrotliZopfliCreateCommands(const size_t num_bytes,
   size_t pos = 0;
   uint32_t offset = nodes[0].u.next;
   size_t i;
-  size_t gap = 0;
+  size_t gap = params->compound.total_size;
   for (i = 0; offset != BROTLI_UINT32_MAX; i++) {
     const ZopfliNode* next = &nodes[pos + offset];
     size_t copy_length = ZopfliNodeCopyLength(next);
@@ -653,6 +659,30 @@ static size_t ZopfliIterate(size_t num_bytes, size_t position,
   return ComputeShortestPathFromNodes(num_bytes, nodes);
 }
 
+/* Maximal number of matches in attached dictionaries reported for
+   a position. */
+#define MAX_NUM_COMPOUND_DICTIONARY_MATCHES 16
+
+/* Appends matches found in attached dictionaries, that are longer than the
+   longest of |num_matches| found |matches|. Returns new number of matches.
+   REQUIRES: there is room for MAX_NUM_COMPOUND_DICTIONARY_MATCHES more
+             items in |matches|. */
+static size_t AddCompoundDictionaryMatches(const BrotliEncoderParams* params,
+    const uint8_t* ringbuffer, size_t ringbuffer_mask, size_t pos,
+    size_t max_length, size_t dictionary_start, BackwardMatch* matches,
+    size_t num_matches) {
+  size_t min_length = 4;
+  if (num_matches != 0) {
+    min_length = BROTLI_MAX(size_t, min_length,
+        BackwardMatchLength(&matches[num_matches - 1]) + 1);
+  }
+  if (min_length > max_length) return num_matches;
+  return num_matches + LookupAllCompoundDictionaryMatches(&params->compound,
+      ringbuffer, ringbuffer_mask, pos, min_length, max_length,
+      dictionary_start, params->dist.max_distance, &matches[num_matches],
+      MAX_NUM_COMPOUND_DICTIONARY_MATCHES);
+}
+
 /* REQUIRES: nodes != NULL and len(nodes) >= num_bytes + 1 */
 size_t BrotliZopfliComputeShortestPath(MemoryManager* m, size_t num_bytes,
     size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
@@ -667,7 +697,7 @@ size_t BrotliZopfliComputeShortestPath(MemoryManager* m, size_t num_bytes,
   const size_t store_end = num_bytes >= StoreLookaheadH10() ?
       position + num_bytes - StoreLookaheadH10() + 1 : position;
   size_t i;
-  size_t gap = 0;
+  size_t gap = params->compound.total_size;
   size_t lz_matches_offset = 0;
   BROTLI_UNUSED(literal_context_lut);
   nodes[0].length = 0;
@@ -688,6 +718,11 @@ size_t BrotliZopfliComputeShortestPath(MemoryManager* m, size_t num_bytes,
         &params->dictionary,
         ringbuffer, ringbuffer_mask, pos, num_bytes - i, max_distance,
         dictionary_start + gap, params, &matches[lz_matches_offset]);
+    if (params->compound.num_chunks != 0) {
+      num_matches = AddCompoundDictionaryMatches(params, ringbuffer,
+          ringbuffer_mask, pos, num_bytes - i, dictionary_start,
+          &matches[lz_matches_offset], num_matches);
+    }
     if (num_matches > 0 &&
         BackwardMatchLength(&matches[num_matches - 1]) > max_zopfli_len) {
       matches[0] = matches[num_matches - 1];
@@ -719,50 +754,33 @@ size_t BrotliZopfliComputeShortestPath(MemoryManager* m, size_t num_bytes,
   return ComputeShortestPathFromNodes(num_bytes, nodes);
 }
 
-void BrotliCreateZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
-    size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
-    ContextLut literal_context_lut, const BrotliEncoderParams* params,
-    Hasher* hasher, int* dist_cache, size_t* last_insert_len,
-    Command* commands, size_t* num_commands, size_t* num_literals) {
-  ZopfliNode* nodes = BROTLI_ALLOC(m, ZopfliNode, num_bytes + 1);
-  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(nodes)) return;
-  BrotliInitZopfliNodes(nodes, num_bytes + 1);
-  *num_commands += BrotliZopfliComputeShortestPath(m, num_bytes,
-      position, ringbuffer, ringbuffer_mask, literal_context_lut, params,
-      dist_cache, hasher, nodes);
-  if (BROTLI_IS_OOM(m)) return;
-  BrotliZopfliCreateCommands(num_bytes, position, nodes, dist_cache,
-      last_insert_len, params, commands, num_literals);
-  BROTLI_FREE(m, nodes);
-}
-
-void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
+/* Matches of a block take at most ZOPFLI_MATCHES_PER_BYTE slots per byte,
+   plus the room for the matches of the position being searched. */
+#define ZOPFLI_MATCHES_PER_BYTE 4
+#define ZOPFLI_MATCHES_SIZE(NUM_BYTES) (ZOPFLI_MATCHES_PER_BYTE * (NUM_BYTES) + \
+    MAX_NUM_MATCHES_H10 + MAX_NUM_COMPOUND_DICTIONARY_MATCHES)
+
+/* Finds matches for all the positions of the block. Only the longest match is
+   kept for a position if it is long enough; positions covered by such a match
+   are not searched, but are added to the hasher. If |split_ranges| is set,
+   positions are not skipped past the range boundary, so that each range gets
+   its own matches. Only the longest match is kept as well, if otherwise the
+   rest of positions would not fit |matches|, that has ZOPFLI_MATCHES_SIZE
+   slots; that bounds the memory used by adversarial inputs. */
+static void ZopfliFindAllMatches(size_t num_bytes,
     size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
-    ContextLut literal_context_lut, const BrotliEncoderParams* params,
-    Hasher* hasher, int* dist_cache, size_t* last_insert_len,
-    Command* commands, size_t* num_commands, size_t* num_literals) {
+    const BrotliEncoderParams* params, BROTLI_BOOL split_ranges,
+    Hasher* hasher, uint32_t* num_matches, BackwardMatch* matches) {
   const size_t stream_offset = params->stream_offset;
   const size_t max_backward_limit = BROTLI_MAX_BACKWARD_LIMIT(params->lgwin);
-  uint32_t* num_matches = BROTLI_ALLOC(m, uint32_t, num_bytes);
-  size_t matches_size = 4 * num_bytes;
+  const size_t max_zopfli_len = MaxZopfliLen(params);
   const size_t store_end = num_bytes >= StoreLookaheadH10() ?
       position + num_bytes - StoreLookaheadH10() + 1 : position;
+  const size_t matches_limit = ZOPFLI_MATCHES_PER_BYTE * num_bytes;
   size_t cur_match_pos = 0;
   size_t i;
-  size_t orig_num_literals;
-  size_t orig_last_insert_len;
-  int orig_dist_cache[4];
-  size_t orig_num_commands;
-  ZopfliCostModel model;
-  ZopfliNode* nodes;
-  BackwardMatch* matches = BROTLI_ALLOC(m, BackwardMatch, matches_size);
-  size_t gap = 0;
+  size_t gap = params->compound.total_size;
   size_t shadow_matches = 0;
-  BROTLI_UNUSED(literal_context_lut);
-  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(num_matches) ||
-      BROTLI_IS_NULL(matches)) {
-    return;
-  }
   for (i = 0; i + HashTypeLengthH10() - 1 < num_bytes; ++i) {
     const size_t pos = position + i;
     size_t max_distance = BROTLI_MIN(size_t, pos, max_backward_limit);
@@ -772,15 +790,16 @@ void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
     size_t num_found_matches;
     size_t cur_match_end;
     size_t j;
-    /* Ensure that we have enough free slots. */
-    BROTLI_ENSURE_CAPACITY(m, BackwardMatch, matches, matches_size,
-        cur_match_pos + MAX_NUM_MATCHES_H10 + shadow_matches);
-    if (BROTLI_IS_OOM(m)) return;
     num_found_matches = FindAllMatchesH10(&hasher->privat._H10,
         &params->dictionary,
         ringbuffer, ringbuffer_mask, pos, max_length,
         max_distance, dictionary_start + gap, params,
         &matches[cur_match_pos + shadow_matches]);
+    if (params->compound.num_chunks != 0) {
+      num_found_matches = AddCompoundDictionaryMatches(params, ringbuffer,
+          ringbuffer_mask, pos, max_length, dictionary_start,
+          &matches[cur_match_pos + shadow_matches], num_found_matches);
+    }
     cur_match_end = cur_match_pos + num_found_matches;
     for (j = cur_match_pos; j + 1 < cur_match_end; ++j) {
       BROTLI_DCHECK(BackwardMatchLength(&matches[j]) <=
@@ -788,22 +807,287 @@ void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
     }
     num_matches[i] = (uint32_t)num_found_matches;
     if (num_found_matches > 0) {
-      const size_t match_len = BackwardMatchLength(&matches[cur_match_end - 1]);
-      if (match_len > MAX_ZOPFLI_LEN_QUALITY_11) {
-        const size_t skip = match_len - 1;
+      const size_t match_len =
+          BackwardMatchLength(&matches[cur_match_end - 1]);
+      if (match_len > max_zopfli_len) {
+        size_t skip = match_len - 1;
+        if (split_ranges) {
+          const size_t range_end = (i / ZOPFLI_RANGE_SIZE + 1) *
+              ZOPFLI_RANGE_SIZE;
+          skip = BROTLI_MIN(size_t, skip, range_end - i - 1);
+        }
         matches[cur_match_pos++] = matches[cur_match_end - 1];
         num_matches[i] = 1;
         /* Add the tail of the copy to the hasher. */
         StoreRangeH10(&hasher->privat._H10,
                       ringbuffer, ringbuffer_mask, pos + 1,
-                      BROTLI_MIN(size_t, pos + match_len, store_end));
+                      BROTLI_MIN(size_t, pos + skip + 1, store_end));
         memset(&num_matches[i + 1], 0, skip * sizeof(num_matches[0]));
         i += skip;
+      } else if (cur_match_end + (num_bytes - i - 1) > matches_limit) {
+        /* Leave a slot for each of the remaining positions. */
+        matches[cur_match_pos++] = matches[cur_match_end - 1];
+        num_matches[i] = 1;
       } else {
         cur_match_pos = cur_match_end;
       }
     }
   }
+  /* Trailing positions are not searched. */
+  for (; i < num_bytes; ++i) num_matches[i] = 0;
+}
+
+/* Matches shorter than this are taken for coincidences by sparse search. */
+#define MIN_SPARSE_MATCH_LENGTH 16
+
+size_t BrotliZopfliFindSparseMatch(size_t num_bytes, size_t position,
+    const uint8_t* ringbuffer, size_t ringbuffer_mask,
+    const BrotliEncoderParams* params, Hasher* hasher) {
+  const size_t max_backward_limit = BROTLI_MAX_BACKWARD_LIMIT(params->lgwin);
+  const size_t lookahead = StoreLookaheadH10();
+  const size_t store_end = num_bytes >= lookahead ?
+      position + num_bytes - lookahead + 1 : position;
+  size_t store_pos = (position + 15) & ~(size_t)15;
+  size_t pos;
+  /* Same strides as the sparse mode of greedy search; lookup stride is not a
+     multiple of 16, so repetitions are found, whatever the distance is. */
+  for (pos = position; pos < store_end; pos += 65) {
+    BackwardMatch matches[MAX_NUM_MATCHES_H10];
+    size_t best_len = 0;
+    for (; store_pos < pos; store_pos += 16) {
+      StoreH10(&hasher->privat._H10, ringbuffer, ringbuffer_mask, store_pos);
+    }
+    StoreAndFindMatchesH10(&hasher->privat._H10, ringbuffer, pos,
+        ringbuffer_mask, lookahead, BROTLI_MIN(size_t, pos, max_backward_limit),
+        &best_len, matches);
+    if (best_len >= MIN_SPARSE_MATCH_LENGTH) return pos - position + 1;
+    if (store_pos == pos) store_pos += 16;
+  }
+  for (; store_pos < store_end; store_pos += 16) {
+    StoreH10(&hasher->privat._H10, ringbuffer, ringbuffer_mask, store_pos);
+  }
+  return num_bytes;
+}
+
+#undef MIN_SPARSE_MATCH_LENGTH
+
+/* Part of the block, for which the shortest path is searched independently. */
+typedef struct ZopfliRange {
+  /* Offset of the range in the block. */
+  size_t start;
+  size_t size;
+  /* Index of the first match of the range. */
+  size_t match_offset;
+  /* Distance cache and pending literals at the beginning of the range; only
+     the first range knows them. */
+  int dist_cache[4];
+  size_t last_insert_len;
+  ZopfliCostModel model;
+  ZopfliNode* nodes;
+  /* Commands of the preliminary iterations. */
+  Command* commands;
+  size_t num_commands;
+} ZopfliRange;
+
+/* Ranges of the block that are processed concurrently. Matches are only read
+   and each range has its own nodes and cost model; memory manager is not
+   used, as it is not thread-safe. */
+typedef struct ZopfliRangeBatch {
+  size_t position;
+  const uint8_t* ringbuffer;
+  size_t ringbuffer_mask;
+  const BrotliEncoderParams* params;
+  const uint32_t* num_matches;
+  const BackwardMatch* matches;
+  int num_iterations;
+  ZopfliRange* ranges;
+} ZopfliRangeBatch;
+
+static void ZopfliIterateRange(void* context, size_t index) {
+  const ZopfliRangeBatch* batch = (const ZopfliRangeBatch*)context;
+  ZopfliRange* range = &batch->ranges[index];
+  const size_t position = batch->position + range->start;
+  int i;
+  for (i = 0; i < batch->num_iterations; ++i) {
+    if (i == 0) {
+      ZopfliCostModelSetFromLiteralCosts(&range->model, position,
+          batch->ringbuffer, batch->ringbuffer_mask);
+    } else {
+      int dist_cache[4];
+      size_t last_insert_len = range->last_insert_len;
+      size_t num_literals = 0;
+      memcpy(dist_cache, range->dist_cache, sizeof(dist_cache));
+      BrotliZopfliCreateCommands(range->size, position, range->nodes,
+          dist_cache, &last_insert_len, batch->params, range->commands,
+          &num_literals);
+      ZopfliCostModelSetFromCommands(&range->model, position,
+          batch->ringbuffer, batch->ringbuffer_mask, range->commands,
+          range->num_commands, range->last_insert_len);
+    }
+    BrotliInitZopfliNodes(range->nodes, range->size + 1);
+    range->num_commands = ZopfliIterate(range->size, position,
+        batch->ringbuffer, batch->ringbuffer_mask, batch->params,
+        batch->params->compound.total_size, range->dist_cache, &range->model,
+        &batch->num_matches[range->start], &batch->matches[range->match_offset],
+        range->nodes);
+  }
+}
+
+/* Splits the block into ranges of ZOPFLI_RANGE_SIZE and searches for the
+   shortest path in each of them, using up to |params|->zopfli_threads
+   threads. Splitting is done by every segment encoder, even if it has only
+   one thread, so that the output does not depend on the number of threads.
+   The first iteration uses literal costs, subsequent ones use statistics of
+   the commands found in the range by the previous iteration. Ranges (except
+   the first one) start with unknown distance cache. */
+static void ZopfliIterateRanges(MemoryManager* m, size_t num_bytes,
+    size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
+    const BrotliEncoderParams* params, int num_iterations,
+    const uint32_t* num_matches, const BackwardMatch* matches,
+    int* dist_cache, size_t* last_insert_len, Command* commands,
+    size_t* num_commands, size_t* num_literals) {
+  const size_t num_ranges =
+      (num_bytes + ZOPFLI_RANGE_SIZE - 1) / ZOPFLI_RANGE_SIZE;
+  const size_t max_range_commands = ZOPFLI_RANGE_SIZE / 2 + 1;
+  ZopfliRange* ranges = BROTLI_ALLOC(m, ZopfliRange, num_ranges);
+  ZopfliNode* nodes = BROTLI_ALLOC(m, ZopfliNode, num_bytes + num_ranges);
+  Command* range_commands = NULL;
+  ZopfliRangeBatch batch;
+  size_t match_offset = 0;
+  size_t block_num_commands = 0;
+  size_t i;
+  size_t j;
+  if (num_iterations > 1) {
+    range_commands =
+        BROTLI_ALLOC(m, Command, num_ranges * max_range_commands);
+  }
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(ranges) || BROTLI_IS_NULL(nodes) ||
+      (num_iterations > 1 && BROTLI_IS_NULL(range_commands))) {
+    return;
+  }
+  for (i = 0; i < num_ranges; ++i) {
+    ZopfliRange* range = &ranges[i];
+    range->start = i * ZOPFLI_RANGE_SIZE;
+    range->size =
+        BROTLI_MIN(size_t, ZOPFLI_RANGE_SIZE, num_bytes - range->start);
+    range->match_offset = match_offset;
+    if (i == 0) {
+      memcpy(range->dist_cache, dist_cache, sizeof(range->dist_cache));
+      range->last_insert_len = *last_insert_len;
+    } else {
+      /* Poisoned values make short codes that refer to them invalid. */
+      for (j = 0; j < 4; ++j) range->dist_cache[j] = -16;
+      range->last_insert_len = 0;
+    }
+    range->nodes = &nodes[range->start + i];
+    range->commands = range_commands ?
+        &range_commands[i * max_range_commands] : NULL;
+    range->num_commands = 0;
+    InitZopfliCostModel(m, &range->model, &params->dist, range->size);
+    if (BROTLI_IS_OOM(m)) return;
+    for (j = 0; j < range->size; ++j) {
+      match_offset += num_matches[range->start + j];
+    }
+  }
+
+  batch.position = position;
+  batch.ringbuffer = ringbuffer;
+  batch.ringbuffer_mask = ringbuffer_mask;
+  batch.params = params;
+  batch.num_matches = num_matches;
+  batch.matches = matches;
+  batch.num_iterations = num_iterations;
+  batch.ranges = ranges;
+  BrotliRunWorkers(ZopfliIterateRange, &batch, num_ranges,
+                   params->zopfli_threads);
+
+  /* Commands are emitted sequentially, with actual distance cache. */
+  for (i = 0; i < num_ranges; ++i) {
+    ZopfliRange* range = &ranges[i];
+    BrotliZopfliCreateCommands(range->size, position + range->start,
+        range->nodes, dist_cache, last_insert_len, params,
+        &commands[block_num_commands], num_literals);
+    block_num_commands += range->num_commands;
+    CleanupZopfliCostModel(m, &range->model);
+  }
+  *num_commands += block_num_commands;
+  BROTLI_FREE(m, range_commands);
+  BROTLI_FREE(m, nodes);
+  BROTLI_FREE(m, ranges);
+}
+
+void BrotliCreateZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
+    size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
+    ContextLut literal_context_lut, const BrotliEncoderParams* params,
+    Hasher* hasher, int* dist_cache, size_t* last_insert_len,
+    Command* commands, size_t* num_commands, size_t* num_literals) {
+  const BROTLI_BOOL split_ranges = TO_BROTLI_BOOL(
+      params->zopfli_threads != 0 && num_bytes > ZOPFLI_RANGE_SIZE);
+  ZopfliNode* nodes;
+  if (split_ranges) {
+    uint32_t* num_matches = BROTLI_ALLOC(m, uint32_t, num_bytes);
+    BackwardMatch* matches =
+        BROTLI_ALLOC(m, BackwardMatch, ZOPFLI_MATCHES_SIZE(num_bytes));
+    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(num_matches) ||
+        BROTLI_IS_NULL(matches)) {
+      return;
+    }
+    ZopfliFindAllMatches(num_bytes, position, ringbuffer, ringbuffer_mask,
+        params, split_ranges, hasher, num_matches, matches);
+    ZopfliIterateRanges(m, num_bytes, position, ringbuffer, ringbuffer_mask,
+        params, 1, num_matches, matches, dist_cache, last_insert_len,
+        commands, num_commands, num_literals);
+    if (BROTLI_IS_OOM(m)) return;
+    BROTLI_FREE(m, matches);
+    BROTLI_FREE(m, num_matches);
+    return;
+  }
+  nodes = BROTLI_ALLOC(m, ZopfliNode, num_bytes + 1);
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(nodes)) return;
+  BrotliInitZopfliNodes(nodes, num_bytes + 1);
+  *num_commands += BrotliZopfliComputeShortestPath(m, num_bytes,
+      position, ringbuffer, ringbuffer_mask, literal_context_lut, params,
+      dist_cache, hasher, nodes);
+  if (BROTLI_IS_OOM(m)) return;
+  BrotliZopfliCreateCommands(num_bytes, position, nodes, dist_cache,
+      last_insert_len, params, commands, num_literals);
+  BROTLI_FREE(m, nodes);
+}
+
+void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
+    size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
+    ContextLut literal_context_lut, const BrotliEncoderParams* params,
+    Hasher* hasher, int* dist_cache, size_t* last_insert_len,
+    Command* commands, size_t* num_commands, size_t* num_literals) {
+  const BROTLI_BOOL split_ranges = TO_BROTLI_BOOL(
+      params->zopfli_threads != 0 && num_bytes > ZOPFLI_RANGE_SIZE);
+  uint32_t* num_matches = BROTLI_ALLOC(m, uint32_t, num_bytes);
+  size_t i;
+  size_t orig_num_literals;
+  size_t orig_last_insert_len;
+  int orig_dist_cache[4];
+  size_t orig_num_commands;
+  ZopfliCostModel model;
+  ZopfliNode* nodes;
+  BackwardMatch* matches =
+      BROTLI_ALLOC(m, BackwardMatch, ZOPFLI_MATCHES_SIZE(num_bytes));
+  size_t gap = params->compound.total_size;
+  BROTLI_UNUSED(literal_context_lut);
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(num_matches) ||
+      BROTLI_IS_NULL(matches)) {
+    return;
+  }
+  ZopfliFindAllMatches(num_bytes, position, ringbuffer, ringbuffer_mask,
+      params, split_ranges, hasher, num_matches, matches);
+  if (split_ranges) {
+    ZopfliIterateRanges(m, num_bytes, position, ringbuffer, ringbuffer_mask,
+        params, 2, num_matches, matches, dist_cache, last_insert_len,
+        commands, num_commands, num_literals);
+    if (BROTLI_IS_OOM(m)) return;
+    BROTLI_FREE(m, matches);
+    BROTLI_FREE(m, num_matches);
+    return;
+  }
   orig_num_literals = *num_literals;
   orig_last_insert_len = *last_insert_len;
   memcpy(orig_dist_cache, dist_cache, 4 * sizeof(dist_cache[0]));
@@ -838,6 +1122,28 @@ void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m, size_t num_bytes,
   BROTLI_FREE(m, num_matches);
 }
 
+size_t BrotliZopfliMemoryUsage(const BrotliEncoderParams* params,
+                               size_t num_bytes) {
+  const size_t num_ranges =
+      (num_bytes + ZOPFLI_RANGE_SIZE - 1) / ZOPFLI_RANGE_SIZE;
+  const size_t model_size =
+      sizeof(float) * (2 + params->dist.alphabet_size_limit);
+  size_t result = sizeof(ZopfliNode) * (num_bytes + num_ranges) +
+      sizeof(float) * num_bytes + num_ranges * model_size;
+  if (params->quality >= HQ_ZOPFLIFICATION_QUALITY ||
+      params->zopfli_threads != 0) {
+    result += sizeof(uint32_t) * num_bytes +
+        sizeof(BackwardMatch) * ZOPFLI_MATCHES_SIZE(num_bytes);
+  }
+  if (params->zopfli_threads != 0 && num_bytes > ZOPFLI_RANGE_SIZE) {
+    result += num_ranges * sizeof(ZopfliRange);
+    if (params->quality >= HQ_ZOPFLIFICATION_QUALITY) {
+      result += num_ranges * (ZOPFLI_RANGE_SIZE / 2 + 1) * sizeof(Command);
+    }
+  }
+  return result;
+}
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
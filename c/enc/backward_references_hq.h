@@ -37,6 +37,22 @@ BROTLI_INTERNAL void BrotliCreateHqZopfliBackwardReferences(MemoryManager* m,
     Hasher* hasher, int* dist_cache, size_t* last_insert_len,
     Command* commands, size_t* num_commands, size_t* num_literals);
 
+/* Searches high-entropy block for repetitions of earlier data: only
+   positions aligned to 16 are stored in the hasher and lookups are made every
+   65 bytes. Returns the length of the block prefix that should be stored as
+   literals: up to and including the position, where a long enough match is
+   found, or the whole block. Positions of this prefix are already stored in
+   the hasher; H10 requires positions to be stored in increasing order, so the
+   rest of the block should be parsed as usual, but not the prefix. */
+BROTLI_INTERNAL size_t BrotliZopfliFindSparseMatch(size_t num_bytes,
+    size_t position, const uint8_t* ringbuffer, size_t ringbuffer_mask,
+    const BrotliEncoderParams* params, Hasher* hasher);
+
+/* Returns the upper bound of memory allocated by optimal parsing of the
+   |num_bytes| long block. */
+BROTLI_INTERNAL size_t BrotliZopfliMemoryUsage(
+    const BrotliEncoderParams* params, size_t num_bytes);
+
 typedef struct ZopfliNode {
   /* Best length to get up to this byte (not including this byte itself)
      highest 7 bit is used to reconstruct the length code. */
@@ -11,6 +11,7 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
     size_t num_bytes, size_t position,
     const uint8_t* ringbuffer, size_t ringbuffer_mask,
     ContextLut literal_context_lut, const BrotliEncoderParams* params,
+    BROTLI_BOOL is_high_entropy,
     Hasher* hasher, int* dist_cache, size_t* last_insert_len,
     Command* commands, size_t* num_commands, size_t* num_literals) {
   HASHER()* privat = &hasher->privat.FN(_);
@@ -28,7 +29,8 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
   const size_t random_heuristics_window_size =
       LiteralSpreeLengthForSparseSearch(params);
   size_t apply_random_heuristics = position + random_heuristics_window_size;
-  const size_t gap = 0;
+  /* Attached dictionaries are placed right before the stream. */
+  const size_t gap = params->compound.total_size;
 
   /* Minimum score to accept a backward reference. */
   const score_t kMinScore = BROTLI_SCORE_BASE + 100;
@@ -47,9 +49,21 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
     sr.len_code_delta = 0;
     sr.distance = 0;
     sr.score = kMinScore;
+    /* Request the bucket of an upcoming position; its cache miss overlaps
+       with the match search for the current one. */
+    if (position + BROTLI_HASHER_PREFETCH_DISTANCE + FN(HashTypeLength)() <
+        pos_end) {
+      FN(PrefetchBucket)(privat, ringbuffer, ringbuffer_mask,
+                         position + BROTLI_HASHER_PREFETCH_DISTANCE);
+    }
     FN(FindLongestMatch)(privat, &params->dictionary,
         ringbuffer, ringbuffer_mask, dist_cache, position, max_length,
         max_distance, dictionary_start + gap, params->dist.max_distance, &sr);
+    if (params->compound.num_chunks != 0) {
+      LookupCompoundDictionaryMatch(&params->compound, ringbuffer,
+          ringbuffer_mask, dist_cache, position, max_length,
+          dictionary_start, params->dist.max_distance, &sr);
+    }
     if (sr.score > kMinScore) {
       /* Found a match. Let's look for something even better ahead. */
       int delayed_backward_references_in_row = 0;
@@ -70,6 +84,11 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
             ringbuffer, ringbuffer_mask, dist_cache, position + 1, max_length,
             max_distance, dictionary_start + gap, params->dist.max_distance,
             &sr2);
+        if (params->compound.num_chunks != 0) {
+          LookupCompoundDictionaryMatch(&params->compound, ringbuffer,
+              ringbuffer_mask, dist_cache, position + 1, max_length,
+              dictionary_start, params->dist.max_distance, &sr2);
+        }
         if (sr2.score >= sr.score + cost_diff_lazy) {
           /* Ok, let's just write one byte for now and start a match from the
              next byte. */
@@ -85,6 +104,7 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
       }
       apply_random_heuristics =
           position + 2 * sr.len + random_heuristics_window_size;
+      is_high_entropy = BROTLI_FALSE;
       dictionary_start = BROTLI_MIN(size_t,
           position + position_offset, max_backward_limit);
       {
@@ -126,7 +146,23 @@ static BROTLI_NOINLINE void EXPORT_FN(CreateBackwardReferences)(
          match lookups. Unsuccessful match lookups are very very expensive
          and this kind of a heuristic speeds up compression quite
          a lot. */
-      if (position > apply_random_heuristics) {
+      if (is_high_entropy) {
+        /* Sampled literals look random; until the first match is found,
+           store only hashes of positions aligned to 16 and look up even less
+           often. Lookup stride is not a multiple of 16, so repetitions of
+           such data are still found, whatever the distance is. */
+        const size_t kMargin = BROTLI_MAX(size_t, FN(StoreLookahead)() - 1, 2);
+        const size_t pos_jump =
+            BROTLI_MIN(size_t, position + 64, pos_end - kMargin);
+        size_t store_pos = (position + 15) & ~(size_t)15;
+        for (; store_pos < pos_jump; store_pos += 16) {
+          FN(Store)(privat, ringbuffer, ringbuffer_mask, store_pos);
+        }
+        if (position < pos_jump) {
+          insert_length += pos_jump - position;
+          position = pos_jump;
+        }
+      } else if (position > apply_random_heuristics) {
         /* Going through uncompressible data, jump. */
         if (position >
             apply_random_heuristics + 4 * random_heuristics_window_size) {
@@ -56,6 +56,15 @@ BROTLI_INTERNAL double BrotliPopulationCostLiteral(const HistogramLiteral*);
 BROTLI_INTERNAL double BrotliPopulationCostCommand(const HistogramCommand*);
 BROTLI_INTERNAL double BrotliPopulationCostDistance(const HistogramDistance*);
 
+/* Same as BrotliPopulationCost*, but may stop early and return any value that
+   is not less than "limit" once the cost is known to reach it. */
+BROTLI_INTERNAL double BrotliPopulationCostWithLimitLiteral(
+    const HistogramLiteral*, double limit);
+BROTLI_INTERNAL double BrotliPopulationCostWithLimitCommand(
+    const HistogramCommand*, double limit);
+BROTLI_INTERNAL double BrotliPopulationCostWithLimitDistance(
+    const HistogramDistance*, double limit);
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
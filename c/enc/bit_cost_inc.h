@@ -9,7 +9,8 @@
 
 #define HistogramType FN(Histogram)
 
-double FN(BrotliPopulationCost)(const HistogramType* histogram) {
+double FN(BrotliPopulationCostWithLimit)(const HistogramType* histogram,
+                                         double limit) {
   static const double kOneSymbolHistogramCost = 12;
   static const double kTwoSymbolHistogramCost = 20;
   static const double kThreeSymbolHistogramCost = 28;
@@ -81,6 +82,10 @@ double FN(BrotliPopulationCost)(const HistogramType* histogram) {
         /* Approximate the bit depth by round(-log2(P(symbol))) */
         size_t depth = (size_t)(log2p + 0.5);
         bits += histogram->data_[i] * log2p;
+        if (bits >= limit) {
+          /* The remaining terms are non-negative. */
+          return bits;
+        }
         if (depth > 15) {
           depth = 15;
         }
@@ -124,4 +129,8 @@ double FN(BrotliPopulationCost)(const HistogramType* histogram) {
   return bits;
 }
 
+double FN(BrotliPopulationCost)(const HistogramType* histogram) {
+  return FN(BrotliPopulationCostWithLimit)(histogram, 1e99);
+}
+
 #undef HistogramType
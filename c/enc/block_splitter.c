@@ -19,6 +19,10 @@
 #include "./memory.h"
 #include "./quality.h"
 
+#if defined(BROTLI_TARGET_SSE2)
+#include <emmintrin.h>
+#endif
+
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
 #endif
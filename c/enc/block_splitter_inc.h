@@ -74,6 +74,9 @@ static size_t FN(FindBlocks)(const DataType* data, const size_t length,
   const size_t data_size = FN(HistogramDataSize)();
   const size_t bitmaplen = (num_histograms + 7) >> 3;
   size_t num_blocks = 1;
+  double min_cost = 0.0;
+  /* Nothing is capped at the first position. */
+  double block_switch_cost = 1e99;
   size_t i;
   size_t j;
   BROTLI_DCHECK(num_histograms <= 256);
@@ -98,37 +101,52 @@ static size_t FN(FindBlocks)(const DataType* data, const size_t length,
   memset(switch_signal, 0, sizeof(switch_signal[0]) * length * bitmaplen);
   /* After each iteration of this loop, cost[k] will contain the difference
      between the minimum cost of arriving at the current byte position using
-     entropy code k, and the minimum cost of arriving at the current byte
-     position. This difference is capped at the block switch cost, and if it
+     entropy code k, and the minimum cost of arriving at the previous byte
+     position. Before adding the cost of the current symbol, the difference
+     to the previous minimum is capped at the block switch cost, and if it
      reaches block switch cost, it means that when we trace back from the last
-     position, we need to switch here. */
+     position, we need to switch at the previous position. */
   for (i = 0; i < length; ++i) {
-    const size_t byte_ix = i;
-    size_t ix = byte_ix * bitmaplen;
-    size_t insert_cost_ix = data[byte_ix] * num_histograms;
-    double min_cost = 1e99;
-    double block_switch_cost = block_switch_bitcost;
-    size_t k;
-    for (k = 0; k < num_histograms; ++k) {
-      /* We are coding the symbol in data[byte_ix] with entropy code k. */
-      cost[k] += insert_cost[insert_cost_ix + k];
-      if (cost[k] < min_cost) {
-        min_cost = cost[k];
-        block_id[byte_ix] = (uint8_t)k;
+    const double* symbol_cost = &insert_cost[data[i] * num_histograms];
+    uint8_t* signal = &switch_signal[(i == 0 ? 0 : i - 1) * bitmaplen];
+    double next_min_cost = 1e99;
+    size_t k = 0;
+#if defined(BROTLI_TARGET_SSE2)
+    {
+      const __m128d prev_min = _mm_set1_pd(min_cost);
+      const __m128d cap = _mm_set1_pd(block_switch_cost);
+      __m128d next_min = _mm_set1_pd(next_min_cost);
+      for (; k + 2 <= num_histograms; k += 2) {
+        __m128d c = _mm_sub_pd(_mm_loadu_pd(&cost[k]), prev_min);
+        const __m128d capped = _mm_cmpge_pd(c, cap);
+        c = _mm_or_pd(_mm_and_pd(capped, cap), _mm_andnot_pd(capped, c));
+        signal[k >> 3] |= (uint8_t)(_mm_movemask_pd(capped) << (k & 7));
+        c = _mm_add_pd(c, _mm_loadu_pd(&symbol_cost[k]));
+        _mm_storeu_pd(&cost[k], c);
+        next_min = _mm_min_pd(next_min, c);
       }
+      next_min = _mm_min_pd(next_min, _mm_unpackhi_pd(next_min, next_min));
+      _mm_store_sd(&next_min_cost, next_min);
     }
-    /* More blocks for the beginning. */
-    if (byte_ix < 2000) {
-      block_switch_cost *= 0.77 + 0.07 * (double)byte_ix / 2000;
-    }
-    for (k = 0; k < num_histograms; ++k) {
-      cost[k] -= min_cost;
-      if (cost[k] >= block_switch_cost) {
-        const uint8_t mask = (uint8_t)(1u << (k & 7));
-        cost[k] = block_switch_cost;
-        BROTLI_DCHECK((k >> 3) < bitmaplen);
-        switch_signal[ix + (k >> 3)] |= mask;
+#endif
+    for (; k < num_histograms; ++k) {
+      double c = cost[k] - min_cost;
+      if (c >= block_switch_cost) {
+        c = block_switch_cost;
+        signal[k >> 3] |= (uint8_t)(1u << (k & 7));
       }
+      /* We are coding the symbol in data[i] with entropy code k. */
+      c += symbol_cost[k];
+      cost[k] = c;
+      if (c < next_min_cost) next_min_cost = c;
+    }
+    for (k = 0; cost[k] != next_min_cost; ++k) {}
+    block_id[i] = (uint8_t)k;
+    min_cost = next_min_cost;
+    block_switch_cost = block_switch_bitcost;
+    /* More blocks for the beginning. */
+    if (i < 2000) {
+      block_switch_cost *= 0.77 + 0.07 * (double)i / 2000;
     }
   }
   {  /* Trace back from the last position and switch at the marked places. */
@@ -314,11 +332,11 @@ static void FN(ClusterBlocks)(MemoryManager* m,
         FN(HistogramAdd)(&histo, data[pos++]);
       }
       best_out = (i == 0) ? histogram_symbols[0] : histogram_symbols[i - 1];
-      best_bits =
-          FN(BrotliHistogramBitCostDistance)(&histo, &all_histograms[best_out]);
+      best_bits = FN(BrotliHistogramBitCostDistance)(
+          &histo, &all_histograms[best_out], 1e99);
       for (j = 0; j < num_final_clusters; ++j) {
         const double cur_bits = FN(BrotliHistogramBitCostDistance)(
-            &histo, &all_histograms[clusters[j]]);
+            &histo, &all_histograms[clusters[j]], best_bits);
         if (cur_bits < best_bits) {
           best_bits = cur_bits;
           best_out = clusters[j];
@@ -1286,8 +1286,9 @@ void BrotliStoreUncompressedMetaBlock(BROTLI_BOOL is_final_block,
   BrotliStoreUncompressedMetaBlockHeader(len, storage_ix, storage);
   JumpToByteBoundary(storage_ix, storage);
 
-  if (masked_pos + len > mask + 1) {
-    size_t len1 = mask + 1 - masked_pos;
+  /* "mask + 1" would overflow for the all-ones mask of one-shot input. */
+  if (len != 0 && len - 1 > mask - masked_pos) {
+    size_t len1 = mask - masked_pos + 1;
     memcpy(&storage[*storage_ix >> 3], &input[masked_pos], len1);
     *storage_ix += len1 << 3;
     len -= len1;
@@ -27,6 +27,72 @@ static BROTLI_INLINE BROTLI_BOOL HistogramPairIsLess(
   return TO_BROTLI_BOOL((p1->idx2 - p1->idx1) > (p2->idx2 - p2->idx1));
 }
 
+/* Histogram pairs are kept in a binary heap with the best pair (the one that
+   no other pair is less than) on top. Pairs are invalidated lazily: once one
+   of the clusters is merged away (its size becomes 0) or grows, the pair no
+   longer matches the cluster sizes it was evaluated with. Pairs that are
+   equal by HistogramPairIsLess are taken in heap order, not in the order they
+   were pushed. */
+static BROTLI_INLINE BROTLI_BOOL HistogramPairIsValid(
+    const HistogramPair* p, const uint32_t* cluster_size) {
+  return TO_BROTLI_BOOL(cluster_size[p->idx1] != 0 &&
+      cluster_size[p->idx2] != 0 &&
+      cluster_size[p->idx1] + cluster_size[p->idx2] == p->size_combo);
+}
+
+static BROTLI_INLINE void HistogramPairSiftUp(HistogramPair* heap, size_t i) {
+  HistogramPair p = heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) >> 1;
+    if (!HistogramPairIsLess(&heap[parent], &p)) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = p;
+}
+
+static BROTLI_INLINE void HistogramPairSiftDown(
+    HistogramPair* heap, size_t size, size_t i) {
+  HistogramPair p = heap[i];
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= size) break;
+    if (child + 1 < size &&
+        HistogramPairIsLess(&heap[child], &heap[child + 1])) {
+      ++child;
+    }
+    if (!HistogramPairIsLess(&p, &heap[child])) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = p;
+}
+
+/* Removes invalid pairs from the top of the heap. */
+static BROTLI_INLINE void HistogramPairPopInvalid(HistogramPair* heap,
+    size_t* size, const uint32_t* cluster_size) {
+  while (*size > 0 && !HistogramPairIsValid(&heap[0], cluster_size)) {
+    heap[0] = heap[--(*size)];
+    if (*size > 0) HistogramPairSiftDown(heap, *size, 0);
+  }
+}
+
+/* Removes all invalid pairs and rebuilds the heap. Returns the new size. */
+static BROTLI_INLINE size_t HistogramPairPrune(HistogramPair* heap,
+    size_t size, const uint32_t* cluster_size) {
+  size_t copy_to_idx = 0;
+  size_t i;
+  for (i = 0; i < size; ++i) {
+    if (HistogramPairIsValid(&heap[i], cluster_size)) {
+      heap[copy_to_idx++] = heap[i];
+    }
+  }
+  for (i = copy_to_idx / 2; i > 0; --i) {
+    HistogramPairSiftDown(heap, copy_to_idx, i - 1);
+  }
+  return copy_to_idx;
+}
+
 /* Returns entropy reduction of the context map when we combine two clusters. */
 static BROTLI_INLINE double ClusterCostDiff(size_t size_a, size_t size_b) {
   size_t size_c = size_a + size_b;
@@ -21,6 +21,8 @@ extern "C" {
 typedef struct HistogramPair {
   uint32_t idx1;
   uint32_t idx2;
+  /* Sum of the cluster sizes when the pair was evaluated. */
+  uint32_t size_combo;
   double cost_combo;
   double cost_diff;
 } HistogramPair;
@@ -10,14 +10,15 @@
 #define HistogramType FN(Histogram)
 
 /* Computes the bit cost reduction by combining out[idx1] and out[idx2] and if
-   it is below a threshold, stores the pair (idx1, idx2) in the *pairs queue. */
+   it is below a threshold, stores the pair (idx1, idx2) in the *pairs queue.
+   The top of the queue must be a valid pair. */
 BROTLI_INTERNAL void FN(BrotliCompareAndPushToQueue)(
     const HistogramType* out, const uint32_t* cluster_size, uint32_t idx1,
     uint32_t idx2, size_t max_num_pairs, HistogramPair* pairs,
     size_t* num_pairs) CODE({
   BROTLI_BOOL is_good_pair = BROTLI_FALSE;
   HistogramPair p;
-  p.idx1 = p.idx2 = 0;
+  p.idx1 = p.idx2 = p.size_combo = 0;
   p.cost_diff = p.cost_combo = 0;
   if (idx1 == idx2) {
     return;
@@ -29,6 +30,7 @@ BROTLI_INTERNAL void FN(BrotliCompareAndPushToQueue)(
   }
   p.idx1 = idx1;
   p.idx2 = idx2;
+  p.size_combo = cluster_size[idx1] + cluster_size[idx2];
   p.cost_diff = 0.5 * ClusterCostDiff(cluster_size[idx1], cluster_size[idx2]);
   p.cost_diff -= out[idx1].bit_cost_;
   p.cost_diff -= out[idx2].bit_cost_;
@@ -45,7 +47,8 @@ BROTLI_INTERNAL void FN(BrotliCompareAndPushToQueue)(
     HistogramType combo = out[idx1];
     double cost_combo;
     FN(HistogramAddHistogram)(&combo, &out[idx2]);
-    cost_combo = FN(BrotliPopulationCost)(&combo);
+    cost_combo =
+        FN(BrotliPopulationCostWithLimit)(&combo, threshold - p.cost_diff);
     if (cost_combo < threshold - p.cost_diff) {
       p.cost_combo = cost_combo;
       is_good_pair = BROTLI_TRUE;
@@ -53,16 +56,13 @@ BROTLI_INTERNAL void FN(BrotliCompareAndPushToQueue)(
   }
   if (is_good_pair) {
     p.cost_diff += p.cost_combo;
-    if (*num_pairs > 0 && HistogramPairIsLess(&pairs[0], &p)) {
-      /* Replace the top of the queue if needed. */
-      if (*num_pairs < max_num_pairs) {
-        pairs[*num_pairs] = pairs[0];
-        ++(*num_pairs);
-      }
-      pairs[0] = p;
-    } else if (*num_pairs < max_num_pairs) {
+    if (*num_pairs < max_num_pairs) {
       pairs[*num_pairs] = p;
+      HistogramPairSiftUp(pairs, *num_pairs);
       ++(*num_pairs);
+    } else if (*num_pairs > 0 && HistogramPairIsLess(&pairs[0], &p)) {
+      /* The queue is full; the new best pair replaces the top. */
+      pairs[0] = p;
     }
   }
 })
@@ -81,8 +81,8 @@ BROTLI_INTERNAL size_t FN(BrotliHistogramCombine)(HistogramType* out,
   size_t num_pairs = 0;
 
   {
-    /* We maintain a vector of histogram pairs, with the property that the pair
-       with the maximum bit cost reduction is the first. */
+    /* We maintain a heap of histogram pairs, with the pair with the maximum
+       bit cost reduction on top. */
     size_t idx1;
     for (idx1 = 0; idx1 < num_clusters; ++idx1) {
       size_t idx2;
@@ -108,6 +108,7 @@ BROTLI_INTERNAL size_t FN(BrotliHistogramCombine)(HistogramType* out,
     FN(HistogramAddHistogram)(&out[best_idx1], &out[best_idx2]);
     out[best_idx1].bit_cost_ = pairs[0].cost_combo;
     cluster_size[best_idx1] += cluster_size[best_idx2];
+    cluster_size[best_idx2] = 0;
     for (i = 0; i < symbols_size; ++i) {
       if (symbols[i] == best_idx2) {
         symbols[i] = best_idx1;
@@ -121,27 +122,13 @@ BROTLI_INTERNAL size_t FN(BrotliHistogramCombine)(HistogramType* out,
       }
     }
     --num_clusters;
-    {
-      /* Remove pairs intersecting the just combined best pair. */
-      size_t copy_to_idx = 0;
-      for (i = 0; i < num_pairs; ++i) {
-        HistogramPair* p = &pairs[i];
-        if (p->idx1 == best_idx1 || p->idx2 == best_idx1 ||
-            p->idx1 == best_idx2 || p->idx2 == best_idx2) {
-          /* Remove invalid pair from the queue. */
-          continue;
-        }
-        if (HistogramPairIsLess(&pairs[0], p)) {
-          /* Replace the top of the queue if needed. */
-          HistogramPair front = pairs[0];
-          pairs[0] = *p;
-          pairs[copy_to_idx] = front;
-        } else {
-          pairs[copy_to_idx] = *p;
-        }
-        ++copy_to_idx;
-      }
-      num_pairs = copy_to_idx;
+    /* Pairs intersecting the just combined best pair are now invalid. They
+       are dropped when they reach the top of the heap, or all at once when
+       the new pairs might not fit. */
+    if (num_pairs + num_clusters > max_num_pairs) {
+      num_pairs = HistogramPairPrune(pairs, num_pairs, cluster_size);
+    } else {
+      HistogramPairPopInvalid(pairs, &num_pairs, cluster_size);
     }
 
     /* Push new pairs formed with the combined histogram to the heap. */
@@ -153,15 +140,23 @@ BROTLI_INTERNAL size_t FN(BrotliHistogramCombine)(HistogramType* out,
   return num_clusters;
 })
 
-/* What is the bit cost of moving histogram from cur_symbol to candidate. */
+/* What is the bit cost of moving histogram from cur_symbol to candidate.
+   Result is exact if it is less than "limit"; otherwise it is some value that
+   is not less than "limit". */
 BROTLI_INTERNAL double FN(BrotliHistogramBitCostDistance)(
-    const HistogramType* histogram, const HistogramType* candidate) CODE({
+    const HistogramType* histogram, const HistogramType* candidate,
+    double limit) CODE({
   if (histogram->total_count_ == 0) {
     return 0.0;
   } else {
     HistogramType tmp = *histogram;
+    /* One bit of slack keeps the early exit clear of rounding in the
+       subtraction below, so that comparisons with "limit" are the same as
+       for the full cost. */
+    double cost_limit = limit + candidate->bit_cost_ + 1.0;
     FN(HistogramAddHistogram)(&tmp, candidate);
-    return FN(BrotliPopulationCost)(&tmp) - candidate->bit_cost_;
+    return FN(BrotliPopulationCostWithLimit)(&tmp, cost_limit) -
+        candidate->bit_cost_;
   }
 })
 
@@ -176,11 +171,11 @@ BROTLI_INTERNAL void FN(BrotliHistogramRemap)(const HistogramType* in,
   for (i = 0; i < in_size; ++i) {
     uint32_t best_out = i == 0 ? symbols[0] : symbols[i - 1];
     double best_bits =
-        FN(BrotliHistogramBitCostDistance)(&in[i], &out[best_out]);
+        FN(BrotliHistogramBitCostDistance)(&in[i], &out[best_out], 1e99);
     size_t j;
     for (j = 0; j < num_clusters; ++j) {
-      const double cur_bits =
-          FN(BrotliHistogramBitCostDistance)(&in[i], &out[clusters[j]]);
+      const double cur_bits = FN(BrotliHistogramBitCostDistance)(
+          &in[i], &out[clusters[j]], best_bits);
       if (cur_bits < best_bits) {
         best_bits = cur_bits;
         best_out = clusters[j];
@@ -0,0 +1,77 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Custom (raw) dictionaries, prepared for repeated use by the encoder. */
+
+#ifndef BROTLI_ENC_COMPOUND_DICTIONARY_H_
+#define BROTLI_ENC_COMPOUND_DICTIONARY_H_
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+#include "./memory.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/* Maximal number of dictionaries that could be attached to encoder. */
+#define BROTLI_MAX_COMPOUND_DICTS 15
+
+/* Maximal size of a single prepared dictionary. */
+#define BROTLI_MAX_PREPARED_DICTIONARY_SIZE ((size_t)1 << 30)
+
+static const uint32_t kPreparedDictionaryMagic = 0xDEBCEDE0;
+static const uint64_t kPreparedDictionaryHashMul64Long =
+    BROTLI_MAKE_UINT64_T(0x1FE35A7Bu, 0xD3579BD3u);
+
+/* Prepared dictionary is a single memory block; the layout is the same as
+   the one produced by Java PreparedDictionaryGenerator. Header is followed by:
+     uint32_t slot_offsets[1 << slot_bits];
+     uint16_t heads[1 << bucket_bits];
+     uint32_t items[num_items];
+     uint8_t source[source_size];
+   Bucket items are offsets of source positions with the same hash, the last
+   item of the bucket is marked with the highest bit. Heads are offsets of the
+   first bucket item relative to the slot start; 0xFFFF denotes empty bucket.
+   Prepared dictionary is never modified after creation, so it could be shared
+   by any number of encoders, including ones used concurrently. */
+typedef struct PreparedDictionary {
+  uint32_t magic;
+  uint32_t num_items;
+  uint32_t source_size;
+  uint32_t hash_bits;
+  uint32_t bucket_bits;
+  uint32_t slot_bits;
+} PreparedDictionary;
+
+/* Returns NULL on OOM. */
+BROTLI_INTERNAL PreparedDictionary* CreatePreparedDictionary(MemoryManager* m,
+    const uint8_t* source, size_t source_size);
+
+BROTLI_INTERNAL void DestroyPreparedDictionary(MemoryManager* m,
+    PreparedDictionary* dictionary);
+
+/* Set of prepared dictionaries attached to encoder. Dictionaries are
+   logically concatenated, and the result is placed right before the
+   beginning of the stream. */
+typedef struct CompoundDictionary {
+  size_t num_chunks;
+  size_t total_size;
+  const PreparedDictionary* chunks[BROTLI_MAX_COMPOUND_DICTS];
+  size_t chunk_offsets[BROTLI_MAX_COMPOUND_DICTS + 1];
+} CompoundDictionary;
+
+BROTLI_INTERNAL void InitCompoundDictionary(CompoundDictionary* compound);
+
+/* Returns BROTLI_FALSE if there is no room for one more dictionary. */
+BROTLI_INTERNAL BROTLI_BOOL AttachPreparedDictionary(
+    CompoundDictionary* compound, const PreparedDictionary* dictionary);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
+
+#endif  /* BROTLI_ENC_COMPOUND_DICTIONARY_H_ */
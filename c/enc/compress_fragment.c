@@ -20,6 +20,7 @@
 #include "../common/platform.h"
 #include <brotli/types.h>
 #include "./brotli_bit_stream.h"
+#include "./encoder_dict.h"
 #include "./entropy_encode.h"
 #include "./fast_log.h"
 #include "./find_match_length.h"
@@ -313,6 +314,36 @@ static BROTLI_INLINE void EmitDistance(size_t distance,
   ++histo[distcode];
 }
 
+/* Returns the number of bits that EmitCopyLen and EmitDistance spend on a
+   static dictionary reference; "copylen" is at most 24. */
+static BROTLI_INLINE size_t DictionaryReferenceCost(size_t copylen,
+    size_t distance, const uint8_t depth[128]) {
+  const size_t d = distance + 3;
+  const uint32_t nbits = Log2FloorNonZero(d) - 1u;
+  const size_t prefix = (d >> nbits) & 1;
+  const size_t distcode = 2 * (nbits - 1) + prefix + 80;
+  size_t cost = depth[distcode] + nbits;
+  if (copylen < 10) {
+    cost += depth[copylen + 14];
+  } else {
+    const size_t tail = copylen - 6;
+    const uint32_t copy_nbits = Log2FloorNonZero(tail) - 1u;
+    const size_t copy_prefix = tail >> copy_nbits;
+    cost += depth[(copy_nbits << 1) + copy_prefix + 20] + copy_nbits;
+  }
+  return cost;
+}
+
+static BROTLI_INLINE size_t LiteralsCost(const uint8_t* input, size_t len,
+                                         const uint8_t depth[256]) {
+  size_t cost = 0;
+  size_t j;
+  for (j = 0; j < len; j++) {
+    cost += depth[input[j]];
+  }
+  return cost;
+}
+
 static BROTLI_INLINE void EmitLiterals(const uint8_t* input, const size_t len,
                                        const uint8_t depth[256],
                                        const uint16_t bits[256],
@@ -426,6 +457,7 @@ static BROTLI_INLINE void BrotliCompressFragmentFastImpl(
     MemoryManager* m, const uint8_t* input, size_t input_size,
     BROTLI_BOOL is_last, int* table, size_t table_bits, uint8_t cmd_depth[128],
     uint16_t cmd_bits[128], size_t* cmd_code_numbits, uint8_t* cmd_code,
+    const BrotliFragmentDictionary* dictionary,
     size_t* storage_ix, uint8_t* storage) {
   uint32_t cmd_histo[128];
   const uint8_t* ip_end;
@@ -616,6 +648,7 @@ trawl:
         }
       }
 
+follow_up:
       while (IsMatch(ip, candidate)) {
         /* We have a 5-byte match at ip, and no need to emit any literal bytes
            prior to ip. */
@@ -653,6 +686,36 @@ trawl:
         }
       }
 
+      /* A static dictionary word could be referenced only by a copy without
+         preceding literals: the insert commands of this alphabet always carry
+         a 2-byte backward copy. */
+      if (dictionary != NULL) {
+        size_t copy_len;
+        size_t distance;
+        const size_t matched = BrotliFindFragmentDictionaryMatch(
+            dictionary, ip, dictionary->position + (size_t)(ip - base_ip),
+            (size_t)(ip_end - ip), kMinMatchLen, &copy_len, &distance);
+        if (matched != 0 && DictionaryReferenceCost(copy_len, distance,
+            cmd_depth) < LiteralsCost(ip, matched, lit_depth)) {
+          /* Dictionary references do not update the last distance. */
+          ip += matched;
+          EmitCopyLen(copy_len, cmd_depth, cmd_bits, cmd_histo,
+                      storage_ix, storage);
+          EmitDistance(distance, cmd_depth, cmd_bits, cmd_histo,
+                       storage_ix, storage);
+          next_emit = ip;
+          if (BROTLI_PREDICT_FALSE(ip >= ip_limit)) {
+            goto emit_remainder;
+          }
+          {
+            const uint32_t cur_hash = Hash(ip, shift);
+            candidate = base_ip + table[cur_hash];
+            table[cur_hash] = (int)(ip - base_ip);
+          }
+          goto follow_up;
+        }
+      }
+
       next_hash = Hash(++ip, shift);
     }
   }
@@ -735,9 +798,11 @@ static BROTLI_NOINLINE void BrotliCompressFragmentFastImpl ## B(             \
     MemoryManager* m, const uint8_t* input, size_t input_size,               \
     BROTLI_BOOL is_last, int* table, uint8_t cmd_depth[128],                 \
     uint16_t cmd_bits[128], size_t* cmd_code_numbits, uint8_t* cmd_code,     \
+    const BrotliFragmentDictionary* dictionary,                              \
     size_t* storage_ix, uint8_t* storage) {                                  \
   BrotliCompressFragmentFastImpl(m, input, input_size, is_last, table, B,    \
-      cmd_depth, cmd_bits, cmd_code_numbits, cmd_code, storage_ix, storage); \
+      cmd_depth, cmd_bits, cmd_code_numbits, cmd_code, dictionary,           \
+      storage_ix, storage);                                                  \
 }
 FOR_TABLE_BITS_(BAKE_METHOD_PARAM_)
 #undef BAKE_METHOD_PARAM_
@@ -746,6 +811,7 @@ void BrotliCompressFragmentFast(
     MemoryManager* m, const uint8_t* input, size_t input_size,
     BROTLI_BOOL is_last, int* table, size_t table_size, uint8_t cmd_depth[128],
     uint16_t cmd_bits[128], size_t* cmd_code_numbits, uint8_t* cmd_code,
+    const BrotliFragmentDictionary* dictionary,
     size_t* storage_ix, uint8_t* storage) {
   const size_t initial_storage_ix = *storage_ix;
   const size_t table_bits = Log2FloorNonZero(table_size);
@@ -763,7 +829,8 @@ void BrotliCompressFragmentFast(
     case B:                                                          \
       BrotliCompressFragmentFastImpl ## B(                           \
           m, input, input_size, is_last, table, cmd_depth, cmd_bits, \
-          cmd_code_numbits, cmd_code, storage_ix, storage);          \
+          cmd_code_numbits, cmd_code, dictionary,                    \
+          storage_ix, storage);                                      \
       break;
     FOR_TABLE_BITS_(CASE_)
 #undef CASE_
@@ -14,6 +14,7 @@
 
 #include "../common/platform.h"
 #include <brotli/types.h>
+#include "./encoder_dict.h"
 #include "./memory.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -36,23 +37,22 @@ extern "C" {
    command and distance prefix codes. If "is_last" is 0, these are also
    updated to represent the updated "cmd_depth" and "cmd_bits".
 
+   If "dictionary" is not NULL, words of its static dictionary that directly
+   follow a backward match are emitted as static dictionary references.
+
    REQUIRES: "input_size" is greater than zero, or "is_last" is 1.
    REQUIRES: "input_size" is less or equal to maximal metablock size (1 << 24).
    REQUIRES: All elements in "table[0..table_size-1]" are initialized to zero.
    REQUIRES: "table_size" is an odd (9, 11, 13, 15) power of two
    OUTPUT: maximal copy distance <= |input_size|
-   OUTPUT: maximal copy distance <= BROTLI_MAX_BACKWARD_LIMIT(18) */
+   OUTPUT: maximal copy distance <= BROTLI_MAX_BACKWARD_LIMIT(18)
+   (static dictionary references excluded) */
 BROTLI_INTERNAL void BrotliCompressFragmentFast(MemoryManager* m,
-                                                const uint8_t* input,
-                                                size_t input_size,
-                                                BROTLI_BOOL is_last,
-                                                int* table, size_t table_size,
-                                                uint8_t cmd_depth[128],
-                                                uint16_t cmd_bits[128],
-                                                size_t* cmd_code_numbits,
-                                                uint8_t* cmd_code,
-                                                size_t* storage_ix,
-                                                uint8_t* storage);
+    const uint8_t* input, size_t input_size, BROTLI_BOOL is_last,
+    int* table, size_t table_size, uint8_t cmd_depth[128],
+    uint16_t cmd_bits[128], size_t* cmd_code_numbits, uint8_t* cmd_code,
+    const BrotliFragmentDictionary* dictionary,
+    size_t* storage_ix, uint8_t* storage);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
@@ -19,6 +19,7 @@
 #include <brotli/types.h>
 #include "./bit_cost.h"
 #include "./brotli_bit_stream.h"
+#include "./encoder_dict.h"
 #include "./entropy_encode.h"
 #include "./fast_log.h"
 #include "./find_match_length.h"
@@ -239,6 +240,7 @@ static void BrotliStoreMetaBlockHeader(
 static BROTLI_INLINE void CreateCommands(const uint8_t* input,
     size_t block_size, size_t input_size, const uint8_t* base_ip, int* table,
     size_t table_bits, size_t min_match,
+    const BrotliFragmentDictionary* dictionary,
     uint8_t** literals, uint32_t** commands) {
   /* "ip" is the input pointer. */
   const uint8_t* ip = input;
@@ -382,6 +384,7 @@ trawl:
         }
       }
 
+follow_up:
       while (ip - candidate <= MAX_DISTANCE &&
           IsMatch(ip, candidate, min_match)) {
         /* We have a 6-byte match at ip, and no need to emit any
@@ -437,6 +440,33 @@ trawl:
         }
       }
 
+      /* A static dictionary word could be referenced only by a copy without
+         preceding literals: the insert commands of this alphabet always carry
+         a 2-byte backward copy. */
+      if (dictionary != NULL) {
+        size_t copy_len;
+        size_t distance;
+        const size_t matched = BrotliFindFragmentDictionaryMatch(
+            dictionary, ip, dictionary->position + (size_t)(ip - base_ip),
+            (size_t)(ip_end - ip), min_match, &copy_len, &distance);
+        if (matched != 0) {
+          /* Dictionary references do not update the last distance. */
+          ip += matched;
+          EmitCopyLen(copy_len, commands);
+          EmitDistance((uint32_t)distance, commands);
+          next_emit = ip;
+          if (BROTLI_PREDICT_FALSE(ip >= ip_limit)) {
+            goto emit_remainder;
+          }
+          {
+            const uint32_t cur_hash = Hash(ip, shift, min_match);
+            candidate = base_ip + table[cur_hash];
+            table[cur_hash] = (int)(ip - base_ip);
+          }
+          goto follow_up;
+        }
+      }
+
       next_hash = Hash(++ip, shift, min_match);
     }
   }
@@ -558,6 +588,7 @@ static BROTLI_INLINE void BrotliCompressFragmentTwoPassImpl(
     MemoryManager* m, const uint8_t* input, size_t input_size,
     BROTLI_BOOL is_last, uint32_t* command_buf, uint8_t* literal_buf,
     int* table, size_t table_bits, size_t min_match,
+    const BrotliFragmentDictionary* dictionary,
     size_t* storage_ix, uint8_t* storage) {
   /* Save the start of the first block for position and distance computations.
   */
@@ -571,7 +602,7 @@ static BROTLI_INLINE void BrotliCompressFragmentTwoPassImpl(
     uint8_t* literals = literal_buf;
     size_t num_literals;
     CreateCommands(input, block_size, input_size, base_ip, table,
-                   table_bits, min_match, &literals, &commands);
+                   table_bits, min_match, dictionary, &literals, &commands);
     num_literals = (size_t)(literals - literal_buf);
     if (ShouldCompress(input, block_size, num_literals)) {
       const size_t num_commands = (size_t)(commands - command_buf);
@@ -599,10 +630,11 @@ static BROTLI_INLINE void BrotliCompressFragmentTwoPassImpl(
 static BROTLI_NOINLINE void BrotliCompressFragmentTwoPassImpl ## B(            \
     MemoryManager* m, const uint8_t* input, size_t input_size,                 \
     BROTLI_BOOL is_last, uint32_t* command_buf, uint8_t* literal_buf,          \
-    int* table, size_t* storage_ix, uint8_t* storage) {                        \
+    int* table, const BrotliFragmentDictionary* dictionary,                    \
+    size_t* storage_ix, uint8_t* storage) {                                    \
   size_t min_match = (B <= 15) ? 4 : 6;                                        \
   BrotliCompressFragmentTwoPassImpl(m, input, input_size, is_last, command_buf,\
-      literal_buf, table, B, min_match, storage_ix, storage);                  \
+      literal_buf, table, B, min_match, dictionary, storage_ix, storage);      \
 }
 FOR_TABLE_BITS_(BAKE_METHOD_PARAM_)
 #undef BAKE_METHOD_PARAM_
@@ -610,7 +642,8 @@ FOR_TABLE_BITS_(BAKE_METHOD_PARAM_)
 void BrotliCompressFragmentTwoPass(
     MemoryManager* m, const uint8_t* input, size_t input_size,
     BROTLI_BOOL is_last, uint32_t* command_buf, uint8_t* literal_buf,
-    int* table, size_t table_size, size_t* storage_ix, uint8_t* storage) {
+    int* table, size_t table_size, const BrotliFragmentDictionary* dictionary,
+    size_t* storage_ix, uint8_t* storage) {
   const size_t initial_storage_ix = *storage_ix;
   const size_t table_bits = Log2FloorNonZero(table_size);
   switch (table_bits) {
@@ -618,7 +651,8 @@ void BrotliCompressFragmentTwoPass(
     case B:                                           \
       BrotliCompressFragmentTwoPassImpl ## B(         \
           m, input, input_size, is_last, command_buf, \
-          literal_buf, table, storage_ix, storage);   \
+          literal_buf, table, dictionary,             \
+          storage_ix, storage);                       \
       break;
     FOR_TABLE_BITS_(CASE_)
 #undef CASE_
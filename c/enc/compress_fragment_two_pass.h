@@ -15,6 +15,7 @@
 
 #include "../common/platform.h"
 #include <brotli/types.h>
+#include "./encoder_dict.h"
 #include "./memory.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -28,6 +29,9 @@ static const size_t kCompressFragmentTwoPassBlockSize = 1 << 17;
 
    If "is_last" is 1, emits an additional empty last meta-block.
 
+   If "dictionary" is not NULL, words of its static dictionary that directly
+   follow a backward match are emitted as static dictionary references.
+
    REQUIRES: "input_size" is greater than zero, or "is_last" is 1.
    REQUIRES: "input_size" is less or equal to maximal metablock size (1 << 24).
    REQUIRES: "command_buf" and "literal_buf" point to at least
@@ -35,17 +39,14 @@ static const size_t kCompressFragmentTwoPassBlockSize = 1 << 17;
    REQUIRES: All elements in "table[0..table_size-1]" are initialized to zero.
    REQUIRES: "table_size" is a power of two
    OUTPUT: maximal copy distance <= |input_size|
-   OUTPUT: maximal copy distance <= BROTLI_MAX_BACKWARD_LIMIT(18) */
+   OUTPUT: maximal copy distance <= BROTLI_MAX_BACKWARD_LIMIT(18)
+   (static dictionary references excluded) */
 BROTLI_INTERNAL void BrotliCompressFragmentTwoPass(MemoryManager* m,
-                                                   const uint8_t* input,
-                                                   size_t input_size,
-                                                   BROTLI_BOOL is_last,
-                                                   uint32_t* command_buf,
-                                                   uint8_t* literal_buf,
-                                                   int* table,
-                                                   size_t table_size,
-                                                   size_t* storage_ix,
-                                                   uint8_t* storage);
+    const uint8_t* input, size_t input_size, BROTLI_BOOL is_last,
+    uint32_t* command_buf, uint8_t* literal_buf,
+    int* table, size_t table_size,
+    const BrotliFragmentDictionary* dictionary,
+    size_t* storage_ix, uint8_t* storage);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
@@ -19,7 +19,9 @@
 #include "./backward_references_hq.h"
 #include "./bit_cost.h"
 #include "./brotli_bit_stream.h"
+#include "./cluster.h"
 #include "./compress_fragment.h"
+#include "./compound_dictionary.h"
 #include "./compress_fragment_two_pass.h"
 #include "./encoder_dict.h"
 #include "./entropy_encode.h"
@@ -32,6 +34,7 @@
 #include "./quality.h"
 #include "./ringbuffer.h"
 #include "./utf8_util.h"
+#include "./worker.h"
 #include "./write_bits.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -69,6 +72,10 @@ typedef struct BrotliEncoderStateStruct {
 
   uint64_t input_pos_;
   RingBuffer ringbuffer_;
+  /* Caller-owned input used in place of ring buffer; set only by one-shot
+     compression, when the whole input stays alive and unchanged. */
+  const uint8_t* stable_input_;
+  size_t stable_input_size_;
   size_t cmd_alloc_size_;
   Command* commands_;
   size_t num_commands_;
@@ -88,6 +95,10 @@ typedef struct BrotliEncoderStateStruct {
   uint8_t prev_byte2_;
   size_t storage_size_;
   uint8_t* storage_;
+  /* Caller's output buffer offered to GetBrotliStorage for the metablock being
+     encoded; used instead of |storage_| when it fits the worst case size. */
+  uint8_t* inplace_out_;
+  size_t inplace_out_size_;
 
   Hasher hasher_;
 
@@ -124,6 +135,14 @@ typedef struct BrotliEncoderStateStruct {
   uint32_t remaining_metadata_bytes_;
   BrotliEncoderStreamState stream_state_;
 
+  /* Input buffer for "segmented" mode (see BROTLI_PARAM_NUM_THREADS): holds
+     |segment_history_| bytes of already compressed data (used for priming
+     the next segments), followed by |segment_pending_| bytes of input. */
+  uint8_t* segment_buf_;
+  size_t segment_buf_size_;
+  size_t segment_history_;
+  size_t segment_pending_;
+
   BROTLI_BOOL is_last_block_emitted_;
   BROTLI_BOOL is_initialized_;
 } BrotliEncoderStateStruct;
@@ -191,6 +210,15 @@ BROTLI_BOOL BrotliEncoderSetParameter(
       state->params.stream_offset = value;
       return BROTLI_TRUE;
 
+    case BROTLI_PARAM_NUM_THREADS:
+      if (value > BROTLI_MAX_THREADS) return BROTLI_FALSE;
+      state->params.num_threads = value;
+      return BROTLI_TRUE;
+
+    case BROTLI_PARAM_MEMORY_LIMIT:
+      state->params.memory_limit = value;
+      return BROTLI_TRUE;
+
     default: return BROTLI_FALSE;
   }
 }
@@ -209,6 +237,7 @@ static uint32_t WrapPosition(uint64_t position) {
 
 static uint8_t* GetBrotliStorage(BrotliEncoderState* s, size_t size) {
   MemoryManager* m = &s->memory_manager_;
+  if (s->inplace_out_size_ >= size) return s->inplace_out_;
   if (s->storage_size_ < size) {
     BROTLI_FREE(m, s->storage_);
     s->storage_ = BROTLI_ALLOC(m, uint8_t, size);
@@ -226,16 +255,9 @@ static size_t HashTableSize(size_t max_table_size, size_t input_size) {
   return htsize;
 }
 
-static int* GetHashTable(BrotliEncoderState* s, int quality,
-                         size_t input_size, size_t* table_size) {
-  /* Use smaller hash table when input.size() is smaller, since we
-     fill the table, incurring O(hash table size) overhead for
-     compression, and if the input is short, we won't need that
-     many hash table entries anyway. */
-  MemoryManager* m = &s->memory_manager_;
+static size_t FastHashTableSize(int quality, size_t input_size) {
   const size_t max_table_size = MaxHashTableSize(quality);
   size_t htsize = HashTableSize(max_table_size, input_size);
-  int* table;
   BROTLI_DCHECK(max_table_size >= 256);
   if (quality == FAST_ONE_PASS_COMPRESSION_QUALITY) {
     /* Only odd shifts are supported by fast-one-pass. */
@@ -243,6 +265,18 @@ static int* GetHashTable(BrotliEncoderState* s, int quality,
       htsize <<= 1;
     }
   }
+  return htsize;
+}
+
+static int* GetHashTable(BrotliEncoderState* s, int quality,
+                         size_t input_size, size_t* table_size) {
+  /* Use smaller hash table when input.size() is smaller, since we
+     fill the table, incurring O(hash table size) overhead for
+     compression, and if the input is short, we won't need that
+     many hash table entries anyway. */
+  MemoryManager* m = &s->memory_manager_;
+  size_t htsize = FastHashTableSize(quality, input_size);
+  int* table;
 
   if (htsize <= sizeof(s->small_table_) / sizeof(s->small_table_[0])) {
     table = s->small_table_;
@@ -261,6 +295,27 @@ static int* GetHashTable(BrotliEncoderState* s, int quality,
   return table;
 }
 
+/* Sets up static dictionary references of the fast encoders for the input
+   fragment that starts at |position| (relative to stream offset). Returns NULL
+   if fast encoders should not reference the static dictionary. The lookups
+   cost about a tenth of the compression speed and pay off mostly on short
+   text, so they are enabled only in text mode. */
+static const BrotliFragmentDictionary* GetFragmentDictionary(
+    const BrotliEncoderState* s, uint64_t position,
+    BrotliFragmentDictionary* dictionary) {
+  /* Fast encoders always declare a window of at least 18 bits. */
+  const size_t max_backward_limit =
+      BROTLI_MAX_BACKWARD_LIMIT(BROTLI_MAX(int, s->params.lgwin, 18));
+  const uint64_t stream_position = s->params.stream_offset + position;
+  if (s->params.mode != BROTLI_MODE_TEXT) return NULL;
+  dictionary->dictionary = &s->params.dictionary;
+  dictionary->position = (stream_position < max_backward_limit) ?
+      (size_t)stream_position : max_backward_limit;
+  dictionary->max_backward_limit = max_backward_limit;
+  dictionary->gap = s->params.compound.total_size;
+  return dictionary;
+}
+
 static void EncodeWindowBits(int lgwin, BROTLI_BOOL large_window,
     uint16_t* last_bytes, uint8_t* last_bytes_bits) {
   if (large_window) {
@@ -510,6 +565,26 @@ static void DecideOverLiteralContextModeling(const uint8_t* input,
   }
 }
 
+/* Estimates the entropy of the literals by sampling every 13th byte.
+   Returns BROTLI_TRUE if the literals could not be entropy coded with
+   a noticeable gain. */
+static BROTLI_BOOL IsHighEntropyData(const uint8_t* data, const size_t mask,
+    const uint32_t position, const size_t bytes) {
+  uint32_t literal_histo[256] = { 0 };
+  static const uint32_t kSampleRate = 13;
+  static const double kMinEntropy = 7.92;
+  const double bit_cost_threshold =
+      (double)bytes * kMinEntropy / kSampleRate;
+  size_t t = (bytes + kSampleRate - 1) / kSampleRate;
+  uint32_t pos = position;
+  size_t i;
+  for (i = 0; i < t; i++) {
+    ++literal_histo[data[pos & mask]];
+    pos += kSampleRate;
+  }
+  return TO_BROTLI_BOOL(BitsEntropy(literal_histo, 256) > bit_cost_threshold);
+}
+
 static BROTLI_BOOL ShouldCompress(
     const uint8_t* data, const size_t mask, const uint64_t last_flush_pos,
     const size_t bytes, const size_t num_literals, const size_t num_commands) {
@@ -517,19 +592,7 @@ static BROTLI_BOOL ShouldCompress(
   if (bytes <= 2) return BROTLI_FALSE;
   if (num_commands < (bytes >> 8) + 2) {
     if ((double)num_literals > 0.99 * (double)bytes) {
-      uint32_t literal_histo[256] = { 0 };
-      static const uint32_t kSampleRate = 13;
-      static const double kMinEntropy = 7.92;
-      const double bit_cost_threshold =
-          (double)bytes * kMinEntropy / kSampleRate;
-      size_t t = (bytes + kSampleRate - 1) / kSampleRate;
-      uint32_t pos = (uint32_t)last_flush_pos;
-      size_t i;
-      for (i = 0; i < t; i++) {
-        ++literal_histo[data[pos & mask]];
-        pos += kSampleRate;
-      }
-      if (BitsEntropy(literal_histo, 256) > bit_cost_threshold) {
+      if (IsHighEntropyData(data, mask, (uint32_t)last_flush_pos, bytes)) {
         return BROTLI_FALSE;
       }
     }
@@ -685,6 +748,193 @@ static void ChooseDistanceParams(BrotliEncoderParams* params) {
       params, distance_postfix_bits, num_direct_distance_codes);
 }
 
+/* Returns the amount of preceding data used to prime segment encoders.
+   Fast compressors do not reference data across the block boundaries.
+   Each segment encoder hashes all its priming data again, so priming is
+   capped by the segment size; otherwise with large window every segment
+   would cost up to 1GiB of extra hashing. */
+static size_t SegmentWindowSize(const BrotliEncoderParams* params) {
+  if (params->quality == FAST_ONE_PASS_COMPRESSION_QUALITY ||
+      params->quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
+    return 0;
+  }
+  return BROTLI_MIN(size_t, BROTLI_MAX_BACKWARD_LIMIT(params->lgwin),
+                    (size_t)1 << ComputeLgSegment(params));
+}
+
+/* Returns the upper bound of arena capacity, when |size| bytes are allocated
+   in scope. Arena grows by doubling blocks; when scope took several blocks,
+   they are replaced with the single block of their total size. */
+static size_t ArenaCapacity(size_t size) {
+  return 2 * BROTLI_MAX(size_t, size, BROTLI_ARENA_MIN_BLOCK_SIZE);
+}
+
+/* Returns the estimate of memory taken by block splitting, histogram
+   clustering and entropy coding of metablock with |num_symbols| literals and
+   commands at most, arena included. Block splitter and clustering work with
+   a bounded number of histograms, so the part that depends on the number of
+   symbols grows slower for large metablocks. Coefficients are fitted, with
+   margin, to peaks measured on inputs that maximize the number of block
+   types; they are not derived from the allocation formulas. */
+static size_t MetablockScratchSize(int quality, size_t num_symbols) {
+  if (quality < MIN_QUALITY_FOR_BLOCK_SPLIT) {
+    return ArenaCapacity(0);
+  } else if (quality < MIN_QUALITY_FOR_HQ_BLOCK_SPLITTING) {
+    return ArenaCapacity(0) + num_symbols +
+        8 * BROTLI_MIN(size_t, num_symbols, (size_t)1 << 17);
+  }
+  return ((size_t)2 << 20) + 24 * num_symbols +
+      96 * BROTLI_MIN(size_t, num_symbols, (size_t)1 << 16);
+}
+
+/* Returns the estimate of peak memory usage of encoder with the given
+   parameters. |params->size_hint| is used as input size, 0 means unknown
+   (unbounded) input. Formulas follow the allocations made by EncodeData and
+   its callees, including transient copies made when buffers grow; block
+   splitting scratch is bounded with coefficients measured on inputs that
+   maximize it. */
+static size_t EstimateEncoderMemoryUsage(const BrotliEncoderParams* params) {
+  BrotliEncoderParams p = *params;
+  const size_t input_size = p.size_hint;
+  const size_t state_size = sizeof(BrotliEncoderState);
+  SanitizeParams(&p);
+  p.lgblock = ComputeLgBlock(&p);
+  ChooseDistanceParams(&p);
+
+  if (p.num_threads != 0) {
+    /* Each thread runs its own encoder over segment and priming data;
+       segment encoders always split optimal parsing into ranges. */
+    const size_t segment_size = (size_t)1 << ComputeLgSegment(&p);
+    const size_t batch_size = segment_size * p.num_threads;
+    const size_t window = SegmentWindowSize(&p);
+    size_t segment_encoder_size;
+    p.num_threads = 0;
+    p.zopfli_threads = 1;
+    p.size_hint = segment_size + window;
+    if (input_size != 0) {
+      p.size_hint = BROTLI_MIN(size_t, p.size_hint, input_size);
+    }
+    segment_encoder_size = EstimateEncoderMemoryUsage(&p);
+    /* Input buffer and segment outputs. */
+    return state_size + window + 2 * batch_size +
+        params->num_threads * segment_encoder_size;
+  }
+
+  if (p.quality == FAST_ONE_PASS_COMPRESSION_QUALITY ||
+      p.quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
+    size_t block_size = (size_t)1 << p.lgwin;
+    size_t table_size;
+    /* Huffman tree for the literal alphabet is built on the heap. */
+    size_t result = state_size +
+        (2 * BROTLI_NUM_LITERAL_SYMBOLS + 1) * sizeof(HuffmanTree);
+    if (input_size != 0) {
+      block_size = BROTLI_MIN(size_t, block_size, input_size);
+    }
+    table_size = FastHashTableSize(p.quality, block_size);
+    if (table_size > (1u << 10)) result += sizeof(int) * table_size;
+    if (p.quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
+      result += (sizeof(uint32_t) + sizeof(uint8_t)) *
+          BROTLI_MIN(size_t, block_size, kCompressFragmentTwoPassBlockSize);
+    }
+    /* Output goes directly to the caller's buffer only if it is large
+       enough. */
+    return result + 2 * block_size + 503;
+  } else {
+    const size_t input_block_size = (input_size != 0) ?
+        BROTLI_MIN(size_t, input_size, (size_t)1 << p.lgblock) :
+        (size_t)1 << p.lgblock;
+    const size_t metablock_size = (input_size != 0) ?
+        BROTLI_MIN(size_t, input_size, MaxMetablockSize(&p)) :
+        MaxMetablockSize(&p);
+    /* Input blocks are merged into metablock until it has 1/8 of maximal
+       metablock size literals or commands; the last block adds up to its
+       size more. */
+    const size_t num_symbols = BROTLI_MIN(size_t, metablock_size,
+        MaxMetablockSize(&p) / 8 + input_block_size);
+    RingBuffer rb;
+    size_t ringbuffer_size;
+    size_t hasher_size;
+    size_t command_size;
+    size_t scratch_size;
+    RingBufferSetup(&p, &rb);
+    /* Ring buffer has 2 bytes of slack before and 7 after the data. The
+       first write, if shorter than the input block, is stored in a smaller
+       buffer, that is copied to the full one on the next write. */
+    ringbuffer_size = rb.total_size_ + 9 + BROTLI_MIN(size_t,
+        input_block_size, rb.tail_size_) + 9;
+    if (input_size != 0 && input_size < rb.tail_size_) {
+      ringbuffer_size = BROTLI_MIN(size_t, ringbuffer_size,
+          rb.total_size_ + 9 + input_size + 9);
+    }
+    /* Hasher depends on the size hint, that encoder takes from the input
+       if none is given, and on whether all input comes at once. */
+    ChooseHasher(&p, &p.hasher);
+    hasher_size = BROTLI_MAX(size_t, HasherSize(&p, BROTLI_FALSE, input_size),
+        HasherSize(&p, BROTLI_TRUE, input_size));
+    if (input_size == 0) {
+      p.size_hint = BROTLI_SIZE_MAX;
+      ChooseHasher(&p, &p.hasher);
+      hasher_size = BROTLI_MAX(size_t, hasher_size,
+          HasherSize(&p, BROTLI_FALSE, input_size));
+      p.size_hint = 0;
+      ChooseHasher(&p, &p.hasher);
+    }
+    /* Command buffer is copied, when it grows. Before that it has at most
+       one command per 2 bytes, but less than 1/8 of maximal metablock size,
+       and each input block reserves up to 3/4 of its size more. */
+    command_size = 2 * sizeof(Command) * (BROTLI_MIN(size_t,
+        metablock_size / 2, MaxMetablockSize(&p) / 8) +
+        input_block_size / 4 * 3 + 17);
+    if (p.quality < MIN_QUALITY_FOR_BLOCK_SPLIT) {
+      command_size = BROTLI_MIN(size_t, command_size, 2 * sizeof(Command) *
+          (MAX_NUM_DELAYED_SYMBOLS + input_block_size / 4 * 3 + 17));
+    }
+    /* Optimal parsing and metablock are built in arena, that keeps its
+       blocks between the scopes; allocations larger than its minimal block
+       are not served from arena, so sizes are added. */
+    scratch_size = MetablockScratchSize(p.quality, num_symbols);
+    if (p.quality >= ZOPFLIFICATION_QUALITY) {
+      const size_t parsed_size = p.windowed_zopfli ?
+          BROTLI_MIN(size_t, input_block_size, ZOPFLI_WINDOW_SIZE) :
+          input_block_size;
+      const size_t zopfli_size = BrotliZopfliMemoryUsage(&p, parsed_size);
+      scratch_size = BROTLI_MAX(size_t, scratch_size,
+          ArenaCapacity(zopfli_size) + zopfli_size);
+    }
+    return state_size + ringbuffer_size + hasher_size + command_size +
+        (2 * metablock_size + 503) + scratch_size;
+  }
+}
+
+/* Degrades parameters until the estimated memory usage fits the limit.
+   Options that do not affect compression ratio much go first. */
+static void FitMemoryLimit(BrotliEncoderParams* params) {
+  const size_t limit = params->memory_limit;
+  while (EstimateEncoderMemoryUsage(params) > limit) {
+    if (params->num_threads != 0) {
+      params->num_threads--;
+    } else if (params->size_hint != 0 &&
+        params->lgwin > BROTLI_MIN_WINDOW_BITS &&
+        BROTLI_MAX_BACKWARD_LIMIT(params->lgwin - 1) >= params->size_hint) {
+      params->lgwin--;
+    } else if (params->quality >= ZOPFLIFICATION_QUALITY &&
+        !params->windowed_zopfli) {
+      params->windowed_zopfli = BROTLI_TRUE;
+    } else if (params->lgwin > 18) {
+      params->lgwin--;
+    } else if (params->quality > BROTLI_MIN_QUALITY) {
+      params->quality--;
+    } else if (params->lgwin > BROTLI_MIN_WINDOW_BITS) {
+      params->lgwin--;
+    } else {
+      break;
+    }
+  }
+  if (params->lgwin <= BROTLI_MAX_WINDOW_BITS) {
+    params->large_window = BROTLI_FALSE;
+  }
+}
+
 static BROTLI_BOOL EnsureInitialized(BrotliEncoderState* s) {
   if (BROTLI_IS_OOM(&s->memory_manager_)) return BROTLI_FALSE;
   if (s->is_initialized_) return BROTLI_TRUE;
@@ -695,6 +945,10 @@ static BROTLI_BOOL EnsureInitialized(BrotliEncoderState* s) {
   s->remaining_metadata_bytes_ = BROTLI_UINT32_MAX;
 
   SanitizeParams(&s->params);
+  if (s->params.memory_limit != 0) {
+    FitMemoryLimit(&s->params);
+    SanitizeParams(&s->params);
+  }
   s->params.lgblock = ComputeLgBlock(&s->params);
   ChooseDistanceParams(&s->params);
 
@@ -743,9 +997,14 @@ static void BrotliEncoderInitParams(BrotliEncoderParams* params) {
   params->lgwin = BROTLI_DEFAULT_WINDOW;
   params->lgblock = 0;
   params->stream_offset = 0;
+  params->num_threads = 0;
+  params->zopfli_threads = 0;
   params->size_hint = 0;
+  params->memory_limit = 0;
+  params->windowed_zopfli = BROTLI_FALSE;
   params->disable_literal_context_modeling = BROTLI_FALSE;
   BrotliInitEncoderDictionary(&params->dictionary);
+  InitCompoundDictionary(&params->compound);
   params->dist.distance_postfix_bits = 0;
   params->dist.num_direct_distance_codes = 0;
   params->dist.alphabet_size_max =
@@ -754,7 +1013,21 @@ static void BrotliEncoderInitParams(BrotliEncoderParams* params) {
   params->dist.max_distance = BROTLI_MAX_DISTANCE;
 }
 
-static void BrotliEncoderInitState(BrotliEncoderState* s) {
+size_t BrotliEncoderEstimatePeakMemoryUsage(int quality, int lgwin,
+    int lgblock, size_t size_hint) {
+  BrotliEncoderParams params;
+  BrotliEncoderInitParams(&params);
+  params.quality = quality;
+  params.lgwin = lgwin;
+  params.lgblock = lgblock;
+  params.size_hint = size_hint;
+  params.large_window = TO_BROTLI_BOOL(lgwin > BROTLI_MAX_WINDOW_BITS);
+  return EstimateEncoderMemoryUsage(&params);
+}
+
+/* Brings stream state to the initial one. Allocated buffers are not
+   touched. */
+static void BrotliEncoderInitStreamState(BrotliEncoderState* s) {
   BrotliEncoderInitParams(&s->params);
   s->input_pos_ = 0;
   s->num_commands_ = 0;
@@ -764,25 +1037,17 @@ static void BrotliEncoderInitState(BrotliEncoderState* s) {
   s->last_processed_pos_ = 0;
   s->prev_byte_ = 0;
   s->prev_byte2_ = 0;
-  s->storage_size_ = 0;
-  s->storage_ = 0;
-  HasherInit(&s->hasher_);
-  s->large_table_ = NULL;
-  s->large_table_size_ = 0;
   s->cmd_code_numbits_ = 0;
-  s->command_buf_ = NULL;
-  s->literal_buf_ = NULL;
   s->next_out_ = NULL;
   s->available_out_ = 0;
   s->total_out_ = 0;
   s->stream_state_ = BROTLI_STREAM_PROCESSING;
   s->is_last_block_emitted_ = BROTLI_FALSE;
   s->is_initialized_ = BROTLI_FALSE;
-
-  RingBufferInit(&s->ringbuffer_);
-
-  s->commands_ = 0;
-  s->cmd_alloc_size_ = 0;
+  s->segment_history_ = 0;
+  s->segment_pending_ = 0;
+  s->stable_input_ = NULL;
+  s->stable_input_size_ = 0;
 
   /* Initialize distance cache. */
   s->dist_cache_[0] = 4;
@@ -794,6 +1059,27 @@ static void BrotliEncoderInitState(BrotliEncoderState* s) {
   memcpy(s->saved_dist_cache_, s->dist_cache_, sizeof(s->saved_dist_cache_));
 }
 
+static void BrotliEncoderInitState(BrotliEncoderState* s) {
+  s->storage_size_ = 0;
+  s->inplace_out_ = NULL;
+  s->inplace_out_size_ = 0;
+  s->storage_ = 0;
+  HasherInit(&s->hasher_);
+  s->large_table_ = NULL;
+  s->large_table_size_ = 0;
+  s->command_buf_ = NULL;
+  s->literal_buf_ = NULL;
+  s->segment_buf_ = NULL;
+  s->segment_buf_size_ = 0;
+
+  RingBufferInit(&s->ringbuffer_);
+
+  s->commands_ = 0;
+  s->cmd_alloc_size_ = 0;
+
+  BrotliEncoderInitStreamState(s);
+}
+
 BrotliEncoderState* BrotliEncoderCreateInstance(
     brotli_alloc_func alloc_func, brotli_free_func free_func, void* opaque) {
   BrotliEncoderState* state = 0;
@@ -825,6 +1111,8 @@ static void BrotliEncoderCleanupState(BrotliEncoderState* s) {
   BROTLI_FREE(m, s->large_table_);
   BROTLI_FREE(m, s->command_buf_);
   BROTLI_FREE(m, s->literal_buf_);
+  BROTLI_FREE(m, s->segment_buf_);
+  BrotliFreeArena(m);
 }
 
 /* Deinitializes and frees BrotliEncoderState instance. */
@@ -840,6 +1128,73 @@ void BrotliEncoderDestroyInstance(BrotliEncoderState* state) {
   }
 }
 
+void BrotliEncoderReset(BrotliEncoderState* state) {
+  MemoryManager* m = &state->memory_manager_;
+  if (BROTLI_IS_OOM(m)) {
+    /* Allocations are not reliable; start from scratch. */
+    BrotliEncoderCleanupState(state);
+    BrotliInitMemoryManager(m, m->alloc_func, m->free_func, m->opaque);
+    BrotliEncoderInitState(state);
+    return;
+  }
+  /* Buffers are kept; tables are (partially) cleared on first use, as for a
+     freshly allocated instance. */
+  RingBufferRecycle(&state->ringbuffer_);
+  HasherRecycle(&state->hasher_);
+  BrotliEncoderInitStreamState(state);
+}
+
+struct BrotliEncoderPreparedDictionaryStruct {
+  MemoryManager memory_manager_;
+  PreparedDictionary* dictionary;
+};
+
+BrotliEncoderPreparedDictionary* BrotliEncoderPrepareDictionary(
+    size_t data_size, const uint8_t data[BROTLI_ARRAY_PARAM(data_size)],
+    brotli_alloc_func alloc_func, brotli_free_func free_func, void* opaque) {
+  BrotliEncoderPreparedDictionary* result = 0;
+  MemoryManager* m;
+  if (data_size > BROTLI_MAX_PREPARED_DICTIONARY_SIZE) return 0;
+  if (!alloc_func && !free_func) {
+    result = (BrotliEncoderPreparedDictionary*)malloc(
+        sizeof(BrotliEncoderPreparedDictionary));
+  } else if (alloc_func && free_func) {
+    result = (BrotliEncoderPreparedDictionary*)alloc_func(
+        opaque, sizeof(BrotliEncoderPreparedDictionary));
+  }
+  if (result == 0) return 0;
+  m = &result->memory_manager_;
+  BrotliInitMemoryManager(m, alloc_func, free_func, opaque);
+  result->dictionary = CreatePreparedDictionary(m, data, data_size);
+  if (BROTLI_IS_OOM(m) || !result->dictionary) {
+    BrotliWipeOutMemoryManager(m);
+    m->free_func(m->opaque, result);
+    return 0;
+  }
+  return result;
+}
+
+void BrotliEncoderDestroyPreparedDictionary(
+    BrotliEncoderPreparedDictionary* dictionary) {
+  if (!dictionary) {
+    return;
+  } else {
+    MemoryManager* m = &dictionary->memory_manager_;
+    brotli_free_func free_func = m->free_func;
+    void* opaque = m->opaque;
+    DestroyPreparedDictionary(m, dictionary->dictionary);
+    free_func(opaque, dictionary);
+  }
+}
+
+BROTLI_BOOL BrotliEncoderAttachPreparedDictionary(
+    BrotliEncoderState* state,
+    const BrotliEncoderPreparedDictionary* dictionary) {
+  if (state->is_initialized_ || !dictionary) return BROTLI_FALSE;
+  return AttachPreparedDictionary(
+      &state->params.compound, dictionary->dictionary);
+}
+
 /*
    Copies the given input data to the internal ring buffer of the compressor.
    No processing of the data occurs at this time and this function can be
@@ -902,6 +1257,32 @@ static void CopyInputToRingBuffer(BrotliEncoderState* s,
   }
 }
 
+/* Returns the memory addressed by wrapped input positions: caller's input in
+   one-shot mode, ring buffer otherwise. */
+static const uint8_t* GetInputData(const BrotliEncoderState* s,
+                                   uint32_t* mask) {
+  if (s->stable_input_) {
+    *mask = BROTLI_UINT32_MAX;
+    return s->stable_input_;
+  }
+  *mask = s->ringbuffer_.mask_;
+  return s->ringbuffer_.buffer_;
+}
+
+/* Returns how many of |bytes| input bytes at |position| could be searched for
+   matches. Hashers read up to 7 bytes past the searched range; ring buffer
+   has slack for that, caller's input does not, so its last bytes become
+   literals. */
+static uint32_t SearchableInputSize(const BrotliEncoderState* s,
+                                    uint32_t position, uint32_t bytes) {
+  static const size_t kReadAheadSlack = 7;
+  size_t end;
+  if (!s->stable_input_) return bytes;
+  if (s->stable_input_size_ < position + kReadAheadSlack) return 0;
+  end = s->stable_input_size_ - kReadAheadSlack;
+  return (uint32_t)BROTLI_MIN(size_t, bytes, end - position);
+}
+
 /* Marks all input as processed.
    Returns true if position wrapping occurs. */
 static BROTLI_BOOL UpdateLastProcessedPos(BrotliEncoderState* s) {
@@ -914,8 +1295,8 @@ static BROTLI_BOOL UpdateLastProcessedPos(BrotliEncoderState* s) {
 static void ExtendLastCommand(BrotliEncoderState* s, uint32_t* bytes,
                               uint32_t* wrapped_last_processed_pos) {
   Command* last_command = &s->commands_[s->num_commands_ - 1];
-  const uint8_t* data = s->ringbuffer_.buffer_;
-  const uint32_t mask = s->ringbuffer_.mask_;
+  uint32_t mask;
+  const uint8_t* data = GetInputData(s, &mask);
   uint64_t max_backward_distance =
       (((uint64_t)1) << s->params.lgwin) - BROTLI_WINDOW_GAP;
   uint64_t last_copy_len = last_command->copy_len_ & 0x1FFFFFF;
@@ -945,6 +1326,71 @@ static void ExtendLastCommand(BrotliEncoderState* s, uint32_t* bytes,
   }
 }
 
+/* Input blocks smaller than this are never checked for being incompressible:
+   sampled entropy of smaller blocks is not reliable. */
+static const size_t kMinIncompressibleBlockSize = (size_t)1 << 15;
+
+/* Flushes the pending commands, if any, and stores the unprocessed input as
+   an uncompressed meta-block.
+   REQUIRED: the unprocessed input is covered by the last insert length. */
+static BROTLI_BOOL EncodeIncompressibleData(
+    BrotliEncoderState* s, const BROTLI_BOOL is_last,
+    size_t* out_size, uint8_t** output) {
+  MemoryManager* m = &s->memory_manager_;
+  uint32_t mask;
+  const uint8_t* data = GetInputData(s, &mask);
+  const uint32_t bytes = (uint32_t)UnprocessedInputSize(s);
+  const uint32_t pending_size =
+      (uint32_t)(s->last_processed_pos_ - s->last_flush_pos_);
+  uint8_t* storage = GetBrotliStorage(s, 2 * (pending_size + bytes) + 503);
+  size_t storage_ix = s->last_bytes_bits_;
+  if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+
+  BROTLI_DCHECK(s->last_insert_len_ >= bytes);
+  s->last_insert_len_ -= bytes;
+  storage[0] = (uint8_t)s->last_bytes_;
+  storage[1] = (uint8_t)(s->last_bytes_ >> 8);
+  if (pending_size != 0) {
+    ContextType literal_context_mode = ChooseContextMode(
+        &s->params, data, WrapPosition(s->last_flush_pos_),
+        mask, pending_size);
+    if (s->last_insert_len_ > 0) {
+      InitInsertCommand(&s->commands_[s->num_commands_++],
+                        s->last_insert_len_);
+      s->num_literals_ += s->last_insert_len_;
+      s->last_insert_len_ = 0;
+    }
+    BrotliBeginArena(m);
+    WriteMetaBlockInternal(
+        m, data, mask, s->last_flush_pos_, pending_size, BROTLI_FALSE,
+        literal_context_mode, &s->params, s->prev_byte_, s->prev_byte2_,
+        s->num_literals_, s->num_commands_, s->commands_, s->saved_dist_cache_,
+        s->dist_cache_, &storage_ix, storage);
+    BrotliEndArena(m);
+    if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+    s->num_commands_ = 0;
+    s->num_literals_ = 0;
+  }
+  BrotliStoreUncompressedMetaBlock(is_last, data,
+                                   WrapPosition(s->last_processed_pos_),
+                                   mask, bytes, &storage_ix, storage);
+
+  s->last_bytes_ = (uint16_t)(storage[storage_ix >> 3]);
+  s->last_bytes_bits_ = storage_ix & 7u;
+  s->last_flush_pos_ = s->input_pos_;
+  if (UpdateLastProcessedPos(s)) {
+    HasherReset(&s->hasher_);
+  }
+  s->prev_byte_ = data[((uint32_t)s->last_flush_pos_ - 1) & mask];
+  if (s->last_flush_pos_ > 1) {
+    s->prev_byte2_ = data[(uint32_t)(s->last_flush_pos_ - 2) & mask];
+  }
+  memcpy(s->saved_dist_cache_, s->dist_cache_, sizeof(s->saved_dist_cache_));
+  *output = &storage[0];
+  *out_size = storage_ix >> 3;
+  return BROTLI_TRUE;
+}
+
 /*
    Processes the accumulated input data and sets |*out_size| to the length of
    the new output meta-block, or to zero if no new output meta-block has been
@@ -963,14 +1409,15 @@ static BROTLI_BOOL EncodeData(
   const uint64_t delta = UnprocessedInputSize(s);
   uint32_t bytes = (uint32_t)delta;
   uint32_t wrapped_last_processed_pos = WrapPosition(s->last_processed_pos_);
-  uint8_t* data;
+  const uint8_t* data;
   uint32_t mask;
   MemoryManager* m = &s->memory_manager_;
   ContextType literal_context_mode;
   ContextLut literal_context_lut;
+  BROTLI_BOOL is_high_entropy;
+  uint32_t unsearched_bytes;
 
-  data = s->ringbuffer_.buffer_;
-  mask = s->ringbuffer_.mask_;
+  data = GetInputData(s, &mask);
 
   /* Adding more blocks after "last" block is forbidden. */
   if (s->is_last_block_emitted_) return BROTLI_FALSE;
@@ -997,6 +1444,8 @@ static BROTLI_BOOL EncodeData(
     size_t storage_ix = s->last_bytes_bits_;
     size_t table_size;
     int* table;
+    BrotliFragmentDictionary fragment_dictionary;
+    const BrotliFragmentDictionary* dictionary;
 
     if (delta == 0 && !is_last) {
       /* We have no new input data and we don't have to finish the stream, so
@@ -1010,6 +1459,8 @@ static BROTLI_BOOL EncodeData(
     storage[1] = (uint8_t)(s->last_bytes_ >> 8);
     table = GetHashTable(s, s->params.quality, bytes, &table_size);
     if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+    dictionary = GetFragmentDictionary(
+        s, s->last_processed_pos_, &fragment_dictionary);
     if (s->params.quality == FAST_ONE_PASS_COMPRESSION_QUALITY) {
       BrotliCompressFragmentFast(
           m, &data[wrapped_last_processed_pos & mask],
@@ -1017,7 +1468,7 @@ static BROTLI_BOOL EncodeData(
           table, table_size,
           s->cmd_depths_, s->cmd_bits_,
           &s->cmd_code_numbits_, s->cmd_code_,
-          &storage_ix, storage);
+          dictionary, &storage_ix, storage);
       if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
     } else {
       BrotliCompressFragmentTwoPass(
@@ -1025,7 +1476,7 @@ static BROTLI_BOOL EncodeData(
           bytes, is_last,
           s->command_buf_, s->literal_buf_,
           table, table_size,
-          &storage_ix, storage);
+          dictionary, &storage_ix, storage);
       if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
     }
     s->last_bytes_ = (uint16_t)(storage[storage_ix >> 3]);
@@ -1056,7 +1507,13 @@ static BROTLI_BOOL EncodeData(
   }
 
   InitOrStitchToPreviousBlock(m, &s->hasher_, data, mask, &s->params,
-      wrapped_last_processed_pos, bytes, is_last);
+      wrapped_last_processed_pos,
+      SearchableInputSize(s, wrapped_last_processed_pos, bytes), is_last);
+
+  /* Sampling is much cheaper than failing to find matches at every position
+     of already compressed or encrypted data. */
+  is_high_entropy = TO_BROTLI_BOOL(delta >= kMinIncompressibleBlockSize &&
+      IsHighEntropyData(data, mask, wrapped_last_processed_pos, bytes));
 
   literal_context_mode = ChooseContextMode(
       &s->params, data, WrapPosition(s->last_flush_pos_),
@@ -1069,29 +1526,66 @@ static BROTLI_BOOL EncodeData(
     ExtendLastCommand(s, &bytes, &wrapped_last_processed_pos);
   }
 
-  if (s->params.quality == ZOPFLIFICATION_QUALITY) {
-    BROTLI_DCHECK(s->params.hasher.type == 10);
-    BrotliCreateZopfliBackwardReferences(m, bytes, wrapped_last_processed_pos,
-        data, mask, literal_context_lut, &s->params,
-        &s->hasher_, s->dist_cache_,
-        &s->last_insert_len_, &s->commands_[s->num_commands_],
-        &s->num_commands_, &s->num_literals_);
-    if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
-  } else if (s->params.quality == HQ_ZOPFLIFICATION_QUALITY) {
+  unsearched_bytes =
+      bytes - SearchableInputSize(s, wrapped_last_processed_pos, bytes);
+  bytes -= unsearched_bytes;
+
+  if (s->params.quality >= ZOPFLIFICATION_QUALITY) {
+    /* In windowed mode the block is parsed in parts, so that the scratch
+       memory of optimal parsing does not depend on the input block size. */
+    const size_t window_size = s->params.windowed_zopfli ?
+        ZOPFLI_WINDOW_SIZE : bytes;
+    size_t parse_start = 0;
+    size_t offset;
     BROTLI_DCHECK(s->params.hasher.type == 10);
-    BrotliCreateHqZopfliBackwardReferences(m, bytes, wrapped_last_processed_pos,
-        data, mask, literal_context_lut, &s->params,
-        &s->hasher_, s->dist_cache_,
-        &s->last_insert_len_, &s->commands_[s->num_commands_],
-        &s->num_commands_, &s->num_literals_);
-    if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+    if (is_high_entropy) {
+      /* Data before the first match found by sparse search is not parsed;
+         if there is no match, whole block is stored as is below. */
+      parse_start = BrotliZopfliFindSparseMatch(bytes,
+          wrapped_last_processed_pos, data, mask, &s->params, &s->hasher_);
+      s->last_insert_len_ += parse_start;
+    }
+    offset = parse_start;
+    while (offset < bytes) {
+      const size_t size = BROTLI_MIN(size_t, bytes - offset, window_size);
+      const size_t position = wrapped_last_processed_pos + offset;
+      /* Sparse search has already stored positions before parse start. */
+      if (offset != parse_start) {
+        StitchToPreviousBlockH10(&s->hasher_.privat._H10, size, position,
+                                 data, mask);
+      }
+      BrotliBeginArena(m);
+      if (s->params.quality == ZOPFLIFICATION_QUALITY) {
+        BrotliCreateZopfliBackwardReferences(m, size, position,
+            data, mask, literal_context_lut, &s->params,
+            &s->hasher_, s->dist_cache_,
+            &s->last_insert_len_, &s->commands_[s->num_commands_],
+            &s->num_commands_, &s->num_literals_);
+      } else {
+        BrotliCreateHqZopfliBackwardReferences(m, size, position,
+            data, mask, literal_context_lut, &s->params,
+            &s->hasher_, s->dist_cache_,
+            &s->last_insert_len_, &s->commands_[s->num_commands_],
+            &s->num_commands_, &s->num_literals_);
+      }
+      BrotliEndArena(m);
+      if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+      offset += size;
+    }
   } else {
     BrotliCreateBackwardReferences(bytes, wrapped_last_processed_pos,
-        data, mask, literal_context_lut, &s->params,
+        data, mask, literal_context_lut, &s->params, is_high_entropy,
         &s->hasher_, s->dist_cache_,
         &s->last_insert_len_, &s->commands_[s->num_commands_],
         &s->num_commands_, &s->num_literals_);
   }
+  s->last_insert_len_ += unsearched_bytes;
+
+  /* Already compressed or encrypted input block is stored as is, unless
+     (sparse) match search has found something in it. */
+  if (is_high_entropy && s->last_insert_len_ >= delta) {
+    return EncodeIncompressibleData(s, is_last, out_size, output);
+  }
 
   {
     const size_t max_length = MaxMetablockSize(&s->params);
@@ -1144,11 +1638,14 @@ static BROTLI_BOOL EncodeData(
     if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
     storage[0] = (uint8_t)s->last_bytes_;
     storage[1] = (uint8_t)(s->last_bytes_ >> 8);
+    /* Histograms, block splits, etc. are released at once. */
+    BrotliBeginArena(m);
     WriteMetaBlockInternal(
         m, data, mask, s->last_flush_pos_, metablock_size, is_last,
         literal_context_mode, &s->params, s->prev_byte_, s->prev_byte2_,
         s->num_literals_, s->num_commands_, s->commands_, s->saved_dist_cache_,
         s->dist_cache_, &storage_ix, storage);
+    BrotliEndArena(m);
     if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
     s->last_bytes_ = (uint16_t)(storage[storage_ix >> 3]);
     s->last_bytes_bits_ = storage_ix & 7u;
@@ -1326,6 +1823,8 @@ static BROTLI_BOOL BrotliCompressBufferQuality10(
     is_last = TO_BROTLI_BOOL(metablock_start + metablock_size == input_size);
     storage = NULL;
     storage_ix = last_bytes_bits;
+    /* Everything allocated for this metablock is released at once. */
+    BrotliBeginArena(m);
 
     if (metablock_size == 0) {
       /* Write the ISLAST and ISEMPTY bits. */
@@ -1412,10 +1911,12 @@ static BROTLI_BOOL BrotliCompressBufferQuality10(
     }
     BROTLI_FREE(m, storage);
     BROTLI_FREE(m, commands);
+    BrotliEndArena(m);
   }
 
   *encoded_size = total_out_size;
   DestroyHasher(m, &hasher);
+  BrotliFreeArena(m);
   return ok;
 
 oom:
@@ -1468,8 +1969,8 @@ static size_t MakeUncompressedStream(
   return result;
 }
 
-BROTLI_BOOL BrotliEncoderCompress(
-    int quality, int lgwin, BrotliEncoderMode mode, size_t input_size,
+static BROTLI_BOOL CompressOneShot(int quality, int lgwin,
+    BrotliEncoderMode mode, uint32_t num_threads, size_t input_size,
     const uint8_t* input_buffer, size_t* encoded_size,
     uint8_t* encoded_buffer) {
   BrotliEncoderState* s;
@@ -1487,7 +1988,7 @@ BROTLI_BOOL BrotliEncoderCompress(
     *encoded_buffer = 6;
     return BROTLI_TRUE;
   }
-  if (quality == 10) {
+  if (quality == 10 && num_threads == 0) {
     /* TODO: Implement this direct path for all quality levels. */
     const int lg_win = BROTLI_MIN(int, BROTLI_LARGE_MAX_WINDOW_BITS,
                                        BROTLI_MAX(int, 16, lgwin));
@@ -1513,9 +2014,17 @@ BROTLI_BOOL BrotliEncoderCompress(
     BrotliEncoderSetParameter(s, BROTLI_PARAM_LGWIN, (uint32_t)lgwin);
     BrotliEncoderSetParameter(s, BROTLI_PARAM_MODE, (uint32_t)mode);
     BrotliEncoderSetParameter(s, BROTLI_PARAM_SIZE_HINT, (uint32_t)input_size);
+    BrotliEncoderSetParameter(s, BROTLI_PARAM_NUM_THREADS, num_threads);
     if (lgwin > BROTLI_MAX_WINDOW_BITS) {
       BrotliEncoderSetParameter(s, BROTLI_PARAM_LARGE_WINDOW, BROTLI_TRUE);
     }
+    /* Whole input is available and stays unchanged, so it is read in place
+       instead of being copied to ring buffer. Positions are not wrapped
+       below 3GiB (see WrapPosition). */
+    if (num_threads == 0 && input_size < ((size_t)3 << 30)) {
+      s->stable_input_ = input_buffer;
+      s->stable_input_size_ = input_size;
+    }
     result = BrotliEncoderCompressStream(s, BROTLI_OPERATION_FINISH,
         &available_in, &next_in, &available_out, &next_out, &total_out);
     if (!BrotliEncoderIsFinished(s)) result = 0;
@@ -1537,6 +2046,224 @@ fallback:
   return BROTLI_FALSE;
 }
 
+BROTLI_BOOL BrotliEncoderCompress(
+    int quality, int lgwin, BrotliEncoderMode mode, size_t input_size,
+    const uint8_t* input_buffer, size_t* encoded_size,
+    uint8_t* encoded_buffer) {
+  return CompressOneShot(quality, lgwin, mode, 0, input_size, input_buffer,
+                         encoded_size, encoded_buffer);
+}
+
+BROTLI_BOOL BrotliEncoderCompressParallel(
+    int quality, int lgwin, BrotliEncoderMode mode, uint32_t num_threads,
+    size_t input_size,
+    const uint8_t input_buffer[BROTLI_ARRAY_PARAM(input_size)],
+    size_t* encoded_size,
+    uint8_t encoded_buffer[BROTLI_ARRAY_PARAM(*encoded_size)]) {
+  if (num_threads == 0 || num_threads > BROTLI_MAX_THREADS) {
+    return BROTLI_FALSE;
+  }
+  return CompressOneShot(quality, lgwin, mode, num_threads, input_size,
+                         input_buffer, encoded_size, encoded_buffer);
+}
+
+/* Checks that |commands| cover the input exactly and refer only to preceding
+   input inside the window. */
+static BROTLI_BOOL ValidateExternalCommands(const BrotliEncoderParams* params,
+    size_t input_size, size_t num_commands,
+    const BrotliEncoderCommand* commands) {
+  const size_t max_backward_limit = BROTLI_MAX_BACKWARD_LIMIT(params->lgwin);
+  const size_t max_copy_length = MaxMetablockSize(params);
+  size_t pos = 0;
+  size_t i;
+  for (i = 0; i < num_commands; ++i) {
+    const BrotliEncoderCommand* cmd = &commands[i];
+    if (cmd->insert_length > input_size - pos) return BROTLI_FALSE;
+    pos += cmd->insert_length;
+    if (cmd->copy_length == 0) continue;
+    if (cmd->copy_length < 2 || cmd->copy_length > max_copy_length ||
+        cmd->copy_length > input_size - pos) {
+      return BROTLI_FALSE;
+    }
+    if (cmd->distance == 0 || cmd->distance > pos ||
+        cmd->distance > max_backward_limit) {
+      return BROTLI_FALSE;
+    }
+    pos += cmd->copy_length;
+  }
+  return TO_BROTLI_BOOL(pos == input_size);
+}
+
+BROTLI_BOOL BrotliEncoderCompressCommands(
+    int quality, int lgwin, BrotliEncoderMode mode, size_t input_size,
+    const uint8_t input_buffer[BROTLI_ARRAY_PARAM(input_size)],
+    size_t num_external_commands,
+    const BrotliEncoderCommand
+        external_commands[BROTLI_ARRAY_PARAM(num_external_commands)],
+    size_t* encoded_size,
+    uint8_t encoded_buffer[BROTLI_ARRAY_PARAM(*encoded_size)]) {
+  MemoryManager memory_manager;
+  MemoryManager* m = &memory_manager;
+
+  const size_t mask = BROTLI_SIZE_MAX >> 1;
+  int dist_cache[4] = { 4, 11, 15, 16 };
+  int saved_dist_cache[4] = { 4, 11, 15, 16 };
+  BROTLI_BOOL ok = BROTLI_TRUE;
+  const size_t max_out_size = *encoded_size;
+  size_t total_out_size = 0;
+  uint16_t last_bytes;
+  uint8_t last_bytes_bits;
+
+  BrotliEncoderParams params;
+  size_t max_metablock_size;
+  size_t max_backward_limit;
+  size_t metablock_start = 0;
+  /* Index of the next external command and number of its literals that
+     were already emitted in previous metablock. */
+  size_t next_command = 0;
+  size_t taken_insert_length = 0;
+  uint8_t prev_byte = 0;
+  uint8_t prev_byte2 = 0;
+
+  *encoded_size = 0;
+  BrotliEncoderInitParams(&params);
+  params.quality = BROTLI_MAX(int, MAX_QUALITY_FOR_STATIC_ENTROPY_CODES,
+                              quality);
+  params.lgwin = lgwin;
+  params.mode = mode;
+  params.size_hint = input_size;
+  if (lgwin > BROTLI_MAX_WINDOW_BITS) {
+    params.large_window = BROTLI_TRUE;
+  }
+  SanitizeParams(&params);
+  params.lgblock = ComputeLgBlock(&params);
+  ChooseDistanceParams(&params);
+  max_metablock_size = MaxMetablockSize(&params);
+  max_backward_limit = BROTLI_MAX_BACKWARD_LIMIT(params.lgwin);
+
+  if (!ValidateExternalCommands(&params, input_size, num_external_commands,
+                                external_commands)) {
+    return BROTLI_FALSE;
+  }
+  if (max_out_size == 0) return BROTLI_FALSE;
+  if (input_size == 0) {
+    *encoded_size = 1;
+    *encoded_buffer = 6;
+    return BROTLI_TRUE;
+  }
+
+  BrotliInitMemoryManager(m, 0, 0, 0);
+  EncodeWindowBits(params.lgwin, params.large_window,
+                   &last_bytes, &last_bytes_bits);
+
+  while (ok && metablock_start < input_size) {
+    const size_t metablock_limit = metablock_start + max_metablock_size;
+    const size_t max_literals = max_metablock_size / 8;
+    const size_t max_commands = max_metablock_size / 8;
+    size_t pos = metablock_start;
+    size_t last_insert_len = 0;
+    size_t num_commands = 0;
+    size_t num_literals = 0;
+    size_t metablock_size;
+    BROTLI_BOOL is_last;
+    ContextType literal_context_mode;
+    Command* commands;
+    uint8_t* storage;
+    size_t storage_ix = last_bytes_bits;
+
+    /* Everything allocated for this metablock is released at once. */
+    BrotliBeginArena(m);
+    /* Each command, except the trailing insert, copies at least 2 bytes. */
+    commands = BROTLI_ALLOC(m, Command, max_metablock_size / 2 + 1);
+    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(commands)) goto oom;
+
+    while (next_command < num_external_commands &&
+           num_literals < max_literals && num_commands < max_commands) {
+      const BrotliEncoderCommand* cmd = &external_commands[next_command];
+      const size_t insert_length = cmd->insert_length - taken_insert_length;
+      const size_t copy_length = cmd->copy_length;
+      if (insert_length + copy_length > metablock_limit - pos) {
+        /* Literals that fit are emitted with this metablock; backward
+           reference goes to the next one. */
+        const size_t fit = BROTLI_MIN(size_t, insert_length,
+                                      metablock_limit - pos);
+        last_insert_len += fit;
+        taken_insert_length += fit;
+        pos += fit;
+        break;
+      }
+      last_insert_len += insert_length;
+      taken_insert_length = 0;
+      pos += insert_length;
+      next_command++;
+      if (copy_length != 0) {
+        const size_t distance = cmd->distance;
+        const size_t distance_code = ComputeDistanceCode(
+            distance, max_backward_limit, dist_cache);
+        InitCommand(&commands[num_commands++], &params.dist, last_insert_len,
+                    copy_length, 0, distance_code);
+        if (distance_code > 0) {
+          dist_cache[3] = dist_cache[2];
+          dist_cache[2] = dist_cache[1];
+          dist_cache[1] = dist_cache[0];
+          dist_cache[0] = (int)distance;
+        }
+        num_literals += last_insert_len;
+        last_insert_len = 0;
+        pos += copy_length;
+      }
+    }
+    if (last_insert_len > 0) {
+      InitInsertCommand(&commands[num_commands++], last_insert_len);
+      num_literals += last_insert_len;
+    }
+
+    metablock_size = pos - metablock_start;
+    is_last = TO_BROTLI_BOOL(pos == input_size);
+    literal_context_mode = ChooseContextMode(
+        &params, input_buffer, metablock_start, mask, metablock_size);
+    storage = BROTLI_ALLOC(m, uint8_t, 2 * metablock_size + 503);
+    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(storage)) goto oom;
+    storage[0] = (uint8_t)last_bytes;
+    storage[1] = (uint8_t)(last_bytes >> 8);
+    /* Metablock is addressed from its start: only its own bytes are read, and
+       positions are not subject to ring buffer wrapping. */
+    WriteMetaBlockInternal(m, input_buffer + metablock_start, mask, 0,
+        metablock_size, is_last, literal_context_mode, &params, prev_byte,
+        prev_byte2, num_literals, num_commands, commands, saved_dist_cache,
+        dist_cache, &storage_ix, storage);
+    if (BROTLI_IS_OOM(m)) goto oom;
+    last_bytes = (uint16_t)(storage[storage_ix >> 3]);
+    last_bytes_bits = storage_ix & 7u;
+    metablock_start += metablock_size;
+    prev_byte = input_buffer[metablock_start - 1];
+    prev_byte2 = (metablock_start > 1) ? input_buffer[metablock_start - 2] : 0;
+    memcpy(saved_dist_cache, dist_cache, 4 * sizeof(dist_cache[0]));
+
+    {
+      const size_t out_size = storage_ix >> 3;
+      total_out_size += out_size;
+      if (total_out_size <= max_out_size) {
+        memcpy(encoded_buffer, storage, out_size);
+        encoded_buffer += out_size;
+      } else {
+        ok = BROTLI_FALSE;
+      }
+    }
+    BROTLI_FREE(m, storage);
+    BROTLI_FREE(m, commands);
+    BrotliEndArena(m);
+  }
+
+  *encoded_size = ok ? total_out_size : 0;
+  BrotliFreeArena(m);
+  return ok;
+
+oom:
+  BrotliWipeOutMemoryManager(m);
+  return BROTLI_FALSE;
+}
+
 static void InjectBytePaddingBlock(BrotliEncoderState* s) {
   uint32_t seal = s->last_bytes_;
   size_t seal_bits = s->last_bytes_bits_;
@@ -1658,6 +2385,8 @@ static BROTLI_BOOL BrotliEncoderCompressStreamFast(
       size_t storage_ix = s->last_bytes_bits_;
       size_t table_size;
       int* table;
+      BrotliFragmentDictionary fragment_dictionary;
+      const BrotliFragmentDictionary* dictionary;
 
       if (force_flush && block_size == 0) {
         s->stream_state_ = BROTLI_STREAM_FLUSH_REQUESTED;
@@ -1674,21 +2403,28 @@ static BROTLI_BOOL BrotliEncoderCompressStreamFast(
       storage[1] = (uint8_t)(s->last_bytes_ >> 8);
       table = GetHashTable(s, s->params.quality, block_size, &table_size);
       if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+      dictionary =
+          GetFragmentDictionary(s, s->input_pos_, &fragment_dictionary);
 
       if (s->params.quality == FAST_ONE_PASS_COMPRESSION_QUALITY) {
         BrotliCompressFragmentFast(m, *next_in, block_size, is_last, table,
             table_size, s->cmd_depths_, s->cmd_bits_, &s->cmd_code_numbits_,
-            s->cmd_code_, &storage_ix, storage);
+            s->cmd_code_, dictionary, &storage_ix, storage);
         if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
       } else {
         BrotliCompressFragmentTwoPass(m, *next_in, block_size, is_last,
             command_buf, literal_buf, table, table_size,
-            &storage_ix, storage);
+            dictionary, &storage_ix, storage);
         if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
       }
       if (block_size != 0) {
         *next_in += block_size;
         *available_in -= block_size;
+        /* Direct input does not pass the ring buffer; still track it, so that
+           static dictionary references know the stream position. */
+        s->input_pos_ += block_size;
+        s->last_processed_pos_ = s->input_pos_;
+        s->last_flush_pos_ = s->input_pos_;
       }
       if (inplace) {
         size_t out_bytes = storage_ix >> 3;
@@ -1718,6 +2454,340 @@ static BROTLI_BOOL BrotliEncoderCompressStreamFast(
   return BROTLI_TRUE;
 }
 
+/* Prepares segment encoder |s| for compressing the part of input that starts
+   at |position| (relative to |params|->stream_offset). |head| and |tail| are
+   the two parts of the data that immediately precedes the segment; it is
+   loaded to ring buffer and hasher, so that it could be referenced.
+   |zopfli_threads| is the number of threads segment encoder could use for
+   shortest path search. */
+static BROTLI_BOOL InitSegmentEncoder(BrotliEncoderState* s,
+    const BrotliEncoderParams* params, uint32_t zopfli_threads,
+    uint64_t position,
+    BROTLI_BOOL emit_header, const uint8_t* head, size_t head_size,
+    const uint8_t* tail, size_t tail_size) {
+  MemoryManager* m = &s->memory_manager_;
+  const size_t prefix_size = head_size + tail_size;
+  const uint64_t offset = params->stream_offset + position - prefix_size;
+  s->params = *params;
+  s->params.num_threads = 0;
+  s->params.zopfli_threads = zopfli_threads;
+  /* Parameters are already fit into the memory limit by parent encoder. */
+  s->params.memory_limit = 0;
+  s->params.stream_offset =
+      (offset < (1u << 30)) ? (size_t)offset : (size_t)(1u << 30);
+  if (!EnsureInitialized(s)) return BROTLI_FALSE;
+
+  if (!emit_header) {
+    s->last_bytes_ = 0;
+    s->last_bytes_bits_ = 0;
+  }
+  if (position != 0) {
+    /* Distance cache state is not known. */
+    s->dist_cache_[0] = -16;
+    s->dist_cache_[1] = -16;
+    s->dist_cache_[2] = -16;
+    s->dist_cache_[3] = -16;
+    memcpy(s->saved_dist_cache_, s->dist_cache_, sizeof(s->saved_dist_cache_));
+  }
+  if (prefix_size == 0) return BROTLI_TRUE;
+
+  if (head_size != 0) CopyInputToRingBuffer(s, head_size, head);
+  if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+  if (tail_size != 0) CopyInputToRingBuffer(s, tail_size, tail);
+  if (BROTLI_IS_OOM(m)) return BROTLI_FALSE;
+  s->last_flush_pos_ = s->input_pos_;
+  s->last_processed_pos_ = s->input_pos_;
+  s->prev_byte_ = s->ringbuffer_.buffer_[prefix_size - 1];
+  if (prefix_size > 1) {
+    s->prev_byte2_ = s->ringbuffer_.buffer_[prefix_size - 2];
+    /* Literal context is the same as in decoder; no need to "unwire" it. */
+    s->flint_ = BROTLI_FLINT_DONE;
+  }
+  HasherPrependCustomDictionary(m, &s->hasher_, &s->params, prefix_size,
+                                s->ringbuffer_.buffer_);
+  return TO_BROTLI_BOOL(!BROTLI_IS_OOM(m));
+}
+
+typedef struct SegmentTask {
+  size_t offset;
+  size_t size;
+  BROTLI_BOOL is_last;
+  BROTLI_BOOL ok;
+  uint8_t* output;
+  size_t output_size;
+  size_t output_capacity;
+} SegmentTask;
+
+/* Set of segments that are compressed concurrently. Segment encoders are
+   independent; output buffers are allocated directly with allocator
+   functions, because memory manager is not thread-safe. */
+typedef struct SegmentBatch {
+  const BrotliEncoderParams* params;
+  brotli_alloc_func alloc_func;
+  brotli_free_func free_func;
+  void* opaque;
+  /* Data that precedes |data|. */
+  const uint8_t* history;
+  size_t history_size;
+  /* Maximal size of priming data. */
+  size_t window;
+  const uint8_t* data;
+  uint64_t position;
+  BROTLI_BOOL emit_header;
+  /* Threads left idle by segment level parallelism. */
+  uint32_t zopfli_threads;
+  SegmentTask* tasks;
+} SegmentBatch;
+
+static BROTLI_BOOL AppendSegmentOutput(const SegmentBatch* batch,
+    SegmentTask* task, const uint8_t* data, size_t size) {
+  if (task->output_size + size > task->output_capacity) {
+    size_t capacity = BROTLI_MAX(size_t,
+        2 * task->output_capacity, task->output_size + size);
+    uint8_t* output = (uint8_t*)batch->alloc_func(batch->opaque, capacity);
+    if (!output) return BROTLI_FALSE;
+    if (task->output_size != 0) {
+      memcpy(output, task->output, task->output_size);
+    }
+    batch->free_func(batch->opaque, task->output);
+    task->output = output;
+    task->output_capacity = capacity;
+  }
+  memcpy(task->output + task->output_size, data, size);
+  task->output_size += size;
+  return BROTLI_TRUE;
+}
+
+static void CompressSegment(void* context, size_t index) {
+  SegmentBatch* batch = (SegmentBatch*)context;
+  SegmentTask* task = &batch->tasks[index];
+  BrotliEncoderOperation op =
+      task->is_last ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+  const uint8_t* next_in = batch->data + task->offset;
+  size_t available_in = task->size;
+  uint8_t* next_out = NULL;
+  size_t available_out = 0;
+  size_t tail_size = BROTLI_MIN(size_t, task->offset, batch->window);
+  size_t head_size =
+      BROTLI_MIN(size_t, batch->history_size, batch->window - tail_size);
+  BrotliEncoderState* s = BrotliEncoderCreateInstance(
+      batch->alloc_func, batch->free_func, batch->opaque);
+  if (!s) return;
+  if (InitSegmentEncoder(s, batch->params, batch->zopfli_threads,
+      batch->position + task->offset,
+      TO_BROTLI_BOOL(index == 0 && batch->emit_header),
+      batch->history + batch->history_size - head_size, head_size,
+      batch->data + task->offset - tail_size, tail_size)) {
+    while (BROTLI_TRUE) {
+      size_t out_size = 0;
+      const uint8_t* out;
+      if (!BrotliEncoderCompressStream(s, op, &available_in, &next_in,
+          &available_out, &next_out, NULL)) {
+        break;
+      }
+      out = BrotliEncoderTakeOutput(s, &out_size);
+      if (out_size != 0) {
+        if (!AppendSegmentOutput(batch, task, out, out_size)) break;
+        continue;
+      }
+      if (available_in == 0 && (task->is_last ?
+          BrotliEncoderIsFinished(s) :
+          s->stream_state_ == BROTLI_STREAM_PROCESSING)) {
+        task->ok = BROTLI_TRUE;
+        break;
+      }
+    }
+  }
+  BrotliEncoderDestroyInstance(s);
+}
+
+static BROTLI_BOOL EnsureSegmentBuffer(BrotliEncoderState* s, size_t size) {
+  MemoryManager* m = &s->memory_manager_;
+  uint8_t* new_buf;
+  if (s->segment_buf_size_ >= size) return BROTLI_TRUE;
+  new_buf = BROTLI_ALLOC(m, uint8_t, size);
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(new_buf)) return BROTLI_FALSE;
+  if (s->segment_buf_) {
+    memcpy(new_buf, s->segment_buf_,
+           s->segment_history_ + s->segment_pending_);
+    BROTLI_FREE(m, s->segment_buf_);
+  }
+  s->segment_buf_ = new_buf;
+  s->segment_buf_size_ = size;
+  return BROTLI_TRUE;
+}
+
+/* Compresses |size| bytes of |data| in segments using multiple threads.
+   |data| is either external or points to pending data in |segment_buf_|.
+   Output is stored in internal storage; it is always byte-aligned. */
+static BROTLI_BOOL CompressSegments(BrotliEncoderState* s,
+    const uint8_t* data, size_t size, BROTLI_BOOL is_last) {
+  MemoryManager* m = &s->memory_manager_;
+  const size_t segment_size = (size_t)1 << ComputeLgSegment(&s->params);
+  const size_t window = SegmentWindowSize(&s->params);
+  size_t num_tasks = (size + segment_size - 1) / segment_size;
+  size_t total_size = 0;
+  BROTLI_BOOL ok = BROTLI_TRUE;
+  SegmentBatch batch;
+  SegmentTask* tasks;
+  size_t i;
+  /* Last segment might be empty. */
+  if (num_tasks == 0) num_tasks = 1;
+  tasks = BROTLI_ALLOC(m, SegmentTask, num_tasks);
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(tasks)) return BROTLI_FALSE;
+  for (i = 0; i < num_tasks; ++i) {
+    tasks[i].offset = i * segment_size;
+    tasks[i].size = BROTLI_MIN(size_t, segment_size, size - tasks[i].offset);
+    tasks[i].is_last = TO_BROTLI_BOOL(is_last && (i + 1 == num_tasks));
+    tasks[i].ok = BROTLI_FALSE;
+    tasks[i].output = NULL;
+    tasks[i].output_size = 0;
+    tasks[i].output_capacity = 0;
+  }
+  batch.params = &s->params;
+  batch.alloc_func = m->alloc_func;
+  batch.free_func = m->free_func;
+  batch.opaque = m->opaque;
+  batch.history = s->segment_buf_;
+  batch.history_size = s->segment_history_;
+  batch.window = window;
+  batch.data = data;
+  batch.position = s->last_flush_pos_;
+  /* Stream header is not emitted yet. */
+  batch.emit_header = TO_BROTLI_BOOL(s->last_bytes_bits_ != 0);
+  batch.zopfli_threads =
+      (uint32_t)BROTLI_MAX(size_t, 1, s->params.num_threads / num_tasks);
+  batch.tasks = tasks;
+
+  BrotliRunWorkers(CompressSegment, &batch, num_tasks, s->params.num_threads);
+
+  for (i = 0; i < num_tasks; ++i) {
+    if (!tasks[i].ok) ok = BROTLI_FALSE;
+    total_size += tasks[i].output_size;
+  }
+  if (ok && total_size != 0) {
+    uint8_t* storage = GetBrotliStorage(s, total_size);
+    if (BROTLI_IS_OOM(m)) {
+      ok = BROTLI_FALSE;
+    } else {
+      s->next_out_ = storage;
+      s->available_out_ = total_size;
+      for (i = 0; i < num_tasks; ++i) {
+        memcpy(storage, tasks[i].output, tasks[i].output_size);
+        storage += tasks[i].output_size;
+      }
+    }
+  }
+  for (i = 0; i < num_tasks; ++i) {
+    batch.free_func(batch.opaque, tasks[i].output);
+  }
+  BROTLI_FREE(m, tasks);
+  if (!ok) return BROTLI_FALSE;
+
+  s->last_bytes_ = 0;
+  s->last_bytes_bits_ = 0;
+  s->input_pos_ += size;
+  s->last_flush_pos_ = s->input_pos_;
+  s->last_processed_pos_ = s->input_pos_;
+  s->segment_pending_ = 0;
+  if (is_last) return BROTLI_TRUE;
+
+  /* Keep the tail of (history + data) for priming the next segments. Moving
+     history before data is safe even if data is in the same buffer. */
+  {
+    size_t keep = BROTLI_MIN(size_t, window, s->segment_history_ + size);
+    if (keep == 0) return BROTLI_TRUE;
+    if (!EnsureSegmentBuffer(s, keep)) return BROTLI_FALSE;
+    if (keep > size) {
+      size_t old = keep - size;
+      memmove(s->segment_buf_,
+              s->segment_buf_ + s->segment_history_ - old, old);
+      memmove(s->segment_buf_ + old, data, size);
+    } else {
+      memmove(s->segment_buf_, data + size - keep, keep);
+    }
+    s->segment_history_ = keep;
+  }
+  return BROTLI_TRUE;
+}
+
+/* Counterpart of BrotliEncoderCompressStream for "segmented" mode. Input is
+   accumulated until there is enough data for all the threads, unless
+   flush / finish is requested. Segments are cut at fixed offsets from the
+   previous flush point, so output does not depend on the number of
+   threads. */
+static BROTLI_BOOL BrotliEncoderCompressStreamSegmented(
+    BrotliEncoderState* s, BrotliEncoderOperation op, size_t* available_in,
+    const uint8_t** next_in, size_t* available_out, uint8_t** next_out,
+    size_t* total_out) {
+  const size_t batch_size =
+      ((size_t)1 << ComputeLgSegment(&s->params)) * s->params.num_threads;
+  /* Size hint is used for choosing hashers; it should be the same for all
+     the segments. */
+  if (s->params.size_hint == 0 &&
+      (*available_in != 0 || op != BROTLI_OPERATION_PROCESS)) {
+    s->params.size_hint = BROTLI_MIN(size_t, *available_in, 1u << 30);
+  }
+  while (BROTLI_TRUE) {
+    if (InjectFlushOrPushOutput(s, available_out, next_out, total_out)) {
+      continue;
+    }
+    if (s->available_out_ != 0 ||
+        s->stream_state_ != BROTLI_STREAM_PROCESSING) {
+      break;
+    }
+
+    if (s->segment_pending_ == 0 && *available_in != 0 &&
+        (*available_in >= batch_size || op != BROTLI_OPERATION_PROCESS)) {
+      /* Compress directly from input. */
+      size_t size = BROTLI_MIN(size_t, *available_in, batch_size);
+      BROTLI_BOOL is_last = TO_BROTLI_BOOL(
+          (*available_in == size) && op == BROTLI_OPERATION_FINISH);
+      BROTLI_BOOL force_flush = TO_BROTLI_BOOL(
+          (*available_in == size) && op == BROTLI_OPERATION_FLUSH);
+      if (!CompressSegments(s, *next_in, size, is_last)) return BROTLI_FALSE;
+      *next_in += size;
+      *available_in -= size;
+      if (force_flush) s->stream_state_ = BROTLI_STREAM_FLUSH_REQUESTED;
+      if (is_last) s->stream_state_ = BROTLI_STREAM_FINISHED;
+      continue;
+    }
+
+    if (*available_in != 0 && s->segment_pending_ < batch_size) {
+      size_t copy_input_size = BROTLI_MIN(size_t,
+          batch_size - s->segment_pending_, *available_in);
+      if (!EnsureSegmentBuffer(s, SegmentWindowSize(&s->params) + batch_size)) {
+        return BROTLI_FALSE;
+      }
+      memcpy(s->segment_buf_ + s->segment_history_ + s->segment_pending_,
+             *next_in, copy_input_size);
+      *next_in += copy_input_size;
+      *available_in -= copy_input_size;
+      s->segment_pending_ += copy_input_size;
+      continue;
+    }
+
+    if (s->segment_pending_ == batch_size || op != BROTLI_OPERATION_PROCESS) {
+      BROTLI_BOOL is_last = TO_BROTLI_BOOL(
+          (*available_in == 0) && op == BROTLI_OPERATION_FINISH);
+      BROTLI_BOOL force_flush = TO_BROTLI_BOOL(
+          (*available_in == 0) && op == BROTLI_OPERATION_FLUSH);
+      if (s->segment_pending_ != 0 || is_last) {
+        if (!CompressSegments(s, s->segment_buf_ + s->segment_history_,
+            s->segment_pending_, is_last)) {
+          return BROTLI_FALSE;
+        }
+      }
+      if (force_flush) s->stream_state_ = BROTLI_STREAM_FLUSH_REQUESTED;
+      if (is_last) s->stream_state_ = BROTLI_STREAM_FINISHED;
+      continue;
+    }
+    break;
+  }
+  CheckFlushComplete(s);
+  return BROTLI_TRUE;
+}
+
 static BROTLI_BOOL ProcessMetadata(
     BrotliEncoderState* s, size_t* available_in, const uint8_t** next_in,
     size_t* available_out, uint8_t** next_out, size_t* total_out) {
@@ -1738,6 +2808,14 @@ static BROTLI_BOOL ProcessMetadata(
     }
     if (s->available_out_ != 0) break;
 
+    if (s->segment_pending_ != 0) {
+      BROTLI_BOOL result = CompressSegments(s,
+          s->segment_buf_ + s->segment_history_, s->segment_pending_,
+          BROTLI_FALSE);
+      if (!result) return BROTLI_FALSE;
+      continue;
+    }
+
     if (s->input_pos_ != s->last_flush_pos_) {
       BROTLI_BOOL result = EncodeData(s, BROTLI_FALSE, BROTLI_TRUE,
           &s->available_out_, &s->next_out_);
@@ -1805,6 +2883,11 @@ BROTLI_BOOL BrotliEncoderCompressStream(
     BrotliEncoderState* s, BrotliEncoderOperation op, size_t* available_in,
     const uint8_t** next_in, size_t* available_out,uint8_t** next_out,
     size_t* total_out) {
+  if (!s->is_initialized_ && s->params.memory_limit != 0 &&
+      s->params.size_hint == 0 && op == BROTLI_OPERATION_FINISH) {
+    /* Whole input is known; make it count for memory limit. */
+    s->params.size_hint = BROTLI_MIN(size_t, *available_in, 1u << 30);
+  }
   if (!EnsureInitialized(s)) return BROTLI_FALSE;
 
   /* Unfinished metadata block; check requirements. */
@@ -1827,6 +2910,10 @@ BROTLI_BOOL BrotliEncoderCompressStream(
   if (s->stream_state_ != BROTLI_STREAM_PROCESSING && *available_in != 0) {
     return BROTLI_FALSE;
   }
+  if (s->params.num_threads != 0) {
+    return BrotliEncoderCompressStreamSegmented(s, op, available_in, next_in,
+        available_out, next_out, total_out);
+  }
   if (s->params.quality == FAST_ONE_PASS_COMPRESSION_QUALITY ||
       s->params.quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
     return BrotliEncoderCompressStreamFast(s, op, available_in, next_in,
@@ -1842,7 +2929,12 @@ BROTLI_BOOL BrotliEncoderCompressStream(
     if (remaining_block_size != 0 && *available_in != 0) {
       size_t copy_input_size =
           BROTLI_MIN(size_t, remaining_block_size, *available_in);
-      CopyInputToRingBuffer(s, copy_input_size, *next_in);
+      if (s->stable_input_) {
+        BROTLI_DCHECK(*next_in == s->stable_input_ + s->input_pos_);
+        s->input_pos_ += copy_input_size;
+      } else {
+        CopyInputToRingBuffer(s, copy_input_size, *next_in);
+      }
       *next_in += copy_input_size;
       *available_in -= copy_input_size;
       if (s->flint_ > 0) s->flint_ = (int8_t)(s->flint_ - (int)copy_input_size);
@@ -1876,9 +2968,22 @@ BROTLI_BOOL BrotliEncoderCompressStream(
           force_flush = BROTLI_TRUE;
         }
         UpdateSizeHint(s, *available_in);
+        /* Metablock is written straight to |next_out| if it surely fits. */
+        s->inplace_out_ = *next_out;
+        s->inplace_out_size_ = *available_out;
         result = EncodeData(s, is_last, force_flush,
             &s->available_out_, &s->next_out_);
+        s->inplace_out_size_ = 0;
         if (!result) return BROTLI_FALSE;
+        if (s->available_out_ != 0 && s->next_out_ == *next_out) {
+          BROTLI_DCHECK(s->available_out_ <= *available_out);
+          *next_out += s->available_out_;
+          *available_out -= s->available_out_;
+          s->total_out_ += s->available_out_;
+          if (total_out) *total_out = s->total_out_;
+          s->next_out_ = NULL;
+          s->available_out_ = 0;
+        }
         if (force_flush) s->stream_state_ = BROTLI_STREAM_FLUSH_REQUESTED;
         if (is_last) s->stream_state_ = BROTLI_STREAM_FINISHED;
         continue;
@@ -23,6 +23,7 @@ void BrotliInitEncoderDictionary(BrotliEncoderDictionary* dict) {
   dict->hash_table_lengths = kStaticDictionaryHashLengths;
   dict->buckets = kStaticDictionaryBuckets;
   dict->dict_words = kStaticDictionaryWords;
+  dict->prefix_bloom = kStaticDictionaryPrefixBloom;
 
   dict->cutoffTransformsCount = kCutoffTransformsCount;
   dict->cutoffTransforms = kCutoffTransforms;
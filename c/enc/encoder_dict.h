@@ -10,6 +10,7 @@
 #include "../common/dictionary.h"
 #include "../common/platform.h"
 #include <brotli/types.h>
+#include "./find_match_length.h"
 #include "./static_dict_lut.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -32,8 +33,82 @@ typedef struct BrotliEncoderDictionary {
   /* from static_dict_lut.h, for slow encoder */
   const uint16_t* buckets;
   const DictWord* dict_words;
+  /* Prefilter over the 4-byte prefixes of the words above. */
+  const uint32_t* prefix_bloom;
 } BrotliEncoderDictionary;
 
+/* Static dictionary references for the fast (one- and two-pass) encoders. */
+typedef struct BrotliFragmentDictionary {
+  const BrotliEncoderDictionary* dictionary;
+  /* Position of the fragment start in the decoded stream. */
+  size_t position;
+  /* Maximal backward distance of the stream window. */
+  size_t max_backward_limit;
+  /* Size of attached dictionaries that precede the static dictionary. */
+  size_t gap;
+} BrotliFragmentDictionary;
+
+/* Returns BROTLI_FALSE if no dictionary word (in any of its uppercase
+   transform forms) starts with the 4 bytes at "data". False positives are
+   possible; false negatives are not. */
+static BROTLI_INLINE BROTLI_BOOL BrotliMayStartDictionaryWord(
+    const BrotliEncoderDictionary* dictionary, const uint8_t* data) {
+  const uint32_t h = BROTLI_UNALIGNED_LOAD32LE(data) * kDictHashMul32;
+  const uint32_t mask =
+      (1u << ((h >> (32 - kDictPrefixBloomBits - 5)) & 31)) |
+      (1u << ((h >> (32 - kDictPrefixBloomBits - 10)) & 31));
+  return TO_BROTLI_BOOL(
+      (dictionary->prefix_bloom[h >> (32 - kDictPrefixBloomBits)] & mask) ==
+      mask);
+}
+
+/* Largest distance that is coded with at most 22 extra bits; longer distance
+   codes have zero depth in the default command and distance prefix codes of
+   the fast encoders. */
+#define BROTLI_MAX_FRAGMENT_DICTIONARY_DISTANCE ((1u << 24) - 4)
+
+/* Looks up the static dictionary words that share the hash of the first 4
+   bytes at "ip". Returns the number of bytes covered by the best one, or 0 if
+   none of them matches at least "min_match" bytes; in the latter case
+   "copy_len" and "distance" are not touched. "position" is the position of
+   "ip" in the decoded stream. */
+static BROTLI_INLINE size_t BrotliFindFragmentDictionaryMatch(
+    const BrotliFragmentDictionary* dictionary, const uint8_t* ip,
+    size_t position, size_t max_length, size_t min_match,
+    size_t* copy_len, size_t* distance) {
+  const BrotliEncoderDictionary* dict = dictionary->dictionary;
+  const BrotliDictionary* words = dict->words;
+  const size_t dictionary_start = BROTLI_MIN(size_t, position,
+      dictionary->max_backward_limit) + dictionary->gap + 1;
+  size_t key = (size_t)((BROTLI_UNALIGNED_LOAD32LE(ip) * kDictHashMul32) >>
+      (32 - 14)) << 1;
+  size_t best = 0;
+  size_t i;
+  for (i = 0; i < 2; ++i, ++key) {
+    const size_t len = dict->hash_table_lengths[key];
+    if (len != 0 && len <= max_length) {
+      const size_t word_idx = dict->hash_table_words[key];
+      const size_t offset = words->offsets_by_length[len] + len * word_idx;
+      const size_t matched =
+          FindMatchLengthWithLimit(ip, &words->data[offset], len);
+      if (matched > best && matched >= min_match &&
+          matched + dict->cutoffTransformsCount > len) {
+        const size_t cut = len - matched;
+        const size_t transform_id = (cut << 2) +
+            (size_t)((dict->cutoffTransforms >> (cut * 6)) & 0x3F);
+        const size_t backward = dictionary_start + word_idx +
+            (transform_id << words->size_bits_by_length[len]);
+        if (backward <= BROTLI_MAX_FRAGMENT_DICTIONARY_DISTANCE) {
+          best = matched;
+          *copy_len = len;
+          *distance = backward;
+        }
+      }
+    }
+  }
+  return best;
+}
+
 BROTLI_INTERNAL void BrotliInitEncoderDictionary(BrotliEncoderDictionary* dict);
 
 #if defined(__cplusplus) || defined(c_plusplus)
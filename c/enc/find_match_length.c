@@ -0,0 +1,87 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* SIMD kernels that extend long matches. */
+
+#include "./find_match_length.h"
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+
+#if defined(BROTLI_FIND_MATCH_LENGTH_SIMD)
+#include <emmintrin.h>
+#endif
+#if defined(BROTLI_FIND_MATCH_LENGTH_AVX2)
+#include <immintrin.h>
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+static size_t FindMatchLengthTail(const uint8_t* s1, const uint8_t* s2,
+                                  size_t matched, size_t limit) {
+  while (matched < limit && s1[matched] == s2[matched]) ++matched;
+  return matched;
+}
+
+#if defined(BROTLI_FIND_MATCH_LENGTH_SIMD)
+
+/* SSE2 is a part of x86-64 baseline, so this kernel is always available. */
+static size_t FindMatchLengthSse2(const uint8_t* s1, const uint8_t* s2,
+                                  size_t limit) {
+  size_t matched = 0;
+  while (matched + 16 <= limit) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)(s1 + matched));
+    const __m128i b = _mm_loadu_si128((const __m128i*)(s2 + matched));
+    const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+    if (mask != 0xFFFFu) {
+      return matched + (size_t)BROTLI_TZCNT64(~mask);
+    }
+    matched += 16;
+  }
+  return FindMatchLengthTail(s1, s2, matched, limit);
+}
+
+#if defined(BROTLI_FIND_MATCH_LENGTH_AVX2)
+__attribute__((target("avx2")))
+static size_t FindMatchLengthAvx2(const uint8_t* s1, const uint8_t* s2,
+                                  size_t limit) {
+  size_t matched = 0;
+  while (matched + 32 <= limit) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)(s1 + matched));
+    const __m256i b = _mm256_loadu_si256((const __m256i*)(s2 + matched));
+    const uint32_t mask =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if (mask != 0xFFFFFFFFu) {
+      return matched + (size_t)BROTLI_TZCNT64(~mask);
+    }
+    matched += 32;
+  }
+  return FindMatchLengthTail(s1, s2, matched, limit);
+}
+#endif  /* BROTLI_FIND_MATCH_LENGTH_AVX2 */
+
+#endif  /* BROTLI_FIND_MATCH_LENGTH_SIMD */
+
+size_t BrotliFindMatchLengthLong(const uint8_t* s1, const uint8_t* s2,
+                                 size_t limit) {
+#if defined(BROTLI_FIND_MATCH_LENGTH_AVX2)
+  /* Feature flags are filled in by the runtime library before main. */
+  if (__builtin_cpu_supports("avx2")) {
+    return FindMatchLengthAvx2(s1, s2, limit);
+  }
+#endif  /* BROTLI_FIND_MATCH_LENGTH_AVX2 */
+#if defined(BROTLI_FIND_MATCH_LENGTH_SIMD)
+  return FindMatchLengthSse2(s1, s2, limit);
+#else
+  return FindMatchLengthTail(s1, s2, 0, limit);
+#endif
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
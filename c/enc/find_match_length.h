@@ -16,6 +16,27 @@
 extern "C" {
 #endif
 
+/* On x86-64 long matches are extended out-of-line with SSE2 kernel, or with
+   AVX2 kernel, if CPU supports it. */
+#if defined(BROTLI_TARGET_SSE2) && defined(BROTLI_TARGET_X64) && \
+    defined(BROTLI_TZCNT64) && \
+    (defined(__GNUC__) || BROTLI_MSVC_VERSION_CHECK(14, 0, 0))
+#define BROTLI_FIND_MATCH_LENGTH_SIMD
+#if BROTLI_GNUC_HAS_BUILTIN(__builtin_cpu_supports, 4, 9, 0)
+#define BROTLI_FIND_MATCH_LENGTH_AVX2
+#endif
+#endif
+
+/* Returns the length of the common prefix of |s1| and |s2|, but not more than
+   |limit|. Out-of-line variant that is optimized for long matches. */
+BROTLI_INTERNAL size_t BrotliFindMatchLengthLong(const uint8_t* s1,
+    const uint8_t* s2, size_t limit);
+
+#if defined(BROTLI_FIND_MATCH_LENGTH_SIMD)
+/* Matches that reach this length are handed over to the out-of-line kernel. */
+#define BROTLI_FIND_MATCH_LENGTH_LONG 64
+#endif
+
 /* Separate implementation for little-endian 64-bit targets, for speed. */
 #if defined(BROTLI_TZCNT64) && BROTLI_64_BITS && BROTLI_LITTLE_ENDIAN
 static BROTLI_INLINE size_t FindMatchLengthWithLimit(const uint8_t* s1,
@@ -28,6 +49,12 @@ static BROTLI_INLINE size_t FindMatchLengthWithLimit(const uint8_t* s1,
                       BROTLI_UNALIGNED_LOAD64LE(s1 + matched))) {
       s2 += 8;
       matched += 8;
+#if defined(BROTLI_FIND_MATCH_LENGTH_SIMD)
+      if (BROTLI_PREDICT_FALSE(matched == BROTLI_FIND_MATCH_LENGTH_LONG)) {
+        return matched + BrotliFindMatchLengthLong(
+            s1 + matched, s2, limit - matched);
+      }
+#endif
     } else {
       uint64_t x = BROTLI_UNALIGNED_LOAD64LE(s2) ^
           BROTLI_UNALIGNED_LOAD64LE(s1 + matched);
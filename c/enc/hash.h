@@ -16,6 +16,7 @@
 #include "../common/dictionary.h"
 #include "../common/platform.h"
 #include <brotli/types.h>
+#include "./compound_dictionary.h"
 #include "./encoder_dict.h"
 #include "./fast_log.h"
 #include "./find_match_length.h"
@@ -23,6 +24,13 @@
 #include "./quality.h"
 #include "./static_dict.h"
 
+/* Tags of bucket entries are compared with SSE2, if it is available;
+   otherwise they are compared one by one. */
+#if defined(BROTLI_TARGET_SSE2)
+#define BROTLI_HASH_TAGS_SSE2
+#include <emmintrin.h>
+#endif
+
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
 #endif
@@ -30,12 +38,16 @@ extern "C" {
 typedef struct {
   /* Dynamically allocated area; first member for quickest access. */
   void* extra;
+  /* Size of |extra| area; it could be bigger than current hasher needs. */
+  size_t extra_size;
 
   size_t dict_num_lookups;
   size_t dict_num_matches;
 
   BrotliHasherParams params;
 
+  /* False if hasher type and parameters should be (re)chosen before use. */
+  BROTLI_BOOL is_setup_;
   /* False if hasher needs to be "prepared" before use. */
   BROTLI_BOOL is_prepared_;
 } HasherCommon;
@@ -66,6 +78,51 @@ static const uint64_t kHashMul64 = BROTLI_MAKE_UINT64_T(0x1E35A7BD, 0x1E35A7BD);
 static const uint64_t kHashMul64Long =
     BROTLI_MAKE_UINT64_T(0x1FE35A7Bu, 0xD3579BD3u);
 
+/* Distance (in positions) at which the backward reference search prefetches
+   the hash bucket of the upcoming position. The next position is looked up
+   both after a literal and by the lazy matching. Prefetching it ahead lets
+   FindLongestMatch or Store invoked for that position later avoid a stall on
+   memory. */
+#define BROTLI_HASHER_PREFETCH_DISTANCE 1
+
+/* Returns the mask of |slots| elements, whose highest byte is equal to |tag|.
+   |n| is a multiple of 4 not greater than 64; |slots| is aligned to 16
+   bytes. */
+static BROTLI_INLINE uint64_t BrotliMatchTags(
+    const uint32_t* BROTLI_RESTRICT slots, size_t n, uint32_t tag) {
+  uint64_t result = 0;
+  size_t i;
+#if defined(BROTLI_HASH_TAGS_SSE2)
+  const __m128i pattern = _mm_set1_epi32((int)tag);
+  for (i = 0; i < n; i += 4) {
+    const __m128i v =
+        _mm_srli_epi32(_mm_load_si128((const __m128i*)&slots[i]), 24);
+    const uint32_t bits = (uint32_t)_mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmpeq_epi32(v, pattern)));
+    result |= (uint64_t)bits << i;
+  }
+#else
+  for (i = 0; i < n; ++i) {
+    result |= (uint64_t)((slots[i] >> 24) == tag) << i;
+  }
+#endif
+  return result;
+}
+
+/* Returns the index of the lowest set bit; |mask| is not zero. */
+static BROTLI_INLINE size_t BrotliLowestTagMatch(uint64_t mask) {
+#if defined(BROTLI_TZCNT64)
+  return (size_t)BROTLI_TZCNT64(mask);
+#else
+  size_t result = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    ++result;
+  }
+  return result;
+#endif
+}
+
 static BROTLI_INLINE uint32_t Hash14(const uint8_t* data) {
   uint32_t h = BROTLI_UNALIGNED_LOAD32LE(data) * kHashMul32;
   /* The higher bits contain more mixture from the multiplication,
@@ -182,6 +239,13 @@ static BROTLI_INLINE void SearchInStaticDictionary(
   if (common->dict_num_matches < (common->dict_num_lookups >> 7)) {
     return;
   }
+  /* Only words sharing the first 4 bytes with data can outscore a 3-byte
+     match at the shortest dictionary distance. */
+  if (BackwardReferenceScore(3, max_backward + 1) < out->score &&
+      !BrotliMayStartDictionaryWord(dictionary, data)) {
+    common->dict_num_lookups += shallow ? 1u : 2u;
+    return;
+  }
   key = Hash14(data) << 1;
   for (i = 0; i < (shallow ? 1u : 2u); ++i, ++key) {
     common->dict_num_lookups++;
@@ -224,6 +288,198 @@ static BROTLI_INLINE size_t BackwardMatchLengthCode(const BackwardMatch* self) {
   return code ? code : BackwardMatchLength(self);
 }
 
+/* Distance of the prepared dictionary |self| position 0 is |distance_offset|.
+   Tries last distances, then the hash bucket; improves |out|, if possible. */
+static BROTLI_INLINE void FindCompoundDictionaryMatch(
+    const PreparedDictionary* self, const uint8_t* BROTLI_RESTRICT data,
+    const size_t ring_buffer_mask, const int* BROTLI_RESTRICT distance_cache,
+    const size_t cur_ix, const size_t max_length, const size_t distance_offset,
+    const size_t max_distance, HasherSearchResult* BROTLI_RESTRICT out) {
+  const uint32_t source_size = self->source_size;
+  const size_t boundary = distance_offset - source_size;
+  const uint32_t hash_shift = 64u - self->bucket_bits;
+  const uint32_t slot_mask = (~((uint32_t)0U)) >> (32 - self->slot_bits);
+  const uint64_t hash_mask = (~((uint64_t)0U)) >> (64 - self->hash_bits);
+
+  const uint32_t* slot_offsets = (const uint32_t*)(&self[1]);
+  const uint16_t* heads = (const uint16_t*)(&slot_offsets[slot_mask + 1]);
+  const uint32_t* items =
+      (const uint32_t*)(&heads[(size_t)1 << self->bucket_bits]);
+  const uint8_t* source = (const uint8_t*)(&items[self->num_items]);
+
+  const size_t cur_ix_masked = cur_ix & ring_buffer_mask;
+  score_t best_score = out->score;
+  size_t best_len = out->len;
+  size_t i;
+  const uint64_t h =
+      (BROTLI_UNALIGNED_LOAD64LE(&data[cur_ix_masked]) & hash_mask) *
+      kPreparedDictionaryHashMul64Long;
+  const uint32_t key = (uint32_t)(h >> hash_shift);
+  const uint32_t slot = key & slot_mask;
+  const uint32_t head = heads[key];
+  const uint32_t* BROTLI_RESTRICT chain = &items[slot_offsets[slot] + head];
+  uint32_t item = (head == 0xFFFF) ? 1 : 0;
+
+  for (i = 0; i < 4; ++i) {
+    const size_t distance = (size_t)distance_cache[i];
+    size_t offset;
+    size_t limit;
+    size_t len;
+    if (distance <= boundary || distance > distance_offset) continue;
+    offset = distance_offset - distance;
+    limit = source_size - offset;
+    limit = limit > max_length ? max_length : limit;
+    len = FindMatchLengthWithLimit(&source[offset], &data[cur_ix_masked],
+                                   limit);
+    if (len >= 2) {
+      score_t score = BackwardReferenceScoreUsingLastDistance(len);
+      if (best_score < score) {
+        if (i != 0) score -= BackwardReferencePenaltyUsingLastDistance(i);
+        if (best_score < score) {
+          best_score = score;
+          if (len > best_len) best_len = len;
+          out->len = len;
+          out->len_code_delta = 0;
+          out->distance = distance;
+          out->score = best_score;
+        }
+      }
+    }
+  }
+  while (item == 0) {
+    size_t offset;
+    size_t distance;
+    size_t limit;
+    item = *chain;
+    chain++;
+    offset = item & 0x7FFFFFFF;
+    item &= 0x80000000;
+    distance = distance_offset - offset;
+    limit = source_size - offset;
+    limit = (limit > max_length) ? max_length : limit;
+    if (distance > max_distance) continue;
+    if (cur_ix_masked + best_len > ring_buffer_mask ||
+        best_len >= limit ||
+        data[cur_ix_masked + best_len] != source[offset + best_len]) {
+      continue;
+    }
+    {
+      const size_t len = FindMatchLengthWithLimit(&source[offset],
+                                                  &data[cur_ix_masked],
+                                                  limit);
+      if (len >= 4) {
+        score_t score = BackwardReferenceScore(len, distance);
+        if (best_score < score) {
+          best_score = score;
+          best_len = len;
+          out->len = best_len;
+          out->len_code_delta = 0;
+          out->distance = distance;
+          out->score = best_score;
+        }
+      }
+    }
+  }
+}
+
+/* Looks for a match in attached dictionaries; |dictionary_start| is the
+   largest distance that refers to the data preceding |cur_ix|. */
+static BROTLI_INLINE void LookupCompoundDictionaryMatch(
+    const CompoundDictionary* addon, const uint8_t* BROTLI_RESTRICT data,
+    const size_t ring_buffer_mask, const int* BROTLI_RESTRICT distance_cache,
+    const size_t cur_ix, const size_t max_length,
+    const size_t dictionary_start, const size_t max_distance,
+    HasherSearchResult* sr) {
+  const size_t base_offset = dictionary_start + addon->total_size;
+  size_t d;
+  for (d = 0; d < addon->num_chunks; ++d) {
+    FindCompoundDictionaryMatch(addon->chunks[d], data, ring_buffer_mask,
+        distance_cache, cur_ix, max_length,
+        base_offset - addon->chunk_offsets[d], max_distance, sr);
+  }
+}
+
+/* Stores up to |match_limit| matches with strictly increasing lengths, that
+   are at least |min_length| long. Returns the number of stored matches. */
+static BROTLI_INLINE size_t FindAllCompoundDictionaryMatches(
+    const PreparedDictionary* self, const uint8_t* BROTLI_RESTRICT data,
+    const size_t ring_buffer_mask, const size_t cur_ix, const size_t min_length,
+    const size_t max_length, const size_t distance_offset,
+    const size_t max_distance, BackwardMatch* matches, size_t match_limit) {
+  const uint32_t source_size = self->source_size;
+  const uint32_t hash_shift = 64u - self->bucket_bits;
+  const uint32_t slot_mask = (~((uint32_t)0U)) >> (32 - self->slot_bits);
+  const uint64_t hash_mask = (~((uint64_t)0U)) >> (64 - self->hash_bits);
+
+  const uint32_t* slot_offsets = (const uint32_t*)(&self[1]);
+  const uint16_t* heads = (const uint16_t*)(&slot_offsets[slot_mask + 1]);
+  const uint32_t* items =
+      (const uint32_t*)(&heads[(size_t)1 << self->bucket_bits]);
+  const uint8_t* source = (const uint8_t*)(&items[self->num_items]);
+
+  const size_t cur_ix_masked = cur_ix & ring_buffer_mask;
+  size_t best_len = min_length - 1;
+  size_t found = 0;
+  const uint64_t h =
+      (BROTLI_UNALIGNED_LOAD64LE(&data[cur_ix_masked]) & hash_mask) *
+      kPreparedDictionaryHashMul64Long;
+  const uint32_t key = (uint32_t)(h >> hash_shift);
+  const uint32_t slot = key & slot_mask;
+  const uint32_t head = heads[key];
+  const uint32_t* BROTLI_RESTRICT chain = &items[slot_offsets[slot] + head];
+  uint32_t item = (head == 0xFFFF) ? 1 : 0;
+
+  while (item == 0) {
+    size_t offset;
+    size_t distance;
+    size_t limit;
+    item = *chain;
+    chain++;
+    offset = item & 0x7FFFFFFF;
+    item &= 0x80000000;
+    distance = distance_offset - offset;
+    limit = source_size - offset;
+    limit = (limit > max_length) ? max_length : limit;
+    if (distance > max_distance) continue;
+    if (cur_ix_masked + best_len > ring_buffer_mask ||
+        best_len >= limit ||
+        data[cur_ix_masked + best_len] != source[offset + best_len]) {
+      continue;
+    }
+    {
+      const size_t len = FindMatchLengthWithLimit(
+          &source[offset], &data[cur_ix_masked], limit);
+      if (len > best_len) {
+        best_len = len;
+        InitBackwardMatch(&matches[found++], distance, len);
+        if (found == match_limit) break;
+      }
+    }
+  }
+  return found;
+}
+
+static BROTLI_INLINE size_t LookupAllCompoundDictionaryMatches(
+    const CompoundDictionary* addon, const uint8_t* BROTLI_RESTRICT data,
+    const size_t ring_buffer_mask, const size_t cur_ix, size_t min_length,
+    const size_t max_length, const size_t dictionary_start,
+    const size_t max_distance, BackwardMatch* matches, size_t match_limit) {
+  const size_t base_offset = dictionary_start + addon->total_size;
+  size_t d;
+  size_t total_found = 0;
+  for (d = 0; d < addon->num_chunks; ++d) {
+    size_t found = FindAllCompoundDictionaryMatches(addon->chunks[d],
+        data, ring_buffer_mask, cur_ix, min_length, max_length,
+        base_offset - addon->chunk_offsets[d], max_distance,
+        &matches[total_found], match_limit - total_found);
+    if (!found) continue;
+    total_found += found;
+    min_length = BackwardMatchLength(&matches[total_found - 1]) + 1;
+    if (total_found == match_limit) break;
+  }
+  return total_found;
+}
+
 #define EXPAND_CAT(a, b) CAT(a, b)
 #define CAT(a, b) a ## b
 #define FN(X) EXPAND_CAT(X, HASHER())
@@ -282,6 +538,10 @@ static BROTLI_INLINE size_t BackwardMatchLengthCode(const BackwardMatch* self) {
 #include "./hash_longest_match64_inc.h"  /* NOLINT(build/include) */
 #undef HASHER
 
+#define HASHER() H68
+#include "./hash_longest_match_tagged_inc.h"  /* NOLINT(build/include) */
+#undef HASHER
+
 #define BUCKET_BITS 15
 
 #define NUM_LAST_DISTANCES_TO_CHECK 4
@@ -326,11 +586,13 @@ static BROTLI_INLINE size_t BackwardMatchLengthCode(const BackwardMatch* self) {
 
 /* fast large window hashers */
 
+/* Fast variant hashes only every JUMP-th byte, so it finds repetitions only
+   at distances that are multiple of JUMP; that still suits block-aligned
+   data, like disk images. */
+
 #define HASHER() HROLLING_FAST
 #define CHUNKLEN 32
 #define JUMP 4
-#define NUMBUCKETS 16777216
-#define MASK ((NUMBUCKETS * 64) - 1)
 #include "./hash_rolling_inc.h"  /* NOLINT(build/include) */
 #undef JUMP
 #undef HASHER
@@ -339,8 +601,6 @@ static BROTLI_INLINE size_t BackwardMatchLengthCode(const BackwardMatch* self) {
 #define HASHER() HROLLING
 #define JUMP 1
 #include "./hash_rolling_inc.h"  /* NOLINT(build/include) */
-#undef MASK
-#undef NUMBUCKETS
 #undef JUMP
 #undef CHUNKLEN
 #undef HASHER
@@ -373,7 +633,8 @@ static BROTLI_INLINE size_t BackwardMatchLengthCode(const BackwardMatch* self) {
 #undef CAT
 #undef EXPAND_CAT
 
-#define FOR_SIMPLE_HASHERS(H) H(2) H(3) H(4) H(5) H(6) H(40) H(41) H(42) H(54)
+#define FOR_SIMPLE_HASHERS(H) \
+    H(2) H(3) H(4) H(5) H(6) H(40) H(41) H(42) H(54) H(68)
 #define FOR_COMPOSITE_HASHERS(H) H(35) H(55) H(65)
 #define FOR_GENERIC_HASHERS(H) FOR_SIMPLE_HASHERS(H) FOR_COMPOSITE_HASHERS(H)
 #define FOR_ALL_HASHERS(H) FOR_GENERIC_HASHERS(H) H(10)
@@ -392,6 +653,14 @@ typedef struct {
 /* MUST be invoked before any other method. */
 static BROTLI_INLINE void HasherInit(Hasher* hasher) {
   hasher->common.extra = NULL;
+  hasher->common.extra_size = 0;
+  hasher->common.is_setup_ = BROTLI_FALSE;
+}
+
+/* Makes hasher reusable for another stream, possibly with different
+   parameters. Allocated memory is kept, if it is big enough. */
+static BROTLI_INLINE void HasherRecycle(Hasher* hasher) {
+  hasher->common.is_setup_ = BROTLI_FALSE;
 }
 
 static BROTLI_INLINE void DestroyHasher(MemoryManager* m, Hasher* hasher) {
@@ -421,12 +690,17 @@ static BROTLI_INLINE void HasherSetup(MemoryManager* m, Hasher* hasher,
     BrotliEncoderParams* params, const uint8_t* data, size_t position,
     size_t input_size, BROTLI_BOOL is_last) {
   BROTLI_BOOL one_shot = (position == 0 && is_last);
-  if (hasher->common.extra == NULL) {
+  if (!hasher->common.is_setup_) {
     size_t alloc_size;
     ChooseHasher(params, &params->hasher);
     alloc_size = HasherSize(params, one_shot, input_size);
-    hasher->common.extra = BROTLI_ALLOC(m, uint8_t, alloc_size);
-    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(hasher->common.extra)) return;
+    if (hasher->common.extra == NULL ||
+        hasher->common.extra_size < alloc_size) {
+      DestroyHasher(m, hasher);
+      hasher->common.extra = BROTLI_ALLOC(m, uint8_t, alloc_size);
+      if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(hasher->common.extra)) return;
+      hasher->common.extra_size = alloc_size;
+    }
     hasher->common.params = params->hasher;
     switch (hasher->common.params.type) {
 #define INITIALIZE_(N)                        \
@@ -440,6 +714,7 @@ static BROTLI_INLINE void HasherSetup(MemoryManager* m, Hasher* hasher,
         break;
     }
     HasherReset(hasher);
+    hasher->common.is_setup_ = BROTLI_TRUE;
   }
 
   if (!hasher->common.is_prepared_) {
@@ -481,6 +756,31 @@ static BROTLI_INLINE void InitOrStitchToPreviousBlock(
   }
 }
 
+/* Loads |size| bytes of data that precede the stream into the hasher, so that
+   backward references into that data could be found. Hasher is assumed to be
+   fresh; the data is expected to occupy the first |size| bytes of the
+   ring buffer. */
+static BROTLI_INLINE void HasherPrependCustomDictionary(
+    MemoryManager* m, Hasher* hasher, BrotliEncoderParams* params,
+    const size_t size, const uint8_t* dict) {
+  size_t overlap;
+  size_t i;
+  HasherSetup(m, hasher, params, dict, 0, size, BROTLI_FALSE);
+  if (BROTLI_IS_OOM(m)) return;
+  switch (hasher->common.params.type) {
+#define PREPEND_(N)                                                    \
+    case N:                                                            \
+      overlap = (StoreLookaheadH ## N()) - 1;                          \
+      for (i = 0; i + overlap < size; i++) {                           \
+        StoreH ## N(&hasher->privat._H ## N, dict, ~(size_t)0, i);     \
+      }                                                                \
+      break;
+    FOR_ALL_HASHERS(PREPEND_)
+#undef PREPEND_
+    default: break;
+  }
+}
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
@@ -82,6 +82,13 @@ static BROTLI_INLINE void FN(Store)(HashComposite* BROTLI_RESTRICT self,
   FN_B(Store)(&self->hb, data, mask, ix);
 }
 
+static BROTLI_INLINE void FN(PrefetchBucket)(
+    HashComposite* BROTLI_RESTRICT self, const uint8_t* BROTLI_RESTRICT data,
+    const size_t mask, const size_t ix) {
+  FN_A(PrefetchBucket)(&self->ha, data, mask, ix);
+  FN_B(PrefetchBucket)(&self->hb, data, mask, ix);
+}
+
 static BROTLI_INLINE void FN(StoreRange)(
     HashComposite* BROTLI_RESTRICT self, const uint8_t* BROTLI_RESTRICT data,
     const size_t mask, const size_t ix_start,
@@ -146,6 +146,15 @@ static BROTLI_INLINE void FN(Store)(HashForgetfulChain* BROTLI_RESTRICT self,
   head[key] = (uint16_t)idx;
 }
 
+/* Prefetches the chain head for position ix. */
+static BROTLI_INLINE void FN(PrefetchBucket)(
+    HashForgetfulChain* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask, const size_t ix) {
+  const size_t key = FN(HashBytes)(&data[ix & mask]);
+  BROTLI_PREFETCH(&FN(Addr)(self->extra)[key]);
+  BROTLI_PREFETCH(&FN(Head)(self->extra)[key]);
+}
+
 static BROTLI_INLINE void FN(StoreRange)(
     HashForgetfulChain* BROTLI_RESTRICT self,
     const uint8_t* BROTLI_RESTRICT data, const size_t mask,
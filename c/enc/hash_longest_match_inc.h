@@ -115,6 +115,15 @@ static BROTLI_INLINE void FN(Store)(
   ++self->num_[key];
 }
 
+/* Prefetches the newest slot of the bucket for position ix. */
+static BROTLI_INLINE void FN(PrefetchBucket)(
+    HashLongestMatch* BROTLI_RESTRICT self, const uint8_t* BROTLI_RESTRICT data,
+    const size_t mask, const size_t ix) {
+  const uint32_t key = FN(HashBytes)(&data[ix & mask], self->hash_shift_);
+  const size_t minor_ix = (size_t)(self->num_[key] - 1u) & self->block_mask_;
+  BROTLI_PREFETCH(&self->buckets_[minor_ix + (key << self->block_bits_)]);
+}
+
 static BROTLI_INLINE void FN(StoreRange)(HashLongestMatch* BROTLI_RESTRICT self,
     const uint8_t* BROTLI_RESTRICT data, const size_t mask,
     const size_t ix_start, const size_t ix_end) {
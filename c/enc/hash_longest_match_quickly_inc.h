@@ -105,6 +105,17 @@ static BROTLI_INLINE void FN(Store)(
   }
 }
 
+/* Buckets of this hasher are looked up at most a few times per stored
+   position, prefetching them does not pay off. */
+static BROTLI_INLINE void FN(PrefetchBucket)(
+    HashLongestMatchQuickly* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask, const size_t ix) {
+  BROTLI_UNUSED(self);
+  BROTLI_UNUSED(data);
+  BROTLI_UNUSED(mask);
+  BROTLI_UNUSED(ix);
+}
+
 static BROTLI_INLINE void FN(StoreRange)(
     HashLongestMatchQuickly* BROTLI_RESTRICT self,
     const uint8_t* BROTLI_RESTRICT data, const size_t mask,
@@ -164,7 +175,9 @@ static BROTLI_INLINE void FN(FindLongestMatch)(
   size_t cached_backward = (size_t)distance_cache[0];
   size_t prev_ix = cur_ix - cached_backward;
   out->len_code_delta = 0;
-  if (prev_ix < cur_ix) {
+  /* Last distance might point into attached dictionaries, i.e. beyond the
+     data available in the ring buffer. */
+  if (prev_ix < cur_ix && cached_backward <= max_backward) {
     prev_ix &= (uint32_t)ring_buffer_mask;
     if (compare_char == data[prev_ix + best_len]) {
       const size_t len = FindMatchLengthWithLimit(
@@ -0,0 +1,312 @@
+/* NOLINT(build/header_guard) */
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* template parameters: FN */
+
+/* Variant of HashLongestMatch64 (H6) that keeps an 8-bit "tag" of the hash
+   beside each slot of the bucket. Tags of the whole bucket are compared at
+   once, so only candidates with the same hash value are read from the ring
+   buffer.
+
+   Each slot is a 32-bit word: the highest byte is the tag, the lower 24 bits
+   are the position; 24 bits are enough to restore positions within the
+   window, so window must not exceed 24 bits. Buckets are aligned to cache
+   line, so bucket of 16 entries takes exactly one cache line. Slots are
+   written and read whole, so recently stored ones are forwarded to the loads
+   without stalls. Bucket is filled backwards, so that slots sorted by age form
+   a rotated bit mask of the tag comparison. Block size must be from 16 to 64
+   slots. */
+
+#define HashLongestMatchTagged HASHER()
+
+static BROTLI_INLINE size_t FN(HashTypeLength)(void) { return 8; }
+static BROTLI_INLINE size_t FN(StoreLookahead)(void) { return 8; }
+
+/* HashBytes is the function that chooses the bucket to place the address in.
+   Result is the bucket index, followed by 8 bits of tag. */
+static BROTLI_INLINE uint32_t FN(HashBytes)(const uint8_t* BROTLI_RESTRICT data,
+                                            const uint64_t mask,
+                                            const int shift) {
+  const uint64_t h = (BROTLI_UNALIGNED_LOAD64LE(data) & mask) * kHashMul64Long;
+  /* The higher bits contain more mixture from the multiplication,
+     so we take our results from there. */
+  return (uint32_t)(h >> shift);
+}
+
+typedef struct HashLongestMatchTagged {
+  /* Number of hash buckets. */
+  size_t bucket_size_;
+  /* Only block_size_ newest backward references are kept,
+     and the older are forgotten. */
+  size_t block_size_;
+  /* Right-shift for computing tagged bucket index from hash value. */
+  int hash_shift_;
+  /* Mask for selecting the next 4-8 bytes of input */
+  uint64_t hash_mask_;
+  /* Mask for accessing entries in a block (in a ring-buffer manner). */
+  uint32_t block_mask_;
+
+  int block_bits_;
+  int num_last_distances_to_check_;
+
+  /* Shortcuts. */
+  HasherCommon* common_;
+
+  /* --- Dynamic size members --- */
+
+  /* Buckets containing block_size_ of tagged backward references. */
+  uint32_t* buckets_;  /* uint32_t[bucket_size * block_size]; */
+
+  /* Number of entries in a particular bucket. */
+  uint16_t* num_;  /* uint16_t[bucket_size]; */
+} HashLongestMatchTagged;
+
+static void FN(Initialize)(
+    HasherCommon* common, HashLongestMatchTagged* BROTLI_RESTRICT self,
+    const BrotliEncoderParams* params) {
+  /* Dynamic area is aligned to cache line, to keep rows undivided. */
+  uint8_t* extra = (uint8_t*)common->extra;
+  extra += (64 - ((size_t)extra & 63)) & 63;
+  self->common_ = common;
+
+  BROTLI_UNUSED(params);
+  self->hash_shift_ = 64 - 8 - common->params.bucket_bits;
+  self->hash_mask_ = (~((uint64_t)0U)) >> (64 - 8 * common->params.hash_len);
+  self->bucket_size_ = (size_t)1 << common->params.bucket_bits;
+  self->block_bits_ = common->params.block_bits;
+  self->block_size_ = (size_t)1 << common->params.block_bits;
+  self->block_mask_ = (uint32_t)(self->block_size_ - 1);
+  self->num_last_distances_to_check_ =
+      common->params.num_last_distances_to_check;
+  self->buckets_ = (uint32_t*)extra;
+  self->num_ = (uint16_t*)&self->buckets_[self->bucket_size_ *
+                                          self->block_size_];
+}
+
+static void FN(Prepare)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self, BROTLI_BOOL one_shot,
+    size_t input_size, const uint8_t* BROTLI_RESTRICT data) {
+  uint16_t* BROTLI_RESTRICT num = self->num_;
+  /* Partial preparation is 100 times slower (per socket). */
+  size_t partial_prepare_threshold = self->bucket_size_ >> 6;
+  if (one_shot && input_size <= partial_prepare_threshold) {
+    size_t i;
+    for (i = 0; i < input_size; ++i) {
+      const uint32_t key =
+          FN(HashBytes)(&data[i], self->hash_mask_, self->hash_shift_) >> 8;
+      num[key] = 0;
+    }
+  } else {
+    memset(num, 0, self->bucket_size_ * sizeof(num[0]));
+  }
+}
+
+static BROTLI_INLINE size_t FN(HashMemAllocInBytes)(
+    const BrotliEncoderParams* params, BROTLI_BOOL one_shot,
+    size_t input_size) {
+  size_t bucket_size = (size_t)1 << params->hasher.bucket_bits;
+  size_t block_size = (size_t)1 << params->hasher.block_bits;
+  BROTLI_UNUSED(one_shot);
+  BROTLI_UNUSED(input_size);
+  /* 63 bytes are reserved for alignment of the buckets. */
+  return 63 + sizeof(uint16_t) * bucket_size +
+         sizeof(uint32_t) * bucket_size * block_size;
+}
+
+/* Tag is the lowest byte of hash; it is moved to the highest byte of slot. */
+static BROTLI_INLINE uint32_t FN(MakeSlot)(uint32_t hash, size_t ix) {
+  return (hash << 24) | ((uint32_t)ix & 0xFFFFFFu);
+}
+
+/* Look at 8 bytes at &data[ix & mask], of which hash_len are hashed.
+   Compute a hash from these, and store the value of ix at that position. */
+static BROTLI_INLINE void FN(Store)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask, const size_t ix) {
+  const uint32_t hash =
+      FN(HashBytes)(&data[ix & mask], self->hash_mask_, self->hash_shift_);
+  const size_t key = hash >> 8;
+  /* Slots are taken in descending order. */
+  const size_t minor_ix = (size_t)(~self->num_[key]) & self->block_mask_;
+  self->buckets_[(key << self->block_bits_) + minor_ix] =
+      FN(MakeSlot)(hash, ix);
+  ++self->num_[key];
+}
+
+static BROTLI_INLINE void FN(PrefetchBucket)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask, const size_t ix) {
+  const size_t key = FN(HashBytes)(
+      &data[ix & mask], self->hash_mask_, self->hash_shift_) >> 8;
+  BROTLI_PREFETCH(&self->buckets_[key << self->block_bits_]);
+}
+
+static BROTLI_INLINE void FN(StoreRange)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask,
+    const size_t ix_start, const size_t ix_end) {
+  size_t i;
+  for (i = ix_start; i < ix_end; ++i) {
+    FN(Store)(self, data, mask, i);
+  }
+}
+
+static BROTLI_INLINE void FN(StitchToPreviousBlock)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    size_t num_bytes, size_t position, const uint8_t* ringbuffer,
+    size_t ringbuffer_mask) {
+  if (num_bytes >= FN(HashTypeLength)() - 1 &&
+      position >= FN(HashTypeLength)() - 1) {
+    size_t i;
+    /* Prepare the hashes for the last bytes of the last write.
+       These could not be calculated before, since they require knowledge
+       of both the previous and the current block. */
+    for (i = position - FN(HashTypeLength)() + 1; i < position; ++i) {
+      FN(Store)(self, ringbuffer, ringbuffer_mask, i);
+    }
+  }
+}
+
+static BROTLI_INLINE void FN(PrepareDistanceCache)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    int* BROTLI_RESTRICT distance_cache) {
+  PrepareDistanceCache(distance_cache, self->num_last_distances_to_check_);
+}
+
+/* Find a longest backward match of &data[cur_ix] up to the length of
+   max_length and stores the position cur_ix in the hash table.
+
+   REQUIRES: FN(PrepareDistanceCache) must be invoked for current distance cache
+             values; if this method is invoked repeatedly with the same distance
+             cache values, it is enough to invoke FN(PrepareDistanceCache) once.
+
+   Does not look for matches longer than max_length.
+   Does not look for matches further away than max_backward.
+   Writes the best match into |out|.
+   |out|->score is updated only if a better match is found. */
+static BROTLI_INLINE void FN(FindLongestMatch)(
+    HashLongestMatchTagged* BROTLI_RESTRICT self,
+    const BrotliEncoderDictionary* dictionary,
+    const uint8_t* BROTLI_RESTRICT data, const size_t ring_buffer_mask,
+    const int* BROTLI_RESTRICT distance_cache, const size_t cur_ix,
+    const size_t max_length, const size_t max_backward,
+    const size_t dictionary_distance, const size_t max_distance,
+    HasherSearchResult* BROTLI_RESTRICT out) {
+  uint16_t* BROTLI_RESTRICT num = self->num_;
+  const size_t cur_ix_masked = cur_ix & ring_buffer_mask;
+  /* Don't accept a short copy from far away. */
+  score_t min_score = out->score;
+  score_t best_score = out->score;
+  size_t best_len = out->len;
+  size_t i;
+  out->len = 0;
+  out->len_code_delta = 0;
+  /* Try last distance first. */
+  for (i = 0; i < (size_t)self->num_last_distances_to_check_; ++i) {
+    const size_t backward = (size_t)distance_cache[i];
+    size_t prev_ix = (size_t)(cur_ix - backward);
+    if (prev_ix >= cur_ix) {
+      continue;
+    }
+    if (BROTLI_PREDICT_FALSE(backward > max_backward)) {
+      continue;
+    }
+    prev_ix &= ring_buffer_mask;
+
+    if (cur_ix_masked + best_len > ring_buffer_mask ||
+        prev_ix + best_len > ring_buffer_mask ||
+        data[cur_ix_masked + best_len] != data[prev_ix + best_len]) {
+      continue;
+    }
+    {
+      const size_t len = FindMatchLengthWithLimit(&data[prev_ix],
+                                                  &data[cur_ix_masked],
+                                                  max_length);
+      if (len >= 3 || (len == 2 && i < 2)) {
+        /* Comparing for >= 2 does not change the semantics, but just saves for
+           a few unnecessary binary logarithms in backward reference score,
+           since we are not interested in such short matches. */
+        score_t score = BackwardReferenceScoreUsingLastDistance(len);
+        if (best_score < score) {
+          if (i != 0) score -= BackwardReferencePenaltyUsingLastDistance(i);
+          if (best_score < score) {
+            best_score = score;
+            best_len = len;
+            out->len = best_len;
+            out->distance = backward;
+            out->score = best_score;
+          }
+        }
+      }
+    }
+  }
+  {
+    const uint32_t hash = FN(HashBytes)(
+        &data[cur_ix_masked], self->hash_mask_, self->hash_shift_);
+    const size_t key = hash >> 8;
+    const uint32_t tag = hash & 0xFF;
+    const size_t block_size = self->block_size_;
+    uint32_t* BROTLI_RESTRICT bucket =
+        &self->buckets_[key << self->block_bits_];
+    /* Slot of the newest entry; entry of age N is in slot (newest + N). */
+    const size_t newest = (size_t)(0u - num[key]) & self->block_mask_;
+    const uint64_t all = (block_size == 64) ?
+        ~(uint64_t)0 : (((uint64_t)1 << block_size) - 1);
+    const uint64_t valid = (num[key] >= block_size) ?
+        all : (((uint64_t)1 << num[key]) - 1);
+    uint64_t matches = BrotliMatchTags(bucket, block_size, tag);
+    /* Rotate, so that bits go from the newest to the oldest entry. */
+    matches = ((matches >> newest) |
+        (matches << ((block_size - newest) & 63))) & valid;
+    while (matches != 0) {
+      const size_t age = BrotliLowestTagMatch(matches);
+      const size_t backward =
+          (cur_ix - bucket[(newest + age) & self->block_mask_]) & 0xFFFFFF;
+      size_t prev_ix = cur_ix - backward;
+      matches &= matches - 1;
+      /* Entries older than 2^24 could alias to any distance, including 0;
+         those that pass this check are still verified below. */
+      if (BROTLI_PREDICT_FALSE(backward == 0 || backward > max_backward)) {
+        break;
+      }
+      prev_ix &= ring_buffer_mask;
+      if (cur_ix_masked + best_len > ring_buffer_mask ||
+          prev_ix + best_len > ring_buffer_mask ||
+          data[cur_ix_masked + best_len] != data[prev_ix + best_len]) {
+        continue;
+      }
+      {
+        const size_t len = FindMatchLengthWithLimit(&data[prev_ix],
+                                                    &data[cur_ix_masked],
+                                                    max_length);
+        if (len >= 4) {
+          /* Comparing for >= 3 does not change the semantics, but just saves
+             for a few unnecessary binary logarithms in backward reference
+             score, since we are not interested in such short matches. */
+          score_t score = BackwardReferenceScore(len, backward);
+          if (best_score < score) {
+            best_score = score;
+            best_len = len;
+            out->len = best_len;
+            out->distance = backward;
+            out->score = best_score;
+          }
+        }
+      }
+    }
+    bucket[(newest - 1) & self->block_mask_] =
+        FN(MakeSlot)(hash, cur_ix);
+    ++num[key];
+  }
+  if (min_score == out->score) {
+    SearchInStaticDictionary(dictionary,
+        self->common_, &data[cur_ix_masked], max_length, dictionary_distance,
+        max_distance, out, BROTLI_FALSE);
+  }
+}
+
+#undef HashLongestMatchTagged
@@ -5,17 +5,21 @@
    See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
 */
 
-/* template parameters: FN, JUMP, NUMBUCKETS, MASK, CHUNKLEN */
-/* NUMBUCKETS / (MASK + 1) = probability of storing and using hash code. */
+/* template parameters: FN, JUMP, CHUNKLEN */
 /* JUMP = skip bytes for speedup */
 
 /* Rolling hash for long distance long string matches. Stores one position
-   per bucket, bucket key is computed over a long region. */
+   per bucket, bucket key is computed over a long region. Only positions
+   with some fixed hash bits are sampled, so stored positions are chosen by
+   content, and the same data is sampled at the same places, whatever its
+   offset is. Number of buckets grows with the window size. */
 
 #define HashRolling HASHER()
 
 static const uint32_t FN(kRollingHashMul32) = 69069;
 static const uint32_t FN(kInvalidPos) = 0xffffffff;
+/* 1 / (1 << kSampleBits) = probability of storing and using hash code. */
+static const uint32_t FN(kSampleBits) = 6;
 
 /* This hasher uses a longer forward length, but returning a higher value here
    will hurt compression by the main hasher when combined with a composite
@@ -45,18 +49,33 @@ typedef struct HashRolling {
   uint32_t state;
   uint32_t* table;
   size_t next_ix;
+  /* Distance of the last match seen while rolling over the skipped
+     positions, or 0. */
+  size_t candidate_backward;
 
-  uint32_t chunk_len;
+  uint32_t bucket_bits;
   uint32_t factor;
   uint32_t factor_remove;
 } HashRolling;
 
+/* One bucket per 32 bytes of window, i.e. twice as much as the expected
+   number of sampled positions. */
+static BROTLI_INLINE uint32_t FN(BucketBits)(
+    const BrotliEncoderParams* params) {
+  int bits = params->lgwin - 5;
+  return (uint32_t)BROTLI_MIN(int, BROTLI_MAX(int, bits, 16), 24);
+}
+
 static void FN(Initialize)(
     HasherCommon* common, HashRolling* BROTLI_RESTRICT self,
     const BrotliEncoderParams* params) {
   size_t i;
+  size_t num_buckets;
   self->state = 0;
   self->next_ix = 0;
+  self->candidate_backward = 0;
+  self->bucket_bits = FN(BucketBits)(params);
+  num_buckets = (size_t)1 << self->bucket_bits;
 
   self->factor = FN(kRollingHashMul32);
 
@@ -68,11 +87,9 @@ static void FN(Initialize)(
   }
 
   self->table = (uint32_t*)common->extra;
-  for (i = 0; i < NUMBUCKETS; i++) {
+  for (i = 0; i < num_buckets; i++) {
     self->table[i] = FN(kInvalidPos);
   }
-
-  BROTLI_UNUSED(params);
 }
 
 static void FN(Prepare)(HashRolling* BROTLI_RESTRICT self, BROTLI_BOOL one_shot,
@@ -91,8 +108,7 @@ static void FN(Prepare)(HashRolling* BROTLI_RESTRICT self, BROTLI_BOOL one_shot,
 static BROTLI_INLINE size_t FN(HashMemAllocInBytes)(
     const BrotliEncoderParams* params, BROTLI_BOOL one_shot,
     size_t input_size) {
-  return NUMBUCKETS * sizeof(uint32_t);
-  BROTLI_UNUSED(params);
+  return ((size_t)1 << FN(BucketBits)(params)) * sizeof(uint32_t);
   BROTLI_UNUSED(one_shot);
   BROTLI_UNUSED(input_size);
 }
@@ -105,6 +121,14 @@ static BROTLI_INLINE void FN(Store)(HashRolling* BROTLI_RESTRICT self,
   BROTLI_UNUSED(ix);
 }
 
+static BROTLI_INLINE void FN(PrefetchBucket)(HashRolling* BROTLI_RESTRICT self,
+    const uint8_t* BROTLI_RESTRICT data, const size_t mask, const size_t ix) {
+  BROTLI_UNUSED(self);
+  BROTLI_UNUSED(data);
+  BROTLI_UNUSED(mask);
+  BROTLI_UNUSED(ix);
+}
+
 static BROTLI_INLINE void FN(StoreRange)(HashRolling* BROTLI_RESTRICT self,
     const uint8_t* BROTLI_RESTRICT data, const size_t mask,
     const size_t ix_start, const size_t ix_end) {
@@ -156,50 +180,61 @@ static BROTLI_INLINE void FN(FindLongestMatch)(
     const size_t dictionary_distance, const size_t max_distance,
     HasherSearchResult* BROTLI_RESTRICT out) {
   const size_t cur_ix_masked = cur_ix & ring_buffer_mask;
+  const uint32_t num_buckets = 1u << self->bucket_bits;
+  const uint32_t sample_mask =
+      (num_buckets << FN(kSampleBits)) - 1;
   size_t pos;
 
-  if ((cur_ix & (JUMP - 1)) != 0) return;
-
   /* Not enough lookahead */
   if (max_length < CHUNKLEN) return;
 
-  for (pos = self->next_ix; pos <= cur_ix; pos += JUMP) {
-    uint32_t code = self->state & MASK;
-
-    uint8_t rem = data[pos & ring_buffer_mask];
-    uint8_t add = data[(pos + CHUNKLEN) & ring_buffer_mask];
-    size_t found_ix = FN(kInvalidPos);
-
-    self->state = FN(HashRollingFunction)(
-        self->state, add, rem, self->factor, self->factor_remove);
-
-    if (code < NUMBUCKETS) {
-      found_ix = self->table[code];
-      self->table[code] = (uint32_t)pos;
-      if (pos == cur_ix && found_ix != FN(kInvalidPos)) {
-        /* The cast to 32-bit makes backward distances up to 4GB work even
-           if cur_ix is above 4GB, despite using 32-bit values in the table. */
-        size_t backward = (uint32_t)(cur_ix - found_ix);
-        if (backward <= max_backward) {
-          const size_t found_ix_masked = found_ix & ring_buffer_mask;
-          const size_t len = FindMatchLengthWithLimit(&data[found_ix_masked],
-                                                      &data[cur_ix_masked],
-                                                      max_length);
-          if (len >= 4 && len > out->len) {
-            score_t score = BackwardReferenceScore(len, backward);
-            if (score > out->score) {
-              out->len = len;
-              out->distance = backward;
-              out->score = score;
-              out->len_code_delta = 0;
-            }
-          }
+  if ((cur_ix & (JUMP - 1)) == 0) {
+    for (pos = self->next_ix; pos <= cur_ix; pos += JUMP) {
+      uint32_t code = self->state & sample_mask;
+
+      uint8_t rem = data[pos & ring_buffer_mask];
+      uint8_t add = data[(pos + CHUNKLEN) & ring_buffer_mask];
+
+      self->state = FN(HashRollingFunction)(
+          self->state, add, rem, self->factor, self->factor_remove);
+
+      if (code < num_buckets) {
+        size_t found_ix = self->table[code];
+        self->table[code] = (uint32_t)pos;
+        if (found_ix != FN(kInvalidPos)) {
+          /* The cast to 32-bit makes backward distances up to 4GB work even
+             if pos is above 4GB, despite using 32-bit values in the table.
+             Match is verified when it is used. */
+          self->candidate_backward = (uint32_t)(pos - found_ix);
         }
       }
     }
+    self->next_ix = cur_ix + JUMP;
   }
 
-  self->next_ix = cur_ix + JUMP;
+  /* Parser does not look up every position (e.g. inside the copies, or in
+     data that looks random), so the sampled position might have been
+     skipped. Repetition found there is likely to continue at the current
+     position. */
+  if (self->candidate_backward != 0 &&
+      self->candidate_backward <= max_backward) {
+    const size_t backward = self->candidate_backward;
+    const size_t prev_ix_masked = (cur_ix - backward) & ring_buffer_mask;
+    const size_t len = FindMatchLengthWithLimit(&data[prev_ix_masked],
+                                                &data[cur_ix_masked],
+                                                max_length);
+    if (len < 4) {
+      self->candidate_backward = 0;
+    } else if (len > out->len) {
+      score_t score = BackwardReferenceScore(len, backward);
+      if (score > out->score) {
+        out->len = len;
+        out->distance = backward;
+        out->score = score;
+        out->len_code_delta = 0;
+      }
+    }
+  }
 
   /* NOTE: this hasher does not search in the dictionary. It is used as
      backup-hasher, the main hasher already searches in it. */
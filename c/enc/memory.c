@@ -27,6 +27,20 @@ extern "C" {
 #define NEW_ALLOCATED_OFFSET MAX_PERM_ALLOCATED
 #define NEW_FREED_OFFSET (MAX_PERM_ALLOCATED + MAX_NEW_ALLOCATED)
 
+#define ARENA_ALIGNMENT 16
+
+/* Arena memory is a list of blocks; the most recent one is the head. */
+typedef struct ArenaBlock {
+  struct ArenaBlock* next;
+  size_t size;
+  size_t used;
+  /* Offset of the most recent allocation in block. */
+  size_t last;
+} ArenaBlock;
+
+#define ARENA_HEADER_SIZE \
+  ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
 void BrotliInitMemoryManager(
     MemoryManager* m, brotli_alloc_func alloc_func, brotli_free_func free_func,
     void* opaque) {
@@ -39,6 +53,9 @@ void BrotliInitMemoryManager(
     m->free_func = free_func;
     m->opaque = opaque;
   }
+  m->arena = NULL;
+  m->arena_depth = 0;
+  m->arena_size_hint = 0;
 #if !defined(BROTLI_ENCODER_EXIT_ON_OOM)
   m->is_oom = BROTLI_FALSE;
   m->perm_allocated = 0;
@@ -49,13 +66,13 @@ void BrotliInitMemoryManager(
 
 #if defined(BROTLI_ENCODER_EXIT_ON_OOM)
 
-void* BrotliAllocate(MemoryManager* m, size_t n) {
+static void* SystemAllocate(MemoryManager* m, size_t n) {
   void* result = m->alloc_func(m->opaque, n);
   if (!result) exit(EXIT_FAILURE);
   return result;
 }
 
-void BrotliFree(MemoryManager* m, void* p) {
+static void SystemFree(MemoryManager* m, void* p) {
   m->free_func(m->opaque, p);
 }
 
@@ -135,7 +152,7 @@ static void CollectGarbagePointers(MemoryManager* m) {
   }
 }
 
-void* BrotliAllocate(MemoryManager* m, size_t n) {
+static void* SystemAllocate(MemoryManager* m, size_t n) {
   void* result = m->alloc_func(m->opaque, n);
   if (!result) {
     m->is_oom = BROTLI_TRUE;
@@ -146,7 +163,7 @@ void* BrotliAllocate(MemoryManager* m, size_t n) {
   return result;
 }
 
-void BrotliFree(MemoryManager* m, void* p) {
+static void SystemFree(MemoryManager* m, void* p) {
   if (!p) return;
   m->free_func(m->opaque, p);
   if (m->new_freed == MAX_NEW_FREED) CollectGarbagePointers(m);
@@ -161,10 +178,103 @@ void BrotliWipeOutMemoryManager(MemoryManager* m) {
     m->free_func(m->opaque, m->pointers[PERM_ALLOCATED_OFFSET + i]);
   }
   m->perm_allocated = 0;
+  /* Arena blocks are freed as well. */
+  m->arena = NULL;
+  m->arena_depth = 0;
 }
 
 #endif  /* BROTLI_ENCODER_EXIT_ON_OOM */
 
+static void* ArenaAllocate(MemoryManager* m, size_t n) {
+  ArenaBlock* block = (ArenaBlock*)m->arena;
+  size_t size;
+  /* Large requests are passed as is: there are few of them, and arena would
+     hold them until the end of scope, even after they are freed. */
+  if (n >= BROTLI_ARENA_MIN_BLOCK_SIZE) return SystemAllocate(m, n);
+  size = (n + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  if (!block || block->size - block->used < size) {
+    size_t capacity = BROTLI_MAX(size_t, size, m->arena_size_hint);
+    capacity = BROTLI_MAX(size_t, capacity, BROTLI_ARENA_MIN_BLOCK_SIZE);
+    if (block) capacity = BROTLI_MAX(size_t, capacity, 2 * block->size);
+    block = (ArenaBlock*)SystemAllocate(m, ARENA_HEADER_SIZE + capacity);
+    if (!block) return NULL;
+    block->next = (ArenaBlock*)m->arena;
+    block->size = capacity;
+    block->used = 0;
+    block->last = 0;
+    m->arena = block;
+  }
+  block->last = block->used;
+  block->used += size;
+  return (uint8_t*)block + ARENA_HEADER_SIZE + block->last;
+}
+
+/* Returns BROTLI_FALSE if |p| does not belong to arena. */
+static BROTLI_BOOL ArenaFree(MemoryManager* m, void* p) {
+  ArenaBlock* block = (ArenaBlock*)m->arena;
+  const uint8_t* q = (const uint8_t*)p;
+  while (block) {
+    const uint8_t* data = (const uint8_t*)block + ARENA_HEADER_SIZE;
+    if (q >= data && q < data + block->size) {
+      /* Only the most recent allocation could be rolled back. */
+      if (q == data + block->last) block->used = block->last;
+      return BROTLI_TRUE;
+    }
+    block = block->next;
+  }
+  return BROTLI_FALSE;
+}
+
+void* BrotliAllocate(MemoryManager* m, size_t n) {
+  if (m->arena_depth != 0) return ArenaAllocate(m, n);
+  return SystemAllocate(m, n);
+}
+
+void BrotliFree(MemoryManager* m, void* p) {
+  if (m->arena_depth != 0 && ArenaFree(m, p)) return;
+  SystemFree(m, p);
+}
+
+void BrotliBeginArena(MemoryManager* m) {
+#if !defined(BROTLI_ENCODER_NO_ARENA)
+  m->arena_depth++;
+#else
+  BROTLI_UNUSED(m);
+#endif  /* BROTLI_ENCODER_NO_ARENA */
+}
+
+void BrotliEndArena(MemoryManager* m) {
+  ArenaBlock* block = (ArenaBlock*)m->arena;
+  if (m->arena_depth == 0 || --m->arena_depth != 0) return;
+  if (!block) return;
+  if (block->next) {
+    /* Replace fragments with a single block next time. */
+    m->arena_size_hint = 0;
+    while (block) {
+      ArenaBlock* next = block->next;
+      m->arena_size_hint += block->size;
+      SystemFree(m, block);
+      block = next;
+    }
+    m->arena = NULL;
+  } else {
+    block->used = 0;
+    block->last = 0;
+  }
+}
+
+void BrotliFreeArena(MemoryManager* m) {
+  ArenaBlock* block = (ArenaBlock*)m->arena;
+  BROTLI_DCHECK(m->arena_depth == 0);
+  while (block) {
+    ArenaBlock* next = block->next;
+    SystemFree(m, block);
+    block = next;
+  }
+  m->arena = NULL;
+  m->arena_size_hint = 0;
+}
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
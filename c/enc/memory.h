@@ -27,6 +27,10 @@ typedef struct MemoryManager {
   brotli_alloc_func alloc_func;
   brotli_free_func free_func;
   void* opaque;
+  /* Scratch arena, see BrotliBeginArena. */
+  void* arena;
+  size_t arena_depth;
+  size_t arena_size_hint;
 #if !defined(BROTLI_ENCODER_EXIT_ON_OOM)
   BROTLI_BOOL is_oom;
   size_t perm_allocated;
@@ -70,6 +74,24 @@ NB: use ONLY together with BROTLI_IS_OOM
 
 BROTLI_INTERNAL void BrotliWipeOutMemoryManager(MemoryManager* m);
 
+/*
+Arena (bump-pointer) mode for short-living scratch allocations.
+Between BrotliBeginArena and the matching BrotliEndArena BROTLI_ALLOC
+requests smaller than BROTLI_ARENA_MIN_BLOCK_SIZE are served from the arena,
+and BROTLI_FREE of such pointers is (almost) a no-op; all of them are released
+at once by the outermost BrotliEndArena. Larger requests go to the allocator,
+so they MUST be freed as usual. Memory allocated before BrotliBeginArena could
+still be freed or reallocated in arena mode.
+NB: memory allocated in arena mode MUST NOT outlive the arena scope.
+NB: arena is not thread-safe; workers MUST NOT allocate in arena mode.
+Arena blocks are kept for the next scope; BrotliFreeArena returns them to the
+allocator. Arena mode is disabled with BROTLI_ENCODER_NO_ARENA.
+*/
+#define BROTLI_ARENA_MIN_BLOCK_SIZE ((size_t)1 << 16)
+BROTLI_INTERNAL void BrotliBeginArena(MemoryManager* m);
+BROTLI_INTERNAL void BrotliEndArena(MemoryManager* m);
+BROTLI_INTERNAL void BrotliFreeArena(MemoryManager* m);
+
 /*
 Dynamically grows array capacity to at least the requested size
 M: MemoryManager
@@ -10,6 +10,7 @@
 #define BROTLI_ENC_PARAMS_H_
 
 #include <brotli/encode.h>
+#include "./compound_dictionary.h"
 #include "./encoder_dict.h"
 
 typedef struct BrotliHasherParams {
@@ -35,12 +36,19 @@ typedef struct BrotliEncoderParams {
   int lgwin;
   int lgblock;
   size_t stream_offset;
+  uint32_t num_threads;
+  uint32_t zopfli_threads;
   size_t size_hint;
+  size_t memory_limit;
+  /* Search for the optimal parse in ZOPFLI_WINDOW_SIZE parts of the input
+     block; set by FitMemoryLimit. */
+  BROTLI_BOOL windowed_zopfli;
   BROTLI_BOOL disable_literal_context_modeling;
   BROTLI_BOOL large_window;
   BrotliHasherParams hasher;
   BrotliDistanceParams dist;
   BrotliEncoderDictionary dictionary;
+  CompoundDictionary compound;
 } BrotliEncoderParams;
 
 #endif  /* BROTLI_ENC_PARAMS_H_ */
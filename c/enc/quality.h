@@ -27,6 +27,7 @@
 #define MIN_QUALITY_FOR_CONTEXT_MODELING 5
 #define MIN_QUALITY_FOR_HQ_CONTEXT_MODELING 7
 #define MIN_QUALITY_FOR_HQ_BLOCK_SPLITTING 10
+#define MAX_QUALITY_FOR_TAGGED_HASHER 7
 
 /* For quality below MIN_QUALITY_FOR_BLOCK_SPLIT there is no block splitting,
    so we buffer at most this much literals and commands. */
@@ -44,6 +45,14 @@ static BROTLI_INLINE size_t MaxHashTableSize(int quality) {
 /* Do not thoroughly search when a long copy is found. */
 #define BROTLI_LONG_COPY_QUICK_STEP 16384
 
+/* When zopflification runs in multiple threads, block is split into ranges of
+   this size; shortest path is searched in each range independently. */
+#define ZOPFLI_RANGE_SIZE ((size_t)1 << 15)
+
+/* Size of the parts of the input block, that are parsed one after another
+   in windowed mode; scratch memory of optimal parsing is proportional to it. */
+#define ZOPFLI_WINDOW_SIZE ((size_t)1 << 16)
+
 static BROTLI_INLINE size_t MaxZopfliLen(const BrotliEncoderParams* params) {
   return params->quality <= 10 ?
       MAX_ZOPFLI_LEN_QUALITY_10 :
@@ -91,6 +100,15 @@ static BROTLI_INLINE int ComputeLgBlock(const BrotliEncoderParams* params) {
   return lgblock;
 }
 
+/* Returns log2 of the size of input segment compressed independently in
+   "segmented" (multi-threaded) mode. Each segment is primed with up to window
+   bytes of preceding data; segments should be larger than window to keep the
+   priming overhead low, but not too large to keep enough of them for
+   parallel processing. */
+static BROTLI_INLINE int ComputeLgSegment(const BrotliEncoderParams* params) {
+  return BROTLI_MIN(int, 26, BROTLI_MAX(int, 16, params->lgwin + 1));
+}
+
 /* Returns log2 of the size of main ring buffer area.
    Allocate at least lgwin + 1 bits for the ring buffer so that the newly
    added block fits there completely and we still get lgwin bits and at least
@@ -122,13 +140,15 @@ static BROTLI_INLINE void ChooseHasher(const BrotliEncoderParams* params,
                                        BrotliHasherParams* hparams) {
   if (params->quality > 9) {
     hparams->type = 10;
-  } else if (params->quality == 4 && params->size_hint >= (1 << 20)) {
+  } else if (params->quality == 4 &&
+      (params->size_hint >= (1 << 20) || params->lgwin > 24)) {
     hparams->type = 54;
   } else if (params->quality < 5) {
     hparams->type = params->quality;
   } else if (params->lgwin <= 16) {
     hparams->type = params->quality < 7 ? 40 : params->quality < 9 ? 41 : 42;
-  } else if (params->size_hint >= (1 << 20) && params->lgwin >= 19) {
+  } else if ((params->size_hint >= (1 << 20) && params->lgwin >= 19) ||
+      params->lgwin > 24) {
     hparams->type = 6;
     hparams->block_bits = params->quality - 1;
     hparams->bucket_bits = 15;
@@ -148,8 +168,11 @@ static BROTLI_INLINE void ChooseHasher(const BrotliEncoderParams* params,
        these are too fast for large window. Not for qualities >= 10: their
        hasher already works well with large window. So the changes are:
        H3 --> H35: for quality 3.
-       H54 --> H55: for quality 4 with size hint > 1MB
-       H6 --> H65: for qualities 5, 6, 7, 8, 9. */
+       H54 --> H55: for quality 4.
+       H6 --> H65: for qualities 5, 6, 7, 8, 9.
+       Large window is not useful without the rolling hasher, that finds
+       the long distance matches; that is why H54 and H6 are always chosen
+       for large window, regardless of the size hint. */
     if (hparams->type == 3) {
       hparams->type = 35;
     }
@@ -160,6 +183,14 @@ static BROTLI_INLINE void ChooseHasher(const BrotliEncoderParams* params,
       hparams->type = 65;
     }
   }
+
+  /* H68 is H6 that rejects candidates by tags, without touching the ring
+     buffer. It pays off when ring buffer does not fit the cache, i.e. where
+     H6 is chosen; it supports buckets of 16 to 64 entries, and windows up to
+     24 bits (large window has already switched H6 to H65). */
+  if (params->quality <= MAX_QUALITY_FOR_TAGGED_HASHER && hparams->type == 6) {
+    hparams->type = 68;
+  }
 }
 
 #endif  /* BROTLI_ENC_QUALITY_H_ */
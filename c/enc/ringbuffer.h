@@ -37,6 +37,9 @@ typedef struct RingBuffer {
   const uint32_t total_size_;
 
   uint32_t cur_size_;
+  /* Size |data_| was allocated for; bigger than |cur_size_| only after
+     RingBufferRecycle. */
+  uint32_t capacity_;
   /* Position to write in the ring buffer. */
   uint32_t pos_;
   /* The actual ring buffer containing the copy of the last two bytes, the data,
@@ -48,11 +51,18 @@ typedef struct RingBuffer {
 
 static BROTLI_INLINE void RingBufferInit(RingBuffer* rb) {
   rb->cur_size_ = 0;
+  rb->capacity_ = 0;
   rb->pos_ = 0;
   rb->data_ = 0;
   rb->buffer_ = 0;
 }
 
+/* Makes ring buffer empty; allocated memory is kept for the next stream. */
+static BROTLI_INLINE void RingBufferRecycle(RingBuffer* rb) {
+  rb->cur_size_ = 0;
+  rb->pos_ = 0;
+}
+
 static BROTLI_INLINE void RingBufferSetup(
     const BrotliEncoderParams* params, RingBuffer* rb) {
   int window_bits = ComputeRbBits(params);
@@ -68,20 +78,24 @@ static BROTLI_INLINE void RingBufferFree(MemoryManager* m, RingBuffer* rb) {
 }
 
 /* Allocates or re-allocates data_ to the given length + plus some slack
-   region before and after. Fills the slack regions with zeros. */
+   region before and after. Fills the slack regions with zeros. Memory kept
+   by RingBufferRecycle is reused, if it is big enough. */
 static BROTLI_INLINE void RingBufferInitBuffer(
     MemoryManager* m, const uint32_t buflen, RingBuffer* rb) {
   static const size_t kSlackForEightByteHashingEverywhere = 7;
-  uint8_t* new_data = BROTLI_ALLOC(
-      m, uint8_t, 2 + buflen + kSlackForEightByteHashingEverywhere);
   size_t i;
-  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(new_data)) return;
-  if (rb->data_) {
-    memcpy(new_data, rb->data_,
-        2 + rb->cur_size_ + kSlackForEightByteHashingEverywhere);
-    BROTLI_FREE(m, rb->data_);
+  if (!rb->data_ || rb->capacity_ < buflen) {
+    uint8_t* new_data = BROTLI_ALLOC(
+        m, uint8_t, 2 + buflen + kSlackForEightByteHashingEverywhere);
+    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(new_data)) return;
+    if (rb->data_) {
+      memcpy(new_data, rb->data_,
+          2 + rb->cur_size_ + kSlackForEightByteHashingEverywhere);
+      BROTLI_FREE(m, rb->data_);
+    }
+    rb->data_ = new_data;
+    rb->capacity_ = buflen;
   }
-  rb->data_ = new_data;
   rb->cur_size_ = buflen;
   rb->buffer_ = rb->data_ + 2;
   rb->buffer_[-2] = rb->buffer_[-1] = 0;
@@ -79,7 +79,8 @@ BROTLI_BOOL BrotliFindAllStaticDictionaryMatches(
     size_t min_length, size_t max_length, uint32_t* matches) {
   BROTLI_BOOL has_found_match = BROTLI_FALSE;
   {
-    size_t offset = dictionary->buckets[Hash(data)];
+    size_t offset = BrotliMayStartDictionaryWord(dictionary, data) ?
+        dictionary->buckets[Hash(data)] : 0;
     BROTLI_BOOL end = !offset;
     while (!end) {
       DictWord w = dictionary->dict_words[offset++];
@@ -324,7 +325,8 @@ BROTLI_BOOL BrotliFindAllStaticDictionaryMatches(
   /* Transforms with prefixes " " and "." */
   if (max_length >= 5 && (data[0] == ' ' || data[0] == '.')) {
     BROTLI_BOOL is_space = TO_BROTLI_BOOL(data[0] == ' ');
-    size_t offset = dictionary->buckets[Hash(&data[1])];
+    size_t offset = BrotliMayStartDictionaryWord(dictionary, &data[1]) ?
+        dictionary->buckets[Hash(&data[1])] : 0;
     BROTLI_BOOL end = !offset;
     while (!end) {
       DictWord w = dictionary->dict_words[offset++];
@@ -419,7 +421,8 @@ BROTLI_BOOL BrotliFindAllStaticDictionaryMatches(
     if ((data[1] == ' ' &&
          (data[0] == 'e' || data[0] == 's' || data[0] == ',')) ||
         (data[0] == 0xC2 && data[1] == 0xA0)) {
-      size_t offset = dictionary->buckets[Hash(&data[2])];
+      size_t offset = BrotliMayStartDictionaryWord(dictionary, &data[2]) ?
+          dictionary->buckets[Hash(&data[2])] : 0;
       BROTLI_BOOL end = !offset;
       while (!end) {
         DictWord w = dictionary->dict_words[offset++];
@@ -448,7 +451,8 @@ BROTLI_BOOL BrotliFindAllStaticDictionaryMatches(
          data[3] == 'e' && data[4] == ' ') ||
         (data[0] == '.' && data[1] == 'c' && data[2] == 'o' &&
          data[3] == 'm' && data[4] == '/')) {
-      size_t offset = dictionary->buckets[Hash(&data[5])];
+      size_t offset = BrotliMayStartDictionaryWord(dictionary, &data[5]) ?
+          dictionary->buckets[Hash(&data[5])] : 0;
       BROTLI_BOOL end = !offset;
       while (!end) {
         DictWord w = dictionary->dict_words[offset++];
@@ -24,6 +24,7 @@ typedef struct DictWord {
 
 static const int kDictNumBits = 15;
 static const uint32_t kDictHashMul32 = 0x1E35A7BD;
+static const int kDictPrefixBloomBits = 12;
 
 static const uint16_t kStaticDictionaryBuckets[32768] = {
 1,0,0,0,0,0,0,0,0,3,6,0,0,0,0,0,20,0,0,0,21,0,22,0,0,0,0,0,0,0,0,23,0,0,25,0,29,
@@ -5857,6 +5858,508 @@ static const DictWord kStaticDictionaryWords[31705] = {
 11,410},{9,11,660},{138,11,347}
 };
 
+/* Bloom filter over the first 4 bytes of every word form reachable through
+   kStaticDictionaryBuckets (with uppercase transforms applied) and through
+   kStaticDictionaryHashWords. The word is selected by the top
+   kDictPrefixBloomBits bits of the kDictHashMul32 product, two bits in it by
+   the next 10 bits. */
+static const uint32_t kStaticDictionaryPrefixBloom[4096] = {
+33554435,2230369,36176034,2147483664,36285984,143655426,42141952,536870976,
+672780,2167672872,547358720,2162353931,16786048,335874,135277056,2147746368,
+16777224,3288336721,3294986264,1073742848,0,16896,318768160,67633152,67375400,
+139460616,3238199296,6361096,134217744,4325376,69600008,16777217,1048628,
+2684356649,537233420,2156020225,1074008128,16777217,222888962,625755680,
+1115948160,0,2687508608,578814476,281793,2592219788,99092,1409568800,1410363440,
+1048577,1028,1091043584,542773768,8651313,2148139617,20,2418720796,315624600,
+1141446177,16790016,700516738,23068688,1064960,17541,289669382,1091602132,
+406850052,8917824,2166891091,268701704,499720,131200,543207696,67141761,
+67111236,135004529,134418568,1418469382,16990208,0,1105723915,3222278144,0,
+311690540,2415927298,44042534,537985025,26640388,402706433,2152202304,276889676,
+536871040,1084391424,654378056,269485058,504652048,105121920,1393568274,1048608,
+185604165,3221225472,1073742468,0,3742371872,356520064,8390665,1879089296,
+143131915,269501954,2449620994,2152334992,2155877449,142739456,4203842,
+2148007936,822247425,8421376,2818572741,1082179584,33685504,26214536,201728,
+1057040,1074004038,301989891,272629770,2361443136,536936769,18878464,83886080,
+16785448,134529024,4043309200,1589792,252182534,76546212,145408,404361600,
+356542464,209824256,34144257,574693377,75760001,12722208,3309568,1141899296,
+33570833,1154,2960679112,0,12078384,536952840,1077936524,268484624,469798915,
+2294480930,69206546,9177348,134217730,4027580424,1143275556,2449543441,16789986,
+2050,1075583168,8396932,2692793444,1078132738,109134096,4196352,679740432,65544,
+268436480,794656,0,537396242,537067584,4329730,1498589312,272,8704,1073746192,
+1610614412,18894976,1342185733,2255289344,268439040,1084245013,472322211,
+268435458,41945344,2168196097,3305113601,201556224,2172661781,1086341120,32772,
+9437698,475232,75628800,1065025,1081614482,8407304,899678276,1078599768,3426432,
+1141940232,1141400064,16408,620822536,1075576832,594953,16512,2215673859,
+940048517,106041344,2198863970,185597988,1241518230,1041,2147549376,2162724,
+4219008,337388193,29,8200,1610942490,2155872256,542122241,268439824,1105199105,
+1073742408,0,1107331072,273940868,42206212,1477425480,4194692,3774941202,
+1745035456,2563252544,8388624,0,67109897,688914432,3758883984,557842961,
+1073807360,276842560,8655424,439615766,1074008064,142608452,444624896,134750210,
+71320869,86016000,2206238288,2148559361,843055104,302014980,270537904,
+2151694688,2685405184,268439556,32962,1075873860,5373954,17039380,2166788,
+1073741832,1209008289,536903680,318832904,0,268435464,269484176,1084229700,
+3328466948,8519680,12637184,33818660,268435460,674245320,176752704,536870920,
+84050949,461701904,67305600,24608,64,1075988692,16,0,273179970,270532608,96,
+306184196,2157084880,3846184960,1386285194,2466778112,2222981779,2697990148,
+9568257,70590464,2785036832,1376128336,25460736,541261824,263792,4200450,
+117703040,1048578,419456000,536870912,528384,88092696,2151680512,141955329,
+1677722692,1195641093,0,2156233728,1347432448,291686496,278965292,67633668,
+272629769,67129345,1073811520,2688745473,570949673,420221537,1141925002,
+12722208,2147649540,537001990,268436480,58802310,805309440,1572864,1116160,
+3150080,4194312,3221233920,706740738,85327940,18546692,2449481728,1207992322,
+673193992,67174400,2563317888,65792,268566848,1079249089,33554432,22536,0,
+69206016,1342177824,144769032,67630,805308480,855966112,555220992,1076182160,
+1074233413,8838,143409984,1318912,25090,1207965953,539328514,2182496576,
+286261504,2147491975,1359478880,271381,2100352,1114112,134234112,202637377,
+118505538,10881056,2197817985,403841536,384,1074274822,16480,470821952,8413570,
+151986432,42469388,2164449405,129,570753160,1224802308,1134577920,537264129,
+806373532,1076103203,4097,2215643139,1343229958,131072,0,1073742146,1251477536,
+1280573440,85001245,2189656704,2097160,66877,8982528,1074270277,205312,
+2420834304,1795195777,2625,33555110,167788553,10240,3236007952,0,570687490,
+67379712,849612931,3087278848,98832,587204997,16400,98,2214646528,537460740,
+79825442,37258244,524321,1009000452,1073875015,2151684186,2415927328,1075057408,
+16888064,16777232,68420644,1478501528,2994806821,8454720,541065385,541864516,
+7341097,33920,2852132928,2999190144,547373064,161499169,67112960,34668546,
+6817921,17142729,1107298304,100663319,1199604740,134302848,1080560128,537133058,
+68161613,65537,4098261092,69208208,0,8192,0,101728280,276865544,2701131784,
+268533841,449609728,285443074,1126531136,1228941384,2162231936,67108872,
+1847590912,8685834,1083211776,427819016,524292,293002,8917066,1073793152,
+50340872,4194336,579142336,360972929,26476596,4866068,201326880,2181497088,
+33571136,1076887553,5242882,411042320,38871040,4202548,1090781186,301991944,
+16777216,111188496,2106240,1610752640,306186513,2665497864,167777290,0,
+100794376,336666624,51642368,1074070016,1444948097,1073874048,303169536,
+3225686018,92405832,68182146,1242598408,83899400,262152,1770007491,1540168,
+809501024,135168,6292184,10768,2181040128,537182208,304103940,16793601,
+346623321,844,1218641938,536873220,2751793152,436290048,0,1082294688,1073742914,
+941048066,545259568,2491613204,2240283216,103027724,189005952,3490005028,
+1572864,1615364256,543209508,1386504,2426880,2416972816,269746402,302518272,
+310903424,2695364736,18939908,41040,452986896,2889878532,2550138896,13632578,
+2147486721,16777292,1074135168,2282752065,3229614088,20579136,67109136,
+134750484,570990593,268435457,1611661440,0,0,134930432,2430928972,554828177,
+2281701376,134514688,1090617360,262272,393216,810680456,29364224,3221228616,
+3558082820,277873152,1088,8256,553713796,2191010342,16777728,11080705,16809984,
+67108868,571560066,350491713,1091567660,4198400,1078067216,2416050688,5251160,
+143655168,8421890,671223810,2192359433,2172661905,1346371584,101984273,0,0,8224,
+554716160,2099200,67112960,1170441728,167772424,25601,102241337,805863462,73729,
+537919523,2416446792,2160328708,0,33556224,354418705,77340800,268441616,
+2147508885,549524480,18432,551825920,813789728,1152,135549196,1385512960,
+1143078912,2218786816,262226,606344784,134217736,2155977282,1073751042,
+3258976130,2214659110,33554432,2418018304,805575939,0,1073768452,12584132,
+42139648,2684354560,67119184,38810181,7889104,6316104,67129472,603980802,
+1417675008,33795,16842752,536873024,38936578,0,268439824,1574144,33605248,
+318783488,1074266628,144048130,539616583,663585,4103,402653184,17072656,
+270860416,0,4202496,2290098256,41943043,4194320,545276032,8650768,202907916,
+17858563,463995296,268730636,134295824,335552787,1117819264,1074532352,0,
+2727346712,408423680,553715210,138412032,356533600,403701829,42209280,
+2181300226,2129920,1080042761,571506820,4460872,544,184386,55584777,3290964033,
+4456737,1610646656,537068546,0,35672064,0,75531264,1107298560,2155970642,
+2720006144,302056560,5130,17961732,84549780,536940640,2265188354,161495552,
+536887306,1073741856,1618020673,2147778747,526496,17305664,4198528,2240604167,
+2552586496,4198472,1142948932,2164261044,541327361,1161822371,269305876,
+134742016,3774873600,65568,335553590,271713408,536879624,3489677376,268767760,
+71320320,0,2114,134728,1178634240,67651588,126682244,3254781952,134498304,
+2637888,2324300944,1573995,557056,1182992523,12718648,54534784,1079517185,
+276898888,570434952,303038496,138412032,68183040,276824064,2147483649,856951432,
+142898208,1208027209,2415921408,3029336866,50646048,2168459264,100665352,
+2147487744,2525128704,2168161,0,269355662,1122304,29432448,67571744,4198400,
+4590605,2147766609,2168717312,268603397,135266304,1644168748,1082212481,65538,
+2231369889,1050880,538626,490816531,1417939584,1616380992,1610645536,2155937856,
+1103233024,268551232,201334869,0,268435458,872489876,1074858763,2316435456,
+2421826560,373559826,0,86278677,2164260868,671088640,338692775,8454144,
+536892425,14954496,818603008,2198081560,16768,2214625344,402653184,104923520,
+1142169088,37440,0,536870912,335548416,132096,67305544,2290139149,18891008,148,
+773328929,83968,1077937156,11534848,2181144704,218103840,437783205,4194320,
+2684421635,404226080,67633161,35782825,1098907973,1125189636,1075315722,786452,
+0,4735521,1372811268,9856,10485760,2483363860,8650752,1384384576,537001984,
+266240,272629760,2281701376,25274664,4194305,0,151257185,65539,9503232,8405248,
+268960128,219857168,71581836,1342341504,8388640,0,2170896,1094713344,276824064,
+301998096,271059616,2014315520,1614840832,46203424,22041614,739836165,268566528,
+1073758208,36733094,1142947841,2298740740,2433483844,71303168,151654400,
+562602024,285237277,17170465,536903682,1929609345,4128,136446080,0,8421376,
+2158010369,2156429392,888184832,2483290116,33554451,2234991253,16826496,
+2155880448,2183200768,2231377923,20971560,4461120,71303168,16896,2147483969,
+1082377745,2684391427,3359704064,3221299360,16794624,537001989,4718592,0,
+1184104456,19206148,12664840,570425348,1863948,86671540,269485184,2717975050,
+1074151808,17442,1079051600,0,68161731,1127496192,2155880448,1376817155,
+2743077888,2151682048,639771138,2149633544,1346372100,524469,1078003721,
+541589506,18874368,155471875,192555522,268435500,1141377552,918561796,807473160,
+161682434,1048584,2248295042,1081344,75509760,2148303112,4194834,67407873,
+2147614816,4181987332,386138156,51380229,1149526146,2752091267,3223330819,
+331780,67371008,2241156096,4718852,600068672,35652104,0,8947712,3281010689,
+2097216,1320,1082196099,5648,12853248,41943040,85648385,0,1344307968,524289,
+2097152,8388640,3225489664,2022817794,1073741832,605032448,135793736,276865684,
+1346535944,4194305,2375684,1048832,84226048,0,1074004225,1116226145,81925,
+268507169,1015175425,536872258,805331492,34091008,16640,73400346,272699392,
+268435540,0,1266683985,0,3223322656,352342016,536879104,3292594448,2290475016,
+3493888016,0,1082132704,162611460,2888548384,2252358728,2701131808,1480668257,
+135281473,2147811336,268445825,0,2099392,1073745920,54646786,285581360,
+537919488,269617156,68699216,1288332323,2151744512,536871424,268436744,
+2152532512,42233924,33825921,2147549617,4194308,2099456,160310281,2049,2049,
+1098917265,2835382544,3264849445,1114112,545292544,0,1196160,572006402,
+142868826,268566545,1175790720,2727937,2222997504,2281701381,0,270811141,0,40,
+2424307714,17072268,2147484684,68173891,3223339168,0,3307278880,2837669001,
+1394737157,4325376,136433664,621197600,9183253,2155873792,131073,67125248,
+1140858944,0,136347650,2155924996,262496,2231631892,807676036,1179648,33620028,
+1049088,33409,16779264,33622100,2147483650,26283522,537663745,276824070,
+3256877088,852000,1074333185,3225441410,65,168035344,4608,1755348992,22028304,
+605044880,8405004,1074038789,163577986,281019252,541065216,39354376,268455937,
+872515136,2147762504,16386,824247360,1577252,101715970,169877522,2099750,
+3326347264,4194560,36864,33028,2992113664,406852165,83886080,272761865,71303171,
+754983104,5001217,38273696,340804161,739360912,536879233,1075905104,3263168512,
+276824336,1442048,1107296256,33587200,134494272,570425874,67108864,136,
+1828720664,1077973504,76611587,3288335488,547981572,103825410,318898184,0,
+567357440,1346668613,2148007936,18452,541720576,276856896,402686007,67109186,
+263426,563122696,67116032,8396800,268439824,84451336,51388436,2560,570974209,
+136323208,104988936,3430947601,1078084624,807444480,151060481,33562644,
+378020373,12288,2684649472,8454144,1073408,2148534280,345055889,0,159400004,
+1075060768,318823424,2147517442,2474903043,811623456,2184716288,2217017344,
+2168465424,1610875139,2650868184,606079236,1073742080,536870916,1621131300,
+67114000,537146402,2751594506,165814464,8320,537136522,1103696320,2315255841,
+4094369800,268451840,19267620,2621569,151519456,8650752,25166560,6291552,0,
+338960896,1157859586,226566656,2560,24,34605712,138952736,805406336,1157627905,
+50335760,2419332865,16388,1082143776,134222856,2064,134236416,2147616776,
+85983545,21577889,67633472,67109088,2150302264,4196352,302120992,269487184,
+1350566157,1095774343,278976524,16777280,1073758208,135563400,3221274641,131073,
+268435590,537155722,2282243328,1078002688,17834496,2155905536,0,131074,55589032,
+35651652,1077936200,4219905,1629552672,262404,71696384,85789057,1048613,
+536880129,1109459076,200705,209723392,167907328,21037084,2181054468,711049344,
+673185800,2421236160,144,277021952,261,2802176,1124073476,12779568,10617952,
+2991768577,2113,71303241,67108872,38274150,536873509,1610743940,268567559,
+1048592,1227624640,343040,270532608,67895808,1342177280,17846549,2147746888,
+335552597,369101136,57360,419434496,218396808,2147631108,1210091536,138544200,
+369164356,1573378,67176465,589109836,2219049008,0,604111432,2181301632,
+1073743880,18219079,1073770496,545292544,2684354560,289433888,2147500032,
+2151751680,1074934281,34619400,4210688,3242328324,576,1485836416,1024,281051216,
+1346,402785297,1342179584,2149777664,1879053380,2349076736,0,68157451,
+2155902976,3288933122,268640256,344457232,134236801,2177044544,134222912,
+6556675,1614825510,0,33619968,33767424,2692743184,7340672,570462216,118491168,
+2281714944,42991888,66048,11076673,299016,1073741828,2182119456,2151677952,
+2642420584,272712960,2228224,1124073806,2626781184,772308992,1176521256,1048580,
+41943040,344981540,1107305472,28311552,9437184,282637218,1074790400,541065249,
+1342178320,1048868,569270353,252121153,2155873426,20,0,36208832,402916619,
+8423320,2164260864,1073751008,101449869,268474624,605372674,2147504129,68698368,
+404762656,1073758280,168302641,1342185570,1210271809,1493172260,1084228752,
+201719808,257,2220139522,570793984,8421376,18186497,679773637,108581136,
+269488265,2291138589,2768905824,1082261648,1077937168,541069314,273154304,
+2432967078,268601344,9233,2164529187,0,136135712,117264,33554496,76169216,0,
+10101296,343966723,2298478662,553877536,35651584,8844,67371021,76024076,
+3506454784,268435460,2420513538,134219776,54657281,513,536870920,19267584,
+2155876354,536875026,84952066,1481654272,134218371,1093763076,68,3437232640,
+8406017,677393672,33555458,67174944,1105204225,3254779940,268443793,285299712,
+134283264,5242880,2129936,403776673,4133,0,807403524,32772,33694212,675285632,
+467713,1410040481,603983944,273176660,1143099392,92279040,0,64,1589792,
+1382712930,335765540,33556547,2315272198,805446660,1082134534,73761,65616,
+2224046112,268509192,273008677,16777860,18892,14962704,872640513,33920,
+203735305,2181038080,555745280,36897856,340332832,570425344,671744,1107630124,
+2353397760,1073745992,1380352,0,77678848,550502471,293408,2155872265,1141547008,
+9455712,226758657,67183456,1083052033,33554584,201326592,1342177280,163840,
+277885328,16844816,13666308,3906021636,1048580,514,10617600,822363136,
+2152754177,287844648,2147745857,805306626,1075939850,1150304260,1091044360,1152,
+4027842560,3221358624,0,34084897,541065216,352849921,152576,0,258,0,1074900236,
+2432706580,2065,35725328,277348354,75530252,128,268443648,270536705,135790848,
+1184433160,268510208,131074,1073905728,10,272629888,0,303300680,612433920,
+1073755648,95551536,26321024,2160074784,549453968,0,134217729,34079745,43122688,
+142622784,0,17039898,174325772,2148532240,824443905,50335760,33554448,
+2150901264,2113536,337915904,335880464,2313184776,2113602,0,1697645248,9,
+21495840,2242028166,1327105,12599744,67638017,16778240,2895413282,847577092,
+536870928,314572800,143263761,566497360,0,42471452,2420654407,1098907796,
+554500236,2752561192,0,302023058,0,263491,2334130341,1140850688,170133894,
+2147551238,2153287744,0,1111491584,2214920192,142606336,805339137,1082228737,
+1099043456,675283978,4915200,274727168,33554440,404226432,553950344,3389194274,
+672399624,1285,1081344,19136544,1358962688,2333081602,1074790406,855708704,
+68157478,75497544,8720606,3296731680,42074116,428081216,1572868,1124597952,
+276828168,2417492064,2688562081,16778240,98304,9585152,33685504,672661584,
+1049088,832070,83894283,4456528,0,1347956807,67523974,3567551105,22020170,
+2156429344,1276133385,33621124,541100096,150994944,50368548,34111520,268532133,
+1880109314,2596541606,2986349574,88080400,34078720,234882688,2685140992,
+675901452,182277,100800000,4456856,1694905744,973168680,134480001,4465800,17,
+2147483648,641860866,352328744,169349713,436273169,33816576,1075856002,72,
+3422553871,0,2483040263,268439808,234897408,0,3837960416,4195328,138990670,
+272894656,1350851584,117571604,301991936,603981824,0,2424833026,1358963200,
+41943050,151060549,134402064,3925999876,1073815570,805585672,25664,270532640,
+2189301764,805306368,268566528,1478647872,2453672072,404817281,13633793,4720672,
+2164850736,0,0,1617071488,104937872,34037760,0,604242272,33622032,8208,17,
+4196352,16851016,2235640640,0,268445956,5,3795849288,2193643020,3288367121,
+738213888,162529344,19939842,272761346,2151677952,352325648,185942160,
+2215379466,100794370,134250562,2164261889,2172977,268959776,360714,1073745920,
+8519680,1115947296,0,1685258528,37751848,538968064,555771904,841260052,4608,
+2163840,67224,142610688,2168487984,131136,536970240,2148286498,1921516355,
+270696577,1077938641,1074332672,2147618820,1082131457,2485141505,2064,
+1628963040,16789520,542378096,364977464,0,270336,419500096,3698693,1342177284,0,
+4333632,4330114,138436800,1342702672,285221122,1209147523,33555168,301996032,
+5505025,3247426828,2153056531,0,77603200,1572896,939541506,2282031108,0,
+469770240,268500992,303436292,268705870,537133520,2852151529,536936968,
+1351622662,310771720,0,282066962,134218761,264256,268436226,2181235200,
+570490944,251662336,274726916,65732,3532656836,3772343661,268435520,1365123108,
+150995009,297799944,144883777,272634179,33570836,1078264225,1149304832,
+302530832,2687045,33554464,50659460,84082688,8388640,0,37748736,104863888,
+67142144,1073745952,1053721,16777217,59572292,268452384,831072385,145754672,
+4194336,84426764,75563520,8654912,2793415696,74187266,0,271065160,77357696,
+4221060,262149,59312812,4213009,4202882,1021338945,2183139368,144216064,
+2283130897,21512,650445825,738199552,16781378,184549516,1610612768,65568,
+268698824,100739080,0,1082130592,402657408,1080318273,79710240,167952448,
+680534145,75497472,272902208,437781156,67108880,33823105,2231642385,553717888,
+268511504,197632,91422784,34605056,4326528,637739804,1476415504,536986626,
+1074790400,33638416,3222603837,0,58724426,1573408,17043968,1311808,201441344,
+2422407209,131328,28312773,134316309,0,101718016,33759236,0,679665936,75497988,
+67125248,270663824,69210112,3162240,3235291536,2179136,3145728,2685419804,
+1579008,1438,105906177,10,270818,50610304,3288367258,1216,671088640,2151809032,
+576,524800,142614528,2164858905,1346375872,823134208,32768,2692893697,0,0,
+67118084,67331332,2147778564,262208,874514432,0,117448225,67175300,295425,
+17111296,336068640,2374043648,1028,2684633121,856822272,67191811,524816,
+2147623424,672433152,1073742912,2181038370,274993664,1344274712,438576148,
+537659424,983369857,622871,1074790400,12585472,0,270008352,268439552,2152202248,
+2147549184,8519684,34619650,1494487112,8421648,1113619618,807409670,2483060736,
+2148404272,33592388,2151942144,1610613000,34603008,24576,1107296610,1082335888,
+2170571780,805388945,2214592512,828379353,2181333148,538984577,273682572,
+1933845072,277872768,583286784,1310721,9,301990912,286262288,810582018,50331744,
+16781312,2147755776,18874528,2157052052,311493893,0,532480,2147880289,29365892,
+603979841,2690650256,268437520,54592385,327450624,8390724,1048584,470024237,
+42996312,147404306,134221824,805310528,268992777,676337664,3510634752,
+1187123208,4168,2147483656,0,2156331010,0,286409762,672404545,301998096,
+2181038600,2147536896,2172652066,1386479649,67633152,270532608,2709520644,
+1048841,3794798624,50331936,13139974,0,1145106498,572010514,346030080,
+2685403528,1610612736,538452993,4821784,159387981,129,335553536,1073743872,
+1107296256,386074696,4195586,268435464,133706,1141135441,2155872256,2713722916,
+4194304,536870913,2149591168,218145536,478167058,415393792,2969567328,3266,
+2424308992,3422620680,4198400,324380738,268445696,335701250,352323849,134332466,
+285213698,0,3229889028,2436893184,8717345,2418019841,67110920,69632,3221227776,
+17309737,4194312,1120938196,3225419792,2189762570,2416969731,570589184,24,
+42361088,168953864,355664068,1093664896,219493520,139329539,0,2166361216,
+2717909249,807436456,683677696,8388672,2147747840,1174669460,318771488,21364736,
+133120,536874054,3239057424,1077936192,262144,2260729861,9176069,16,2148603936,
+553713668,272761922,537019392,5914880,201326592,270533200,134218020,2138128,
+262208,2686549136,272928772,34611248,1095115268,1074135105,143337472,8200,
+270794793,366347859,34,4325633,262704,2164785568,1074332738,2164260935,2056,
+100738184,1078726656,34276001,223355474,3784886276,340008,136841221,202375170,
+272639765,542650370,35676756,273159368,1025744897,0,4196356,847257658,2625636,
+504434786,283680,67305600,3225683970,1572864,131200,0,1073743872,8585344,4352,
+1073741828,2155872641,2147486784,671354882,138412032,1480614056,553648259,
+2684362754,1610613000,2164786196,277913664,1359085568,1350466,1074007136,
+71704608,671099906,303042560,136,2170826752,271664,556285956,17958017,2163520,
+573801360,270672384,75498512,1892692224,805572673,403701776,0,0,12615939,10116,
+33554691,335544332,557875608,1055744,285212672,1149239296,1275071761,268502019,
+2755952704,1140852493,4227120,2151678240,2617508113,541148162,2117120,889192448,
+25203748,84541472,3258974734,3027272832,1360537728,66068,272760834,239994465,
+1074865164,2147770373,134217984,262144,541360138,537919690,71307458,0,
+2215903492,337642784,4259840,2916420,539527169,0,136314920,32872,16512,1315886,
+67174400,134569992,0,0,1075054801,6293025,3776993294,1073743889,403062788,
+1073744900,5243152,0,605816842,2164326400,0,35759233,19238800,1081348,
+1262512448,210927620,67249280,1140852753,327682,1816133665,339476491,347542081,
+402654912,1073750016,2292188944,104,4718592,1179657,70582273,104580096,1048772,
+68178340,805307394,268435457,0,1117440,393216,1079517190,805437632,135266456,
+1275687409,2147680257,1074801537,536871168,83886600,83886272,2359296,8455686,
+85198082,100663296,2541754468,201392768,25165824,16640,3221757952,2310042625,0,
+1912603684,2252928,109057092,4194437,16896,268500992,1610810660,537985032,
+1073750544,2292781073,3,1082664640,132098,2248148992,67117568,2316831378,
+1082159748,33619984,65859,88080461,302252226,1440224278,209717249,2685997572,
+1050144,3307732993,33554440,2155872260,33554464,109388805,1073745920,0,
+1225261604,2149343392,1082658840,134219781,1364398080,2415951888,268960080,
+25124,404230176,2619361632,0,637821444,76022784,67635232,172097692,16930,
+268521472,9175056,587236130,67240522,1074790914,536872968,8519680,268451860,
+84000,344096904,2158035457,335544577,4194432,1084243030,185113224,67175744,
+538050568,2164424704,277905416,67584,2165932040,262176,2416058388,536971274,
+545394688,2147910656,2181046400,285212672,2157189259,680812550,2158039616,
+1152018,361260032,2147747840,4736,16777224,268992640,542136484,822739200,
+16777280,33570880,0,276825172,982540812,1175472134,236978208,807404704,
+398723350,285213698,67403840,2147501825,268476448,2541749304,1090592,4195400,
+71844864,274858056,2248151040,0,0,3767171200,2152212482,2294697989,0,33554433,
+1074798792,3247198240,0,335544325,2151845377,1073743877,135397376,335544744,
+138543616,8437779,1346439186,0,857747984,553648129,33559568,285225220,184558656,
+19005456,2232221764,2290819144,637701124,1346414595,1116733508,33595392,
+679739458,1073807360,302022656,2432701451,0,0,4360,50405632,0,554508856,
+302323712,89166464,269484161,42999808,134217984,2097184,0,0,185073664,
+2965377620,2198003744,10765377,336990208,830476352,265472,2216003585,0,
+2168719392,2097160,1077936400,540051464,1107361888,8585472,9570304,2056,
+4027843599,2052,816971808,44894264,1163298945,1343291392,2880,16777224,
+583139352,302022688,1073807360,264192,1008095363,117467200,272629765,0,8388678,
+688918656,302276609,1762676774,0,0,344069416,1052933,2140160,0,2172682241,0,
+655444,1368133632,403706912,1208222880,1073741825,2202337473,549455876,
+589832217,1082540676,2684354625,143134980,539525664,1688453203,0,16777248,
+524800,0,843056162,17305988,32,18433288,1310740,3489798144,167903248,16863312,
+2148016129,1073741840,336112656,0,8912896,113513992,536895588,2360448,70254596,
+545259520,470032900,34081922,4817160,4349957,11084416,331786,67112960,0,
+3225550914,1481691680,0,268435720,1074006080,268517380,4194368,2294284352,
+2684354560,8240,138428480,58335408,3364186692,0,92554754,1418731656,20996104,
+687942148,2449952801,1048580,2156012034,1651106098,2151813120,2349088896,
+2326070792,2181371944,2155896832,1025,276826244,92277760,2350907397,2165445089,
+8391232,1107628032,33703976,42008976,25171968,0,92324096,50757632,1073160,
+67436556,134217984,805306368,75776,687877266,75497729,1114561,1074446354,
+2147549218,2282225920,42093610,1375732224,285476880,1543536652,16793633,
+134284800,3498082304,3494510596,2148925440,2416095496,27527296,68165762,
+1095278592,558399520,41943040,1074071620,1132511232,273945600,201326592,
+2147484608,0,616628488,4,1617035266,51118592,33687554,268443648,134742210,
+536873004,604446722,3256038209,553722256,10487842,1074809024,33820688,0,
+1099499537,2183168000,1073742947,2149654528,16777248,604606482,17113360,
+1073745920,17630240,2191573448,14680320,276831408,43528192,33571172,1207967808,
+1616905280,2349121808,2359296,543163456,5252096,139730947,690233476,4292608,
+43587588,2416973826,3255044881,0,11567105,8519808,33685504,0,1073745920,138241,
+402653962,1208502792,279447556,10486048,606077633,2181466113,621944832,
+344721473,76289090,536880136,109060360,33554432,268697920,25297408,50355200,0,
+71434248,1083441234,1078116352,698933384,1345536,360972,1108508849,97849472,
+553910274,23146624,262152,2164523265,2689698384,268447762,2316308481,1074069521,
+1152,0,3490709634,1050624,420123144,1104281700,3507259858,2684371008,203510024,
+2148536328,3380675652,1073742080,134221848,1189888,525833,268969984,2147484204,
+2181562400,39651524,2171338754,268566528,89129488,336855168,3143653377,
+1879077431,2181038080,2151687445,2147749888,1073184,1084761140,134480130,
+818151456,132352,118491154,22554630,2333085762,0,2098176,167788610,139264,
+131136,134499337,3489662976,0,544772,2730762532,3770949826,504430912,407408128,
+0,786432,3,2554079488,302178372,67109888,35651584,285280256,16863264,1074268224,
+0,17,2300968960,805601280,1082188353,0,2147745792,38838400,268452929,5242880,0,
+2554659077,2709521728,1329603185,17825844,1376452,33554688,1078984992,
+1342472192,536871040,570556416,1017118976,1099976758,524320,539164816,16777728,
+155320456,33987392,16777248,3556781312,1200619536,1490551127,21071368,
+1350570026,895746184,125849665,1048832,1346392064,2148565136,3703638019,
+1082134689,0,98304,16777408,25165856,2214592644,4194816,2164326416,4352,
+1147210048,637534240,2102448,618161188,1107298560,1361052676,1008792724,
+117444640,33556496,344140181,66577,687867904,3053518872,3783393792,50425732,
+1233142049,1444481090,32,914884656,0,16910464,318768642,1074790400,640,
+536870976,8208,1074532352,6272,16781570,48302081,3670306,544785,540164165,
+33816576,2424307714,28311552,1342455954,4341762,16809984,0,17181064,11012102,
+3156285581,2722105600,268435456,201408512,67584,134222149,136339456,1409352705,
+571965440,2151677970,1073742096,1082134656,3301138457,2147518976,1344815108,
+536942601,2416975874,280000525,12976386,1091707972,402654216,2437160994,
+272900880,25165824,51022848,2906984449,2361577736,524356,110141460,68609,
+268500992,41985056,1409483296,614208960,272891908,4198400,0,3221225505,26253824,
+805437524,3231711298,262145,36996,8389632,151041160,0,2693005696,67118592,
+1342179840,545296448,49524,100728833,1140852228,675315972,151005697,318771200,
+4194308,90113,4338184,570822688,2231766036,4728865,0,89653257,562315428,1048584,
+8213,2148286496,134791185,34866416,79749632,1073808000,2147617360,4997376,
+1644173568,2158043152,0,19411401,33554563,2290385733,0,2214593794,84447744,0,
+6475780,2224029696,1166033093,33636352,4194912,5260288,549888,9054848,
+1074020352,439500800,571533505,360500,67109888,17047656,2147745792,560145056,
+1107335305,1074790404,82952,10243,2013348994,570434048,0,609255680,2491441152,
+2227291201,876618752,88082440,2420113409,620810816,805572609,934144,10747938,
+272,209985605,538630,152049666,33687552,276971521,1311243,572524928,8389632,
+16978097,7430273,1111542344,8458240,1073750016,310542472,152569897,3259139136,
+1060865,371462144,269502473,17825792,3247726602,0,1073807360,2164458688,0,
+2483569168,0,1353719977,268443658,1386488321,2139008,2157183045,2151678208,
+134363136,271781916,335850272,579076098,546083024,2720137216,8194,50331704,
+172032396,1477052935,1143223312,0,131584,538001664,16908417,70255234,32,
+3540520352,3254976513,8404992,34603558,135335960,8720676,84410432,19407642,
+1074659360,1111499270,423925828,282067200,67141636,0,17846305,2952818784,
+453249096,1073741825,19660864,65666,134217736,3372224659,141320,276922414,
+1073808450,2147555332,131472,2147488896,2484617984,202375428,67108865,301989921,
+4099174720,1073748096,16385,34218020,302776388,186649752,270549125,67764228,
+111165440,1342185792,536872960,437387920,1076102144,2148548638,1077675781,
+673187843,134219072,1233653760,81821708,1114177,16384,3028845701,553680928,
+2155872256,205799432,2226164417,138448965,537133721,268451972,2434806023,
+146836480,134218369,258,33685504,570427400,1074304002,136387584,268440576,
+9179136,268435458,3759227152,4194440,4194305,2214596616,2491426080,8587282,
+68333056,891437106,520115723,135274885,1078047368,441122848,2423521828,
+2483159040,67109378,330600449,646125696,2435056289,0,1108910592,604065800,
+437398723,312107008,134217856,414016,0,1094713352,3243262000,874513409,
+444596224,1225327106,2449563680,9216,2150904072,2755854336,2290442243,2244678,
+639894056,1048592,302740996,1637089298,1084590084,2155892800,1629488256,
+286003329,2550743680,1108904205,8454148,604767811,2162688,260,2147483776,
+84007744,134225920,2164260864,0,813699712,2986360840,2147745856,270408,
+403857418,1088440320,1612804241,266240,0,3221228352,0,67317760,6144,135266609,
+302712354,168821760,196608,536870976,8405250,102244358,0,8440073,8320,
+1108475921,0,1109656640,268435460,536870920,203685897,1208492032,8709,829588882,
+805307504,74584576,17301504,2189426724,1073807360,2307067904,4198400,34080292,
+79699968,134815753,139792,839320584,35651584,37896708,2152865792,8525376,
+2422804536,1141113380,16778376,2215903232,1090551809,109316097,4194371,262400,
+4028736034,2705858640,340134154,2163233,360775808,37748736,554762240,0,
+541065793,673448000,2151682056,1073741826,2147745892,2018251074,142606336,
+5537792,2689335296,1088421915,268439557,286261376,1426104324,21004304,272196103,
+1879052304,572786752,2751479808,38017026,277381200,1142505548,16777218,66560,
+805376032,805306377,13435328,133192,824184200,2416069400,436212826,268435508,
+1409309253,1140850688,268439808,591667200,2282039873,1611792896,33554440,0,
+536870920,84313089,1389625359,1141117104,553656352,1611661320,2355101833,
+335544576,2701263555,1346504136,8224,576,1611663368,268460032,3431153754,
+1207967746,14484744,1152,2157465600,8391200,1048724,131076,2155875480,8390656,
+1094713796,1050624,65538,537403400,33561600,1242112016,9437250,111413252,66564,
+67377732,4325376,32800,268435472,3489662080,1572864,132096,270532608,72614058,
+109584771,2462384640,134217792,2182733860,3736224,4874,114430465,50304,
+2155872528,536887306,0,16811024,1109012480,807929952,2181038216,2147881476,
+2216952608,1140855040,3623971840,858031873,0,83886084,1883250704,176230578,1152,
+2751795200,3397403136,2255257857,1342177552,1611417828,302002180,1178828800,
+67305601,75497472,1073767680,8655104,2432966660,1079518592,33890304,538443810,
+6403098,272642,46272514,1225786432,2147483776,1073741952,272631824,1073827980,
+134299680,2149876744,403832832,285508524,17539,100671520,67377152,67872,
+2214856704,1835009,537659392,16777217,33556746,336086545,1342177345,33783905,
+506126369,2181169152,209912836,66560,2480,2246881,0,1082197253,336102536,
+1345487493,17408,17408,2181040128,4510610,4161798406,2147484772,67178512,
+156251144,1346,740295680,1225027840,2156134528,34079234,3278848,1083183234,
+30417213,8200,4027129992,16814977,0,235016704,135528512,269485060,1108213760,
+117441408,22020354,16778376,9187328,67109376,65568,66,67379396,1478590977,
+336680450,1073759248,12297,0,17306209,595943560,2686488704,40894498,100926500,
+1342181414,167846449,65552,2552496164,67657772,671612932,70845536,32784,798720,
+302018593,287380546,2155955000,2386837632,203424002,2954914864,1346375680,
+68944898,0,537464832,340033536,554795210,335577088,268435464,271582208,
+536875011,264228,2222981892,277160064,134217856,155206658,264708,1251739488,
+430080,16777489,536870920,59148817,1057692,3221632,134242976,24,3355459593,
+268435712,1343295744,1946157056,1107314304,278932768,16777240,16616,2762014763,
+0,85003288,75498762,2166428164,2713978944,2105344,0,288,33024,35668296,
+537152528,0,4194560,43321930,285474832,536870914,0,335544578,67403784,147079168,
+1074298880,3531752464,436734272,2432704512,33587200,1196064,67373259,1073742224,
+2451570832,1954975744,291520528,539566081,302125570,69337092,1056768,37773702,
+1074790405,3175352864,1615134994,574750792,6291552,3145728,1200524,2138128,0,0,
+1371835412,17039360,285212764,2149753344,34144272,462944,2769094656,1029192,
+67240457,346038304,1955350720,2956083972,2146312,1082204672,532480,4718595,
+33554433,2417238052,2350122000,33796576,32784,1283,268843267,67112960,
+2295464219,268568578,8388736,2113698,67135494,1092927762,2181039256,29120,
+33562884,536879104,0,537145345,18876676,2162724504,1261984,0,3415044,4194308,
+289415730,138938372,542687392,1379994744,0,101195796,1082263564,134234184,
+2555379853,558137352,1091641936,377751816,24135920,536870920,134235200,
+3690990664,272900880,25174016,301990976,537927698,174096396,7405829,0,
+3314025731,35848192,940580864,78655744,3620737219,1048608,2433048,536870920,
+268894213,2197817344,1209009409,131584,541199616,4390944,8193,1946681344,
+16777224,17860739,174196740,2164278402,8396816,2248165656,32784,4325376,
+2417557505,0,67373092,2638432,58761244,2685440552,2504525836,524290,1143224336,
+73729,1361904648,2147483683,42996224,2181038098,541066248,2282258704,812921096,
+75653722,2250135562,547635464,2105344,8388608,5120,528928,73007760,134217865,
+3229945858,3759210503,4194560,536903680,2148141056,1082526024,16448,167772196,
+538183680,3758104576,2415919362,134235152,2151702528,786432,279986320,
+1646307458,2231369856,1157760000,314621952,1610907906,1407541552,554697796,
+1111503872,3691127562,0,4268034,69238792,148897792,9437184,268624096,402661536,
+268509194,337643528,1484833818,50594048,272929317,16777232,22528,0,0,235934592,
+8851712,2281701376,8667954,117443109,2469921156,671098248,1074364416,2149711873,
+25165824,6291721,0,1048592,949537096,2176925696,270545921,134283264,875561033,0,
+1048580,0,1075920896,1048608,2214860040,67240196,84943488,6561800,270341,
+71307520,1245709723,1720734786,609263617,201326848,301991544,1048922,1296040704,
+403709952,538968193,327969,1053186,1359225089,68157488,1343228808,2231443464,
+2152759299,131584,2099234,1342178368,1145669826,375636496,1050624,2155892736,
+1075315233,2483552512,1314816,68288514,2154111088,1073745920,541417483,106497,
+32784,2098176,67113248,530433,524292,538968192,18907152,556012680,470024192,
+209883420,1048578,2147549313,0,34605312,2290456708,67110917,0,46243905,
+268576384,3225575936,542149126,536971392,67298645,467584,201331968,25166088,
+2147491840,0,51445889,50724880,1052672,16844032,537133065,0,1140853769,8704,
+335680008,676955168,1048646,2097156,8912902,69500938,2508260613,8650752,
+1115948288,3254781952,76551296,17825833,2690912432,67438640,1074020620,513,
+570441744,537018900,268697606,27788289,1051226,2148532352,159383624,2286424131,
+0,205810436,67375369,1074810904,67115272,268436480,2098176,2608940187,20971520,
+18351144,5,536903680,268441672,269484032,534656,1344670210,18907652,67109504,
+134356193,5767,553911424,144205988,811864064,24576,16777280,3306553352,0,
+67240768,2216822792,268443648,34607576,33185,0,2147549184,4194596,3288432642,
+50398597,1210087596,10306,172230688,2156267552,4522050,541098016,2185282560,
+20979730,20768,536875008,246417544,524320,2181562368,4196756,16778304,17039365,
+262208,67125268,3221258256,1210056704,1656750256,139588,0,167864848,33562624,
+1073743872,3489743121,135266312,134498432,3624140872,273209344,27394116,134176,
+272,35717120,1409294404,100728840,2353004680,75780354,403906053,419465216,
+273203200,69681,537665554,268486793,2156937472,346587148,538968168,135790753,
+272662528,2980067360,2688811648,76288193,17958915,100958208,58773540,3766550592,
+3962736708,0,0,49154,1822433537,19939381,2147553796,805307394,1694552128,
+268701728,67109120,136322706,67126272,1353777201,1048584,604078080,564142094,
+33558562,2442689,646,2022977560,235814920,413340161,285584914,1208094124,
+3759145024,0,503349280,8421376,558083,1074021950,1048852,25177120,1073742080,
+7340644,1445204000,537402497,671353094,813760768,1348551440,608178505,33566721,
+2629634,2158069832,40,536897162,68034755,23611552,1312771,50399378,1149763776,
+1589248,2147551234,1086361688,2349078528,4194320,134222945,805339138,14683144,
+327288964,349045825,402920322,536887296,411050088,1176507800,32905,789916697,0,
+297795840,285213185,0,2281981216,3221490760,3506962696,1879056398,17351880,
+352325672,146833428,524356,278028416,1074430977,0,1178747906,3791652864,
+77599249,14680069,583274656,131104,67109120,50741513,272632512,2097216,40370305,
+287375362,5120,1605640,2164738,168300614,406847618,1535148612,2721055168,49200,
+17301520,25165824,853696512,1111490568,889193476,525312,75497477,536871040,
+131073,269484032,4194306,264456,36864,92275328,4202635,172053,152059904,16385,
+549453826,812704288,16781393,346079488,805371930,406917132,0,2052,4160,8651266,
+0,0,562173058,1141735936,2189426944,1688471651,2818080,1094713426,170131489,0,
+1077936131,33702918,1351090176,273154341,22233116,2189704065,545325152,2048,
+1410881936,279714138,553718532,1371580416,1076396032,1073743872,1711276224,
+134217984,9437184,100679813,243798081,0,1073744907,1342259200,67635712,
+193129796,2189822240};
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }  /* extern "C" */
 #endif
@@ -0,0 +1,161 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Minimal portable "parallel for" used to run independent encoder tasks. */
+
+#include "./worker.h"
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+
+#if defined(BROTLI_ENCODER_NO_THREADS)
+/* Threads are explicitly disabled. */
+#elif defined(_WIN32)
+#define BROTLI_WORKER_WIN32
+#include <windows.h>
+#elif defined(__unix__) || defined(__unix) || \
+    (defined(__APPLE__) && defined(__MACH__))
+#define BROTLI_WORKER_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+typedef struct WorkerQueue {
+  BrotliWorkerFunc func;
+  void* context;
+  size_t num_tasks;
+  size_t next_task;
+#if defined(BROTLI_WORKER_PTHREAD)
+  pthread_mutex_t lock;
+#elif defined(BROTLI_WORKER_WIN32)
+  CRITICAL_SECTION lock;
+#endif
+} WorkerQueue;
+
+/* Returns the index of the next task to run, or |num_tasks| if the queue
+   is depleted. */
+static size_t NextTask(WorkerQueue* queue) {
+  size_t result;
+#if defined(BROTLI_WORKER_PTHREAD)
+  pthread_mutex_lock(&queue->lock);
+#elif defined(BROTLI_WORKER_WIN32)
+  EnterCriticalSection(&queue->lock);
+#endif
+  result = queue->next_task;
+  if (result < queue->num_tasks) queue->next_task++;
+#if defined(BROTLI_WORKER_PTHREAD)
+  pthread_mutex_unlock(&queue->lock);
+#elif defined(BROTLI_WORKER_WIN32)
+  LeaveCriticalSection(&queue->lock);
+#endif
+  return result;
+}
+
+static void DrainQueue(WorkerQueue* queue) {
+  size_t i;
+  while ((i = NextTask(queue)) < queue->num_tasks) {
+    queue->func(queue->context, i);
+  }
+}
+
+#if defined(BROTLI_WORKER_PTHREAD)
+
+static void* WorkerMain(void* arg) {
+  DrainQueue((WorkerQueue*)arg);
+  return NULL;
+}
+
+void BrotliRunWorkers(BrotliWorkerFunc func, void* context,
+                      size_t num_tasks, size_t num_threads) {
+  WorkerQueue queue;
+  pthread_t threads[BROTLI_MAX_THREADS - 1];
+  size_t num_started = 0;
+  size_t i;
+  queue.func = func;
+  queue.context = context;
+  queue.num_tasks = num_tasks;
+  queue.next_task = 0;
+  if (num_threads > num_tasks) num_threads = num_tasks;
+  if (num_threads > BROTLI_MAX_THREADS) {
+    num_threads = BROTLI_MAX_THREADS;
+  }
+  if (num_threads <= 1 || pthread_mutex_init(&queue.lock, NULL) != 0) {
+    for (i = 0; i < num_tasks; ++i) func(context, i);
+    return;
+  }
+  /* Failure to start some thread is not fatal: remaining tasks are picked up
+     by threads that are already running, or by the calling one. */
+  for (i = 0; i + 1 < num_threads; ++i) {
+    if (pthread_create(&threads[num_started], NULL, WorkerMain, &queue) != 0) {
+      break;
+    }
+    num_started++;
+  }
+  DrainQueue(&queue);
+  for (i = 0; i < num_started; ++i) pthread_join(threads[i], NULL);
+  pthread_mutex_destroy(&queue.lock);
+}
+
+#elif defined(BROTLI_WORKER_WIN32)
+
+static DWORD WINAPI WorkerMain(LPVOID arg) {
+  DrainQueue((WorkerQueue*)arg);
+  return 0;
+}
+
+void BrotliRunWorkers(BrotliWorkerFunc func, void* context,
+                      size_t num_tasks, size_t num_threads) {
+  WorkerQueue queue;
+  HANDLE threads[BROTLI_MAX_THREADS - 1];
+  size_t num_started = 0;
+  size_t i;
+  queue.func = func;
+  queue.context = context;
+  queue.num_tasks = num_tasks;
+  queue.next_task = 0;
+  if (num_threads > num_tasks) num_threads = num_tasks;
+  if (num_threads > BROTLI_MAX_THREADS) {
+    num_threads = BROTLI_MAX_THREADS;
+  }
+  if (num_threads <= 1) {
+    for (i = 0; i < num_tasks; ++i) func(context, i);
+    return;
+  }
+  InitializeCriticalSection(&queue.lock);
+  for (i = 0; i + 1 < num_threads; ++i) {
+    threads[num_started] = CreateThread(NULL, 0, WorkerMain, &queue, 0, NULL);
+    if (threads[num_started] == NULL) break;
+    num_started++;
+  }
+  DrainQueue(&queue);
+  for (i = 0; i < num_started; ++i) {
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+  DeleteCriticalSection(&queue.lock);
+}
+
+#else  /* BROTLI_WORKER_PTHREAD || BROTLI_WORKER_WIN32 */
+
+void BrotliRunWorkers(BrotliWorkerFunc func, void* context,
+                      size_t num_tasks, size_t num_threads) {
+  WorkerQueue queue;
+  BROTLI_UNUSED(num_threads);
+  queue.func = func;
+  queue.context = context;
+  queue.num_tasks = num_tasks;
+  queue.next_task = 0;
+  DrainQueue(&queue);
+}
+
+#endif  /* BROTLI_WORKER_PTHREAD || BROTLI_WORKER_WIN32 */
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
@@ -0,0 +1,37 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Minimal portable "parallel for" used to run independent encoder tasks. */
+
+#ifndef BROTLI_ENC_WORKER_H_
+#define BROTLI_ENC_WORKER_H_
+
+#include "../common/platform.h"
+#include <brotli/encode.h>
+#include <brotli/types.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+typedef void (*BrotliWorkerFunc)(void* context, size_t task_index);
+
+/* Invokes |func| for every task index in [0, num_tasks) using at most
+   |num_threads| threads, but no more than BROTLI_MAX_THREADS; calling thread
+   is one of them. Tasks are handed out in increasing index order, but might
+   complete in any order.
+
+   If threads are not supported by platform, or could not be started, tasks
+   are executed on the calling thread. In any case all the tasks are completed
+   when function returns. */
+BROTLI_INTERNAL void BrotliRunWorkers(BrotliWorkerFunc func, void* context,
+                                      size_t num_tasks, size_t num_threads);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
+
+#endif  /* BROTLI_ENC_WORKER_H_ */
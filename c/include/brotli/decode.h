@@ -85,7 +85,9 @@ typedef enum {
   BROTLI_ERROR_CODE(_ERROR_FORMAT_, PADDING_2, -15) SEPARATOR              \
   BROTLI_ERROR_CODE(_ERROR_FORMAT_, DISTANCE, -16) SEPARATOR               \
                                                                            \
-  /* -17..-18 codes are reserved */                                        \
+  /* -17 code is reserved */                                               \
+                                                                           \
+  BROTLI_ERROR_CODE(_ERROR_, COMPOUND_DICTIONARY, -18) SEPARATOR           \
                                                                            \
   BROTLI_ERROR_CODE(_ERROR_, DICTIONARY_NOT_SET, -19) SEPARATOR            \
   BROTLI_ERROR_CODE(_ERROR_, INVALID_ARGUMENTS, -20) SEPARATOR             \
@@ -139,7 +141,20 @@ typedef enum BrotliDecoderParameter {
   /**
    * Flag that determines if "Large Window Brotli" is used.
    */
-  BROTLI_DECODER_PARAM_LARGE_WINDOW = 1
+  BROTLI_DECODER_PARAM_LARGE_WINDOW = 1,
+  /**
+   * Flag that enables mirrored ring buffer.
+   *
+   * Ring buffer is mapped twice, back to back, so that backward references
+   * and output never have to be split at the end of ring buffer. It takes
+   * twice the window size of memory, which is not allocated with custom
+   * memory manager functions, and it is not reduced for small content.
+   *
+   * This is a hint: if the platform does not support such mappings (only
+   * Linux does), or window is too small or too large for that (less than a
+   * memory page or more than 512MiB), ordinary ring buffer is used instead.
+   */
+  BROTLI_DECODER_PARAM_MIRRORED_RING_BUFFER = 2
 } BrotliDecoderParameter;
 
 /**
@@ -158,13 +173,15 @@ BROTLI_DEC_API BROTLI_BOOL BrotliDecoderSetParameter(
  * Creates an instance of ::BrotliDecoderState and initializes it.
  *
  * The instance can be used once for decoding and should then be destroyed with
- * ::BrotliDecoderDestroyInstance, it cannot be reused for a new decoding
- * session.
+ * ::BrotliDecoderDestroyInstance, or returned to the initial state with
+ * ::BrotliDecoderReset to start a new decoding session.
  *
  * @p alloc_func and @p free_func @b MUST be both zero or both non-zero. In the
  * case they are both zero, default memory allocators are used. @p opaque is
  * passed to @p alloc_func and @p free_func when they are called. @p free_func
  * has to return without doing anything when asked to free a NULL pointer.
+ * Mirrored ring buffer (see ::BROTLI_DECODER_PARAM_MIRRORED_RING_BUFFER) is
+ * mapped directly by the operating system, bypassing these functions.
  *
  * @param alloc_func custom memory allocation function
  * @param free_func custom memory free function
@@ -182,12 +199,112 @@ BROTLI_DEC_API BrotliDecoderState* BrotliDecoderCreateInstance(
  */
 BROTLI_DEC_API void BrotliDecoderDestroyInstance(BrotliDecoderState* state);
 
+/**
+ * Returns ::BrotliDecoderState instance to the initial state.
+ *
+ * After reset instance is equivalent to a freshly created one: parameters
+ * are set to default values, and a new stream could be decoded. Already
+ * allocated ring buffer and block type trees are kept and reused.
+ *
+ * @param state decoder instance to be reset
+ */
+BROTLI_DEC_API void BrotliDecoderReset(BrotliDecoderState* state);
+
+/**
+ * Attaches a raw dictionary to the decoder instance.
+ *
+ * Several dictionaries could be attached; they are logically concatenated in
+ * the order of attachment, and the result is placed right before the
+ * beginning of the stream. Backward references that point past the window
+ * are resolved into attached dictionaries first, and into the built-in static
+ * dictionary only after that. Encoder should use the same dictionaries in the
+ * same order.
+ *
+ * Dictionary data is not copied: @p data @b MUST remain valid and unchanged
+ * until the instance is destroyed or reset. Decoder never writes to it, so
+ * the same memory could be shared by any number of decoder instances.
+ *
+ * Dictionaries could only be attached before decoding is started. Attached
+ * dictionaries are forgotten by ::BrotliDecoderReset.
+ *
+ * @param state decoder instance
+ * @param data_size length of dictionary data, in bytes
+ * @param data dictionary data
+ * @returns ::BROTLI_FALSE if decoding is already started, if there are
+ *          already 15 dictionaries attached, or if dictionary is empty or too
+ *          large
+ * @returns ::BROTLI_TRUE if dictionary is attached
+ */
+BROTLI_DEC_API BROTLI_BOOL BrotliDecoderAttachDictionary(
+    BrotliDecoderState* state, size_t data_size,
+    const uint8_t data[BROTLI_ARRAY_PARAM(data_size)]);
+
+/**
+ * Callback to receive the LZ77 commands of the decoded stream.
+ *
+ * Each command means that @p insert_length literals are followed by
+ * @p copy_length bytes copied from @p distance bytes back in the output. If
+ * @p distance is @c 0, then copied bytes come from a dictionary (built-in or
+ * attached) instead. Uncompressed metablocks and literals that end a
+ * metablock are reported as commands with zero @p copy_length.
+ *
+ * @param opaque custom data passed to ::BrotliDecoderSetCommandCallback
+ * @param insert_length number of literals
+ * @param copy_length number of copied bytes
+ * @param distance backward distance, or @c 0 for dictionary words
+ */
+typedef void (*brotli_decoder_command_func)(void* opaque, size_t insert_length,
+    size_t copy_length, size_t distance);
+
+/**
+ * Sets the callback that receives the LZ77 commands of the decoded stream.
+ *
+ * Commands are reported in the order they are decoded, before the produced
+ * data is output. This allows reusing the parse made by encoder, e.g. to
+ * re-encode the stream with a higher effort (see
+ * ::BrotliEncoderCompressCommands). The callback is forgotten by
+ * ::BrotliDecoderReset.
+ *
+ * @param state decoder instance
+ * @param callback callback function, or @c NULL to disable reporting
+ * @param opaque custom data passed to @p callback
+ * @returns ::BROTLI_FALSE if decoding is already started
+ * @returns ::BROTLI_TRUE if callback is set
+ */
+BROTLI_DEC_API BROTLI_BOOL BrotliDecoderSetCommandCallback(
+    BrotliDecoderState* state, brotli_decoder_command_func callback,
+    void* opaque);
+
+/**
+ * Estimates peak memory usage of decoder instance.
+ *
+ * Result is the upper bound of the memory allocated by
+ * ::BrotliDecoderDecompressStream for a stream with the given window size,
+ * including the instance itself. Ring buffer is the only part that depends
+ * on the stream; Huffman tables and context maps are accounted for their
+ * maximal sizes. Ring buffer reallocation is assumed to be enabled (see
+ * ::BROTLI_DECODER_PARAM_DISABLE_RING_BUFFER_REALLOCATION). Mirrored ring
+ * buffer (see ::BROTLI_DECODER_PARAM_MIRRORED_RING_BUFFER) is not included:
+ * it is mapped outside of memory manager functions, and takes twice the
+ * window size instead of the ordinary ring buffer.
+ *
+ * @param window_bits base 2 logarithm of the sliding window size
+ * @param output_size expected size of decompressed data, @c 0 if unknown
+ * @returns estimated peak memory usage, in bytes
+ */
+BROTLI_DEC_API size_t BrotliDecoderEstimatePeakMemoryUsage(int window_bits,
+    size_t output_size);
+
 /**
  * Performs one-shot memory-to-memory decompression.
  *
  * Decompresses the data in @p encoded_buffer into @p decoded_buffer, and sets
  * @p *decoded_size to the decompressed length.
  *
+ * @p decoded_buffer itself serves as the sliding window, so no ring buffer is
+ * allocated and decoded data is not copied. If decompression fails, contents
+ * of @p decoded_buffer are unspecified.
+ *
  * @param encoded_size size of @p encoded_buffer
  * @param encoded_buffer compressed data buffer with at least @p encoded_size
  *        addressable bytes
@@ -41,6 +41,9 @@ extern "C" {
 /** Maximal value for ::BROTLI_PARAM_QUALITY parameter. */
 #define BROTLI_MAX_QUALITY 11
 
+/** Maximal value for ::BROTLI_PARAM_NUM_THREADS parameter. */
+#define BROTLI_MAX_THREADS 256
+
 /** Options for ::BROTLI_PARAM_MODE parameter. */
 typedef enum BrotliEncoderMode {
   /**
@@ -50,7 +53,13 @@ typedef enum BrotliEncoderMode {
    * properties of the input.
    */
   BROTLI_MODE_GENERIC = 0,
-  /** Compression mode for UTF-8 formatted text input. */
+  /**
+   * Compression mode for UTF-8 formatted text input.
+   *
+   * With qualities 0 and 1 this mode also lets compressor reference words
+   * of the built-in static dictionary, which helps short text at the cost of
+   * some compression speed.
+   */
   BROTLI_MODE_TEXT = 1,
   /** Compression mode used in WOFF 2.0. */
   BROTLI_MODE_FONT = 2
@@ -217,7 +226,64 @@ typedef enum BrotliEncoderParameter {
    * maximal window size have the same effect. Values greater than 2**30 are not
    * allowed.
    */
-  BROTLI_PARAM_STREAM_OFFSET = 9
+  BROTLI_PARAM_STREAM_OFFSET = 9,
+  /**
+   * Number of threads used for compression.
+   *
+   * The default value is @c 0, which means that input is compressed
+   * sequentially, as a single piece.
+   *
+   * Any other value turns on "segmented" mode: input is cut into independent
+   * segments that are compressed concurrently (by up to the given number of
+   * threads) and stitched into a single stream. Each segment is primed with
+   * the window-sized piece of data that precedes it, so compression ratio
+   * loss is small. Priming data is hashed again for every segment; with large
+   * window it is capped by the segment size (64MiB) to bound that cost.
+   * Output depends only on the other parameters and on the flush points, i.e.
+   * it is the same for every non-zero number of threads.
+   *
+   * For quality 10 and 11 threads that are not occupied by segments are used
+   * to search for the optimal parse of each metablock in parts. Metablocks
+   * are split into parts regardless of the number of spare threads, so output
+   * still does not depend on it.
+   *
+   * @note In segmented mode input is buffered until a whole batch of segments
+   *       is collected (unless operation is ::BROTLI_OPERATION_FLUSH or
+   *       ::BROTLI_OPERATION_FINISH); this requires substantially more memory.
+   *
+   * @warning If custom memory allocators are used and value is greater than
+   *          @c 1, then allocators @b MUST be thread-safe.
+   *
+   * Range is from @c 0 to ::BROTLI_MAX_THREADS.
+   */
+  BROTLI_PARAM_NUM_THREADS = 10,
+  /**
+   * Memory budget, in bytes.
+   *
+   * The default value is @c 0, which means "no limit".
+   *
+   * When set, encoder estimates its peak memory usage (see
+   * ::BrotliEncoderEstimatePeakMemoryUsage) before compression is started,
+   * and, if the estimate exceeds the budget, degrades parameters until it
+   * fits. Changes that do not hurt compression go first: number of threads is
+   * reduced, and window is shrunk to the ::BROTLI_PARAM_SIZE_HINT, if one is
+   * set. Then, for quality 10 and 11, the optimal parse is searched in 64KiB
+   * parts of each input block, which bounds the memory used by that search to
+   * about 4MiB (quality 10) or 11MiB (quality 11) regardless of
+   * ::BROTLI_PARAM_LGBLOCK, at the cost of a slightly worse compression ratio.
+   * After that window is reduced down to @c 18 bits, then quality is
+   * lowered, and finally window is reduced down to the minimum. If even the
+   * smallest configuration does not fit the budget, it is used anyway.
+   * Actual usage is kept within the budget as far as the estimate holds; it
+   * is validated against measured peaks, but is not a proven bound.
+   *
+   * Stream is still decodable by any decoder, but the output is not the same
+   * as without the limit, unless no adjustment was required.
+   *
+   * @note If the whole input is supplied with the first
+   *       ::BROTLI_OPERATION_FINISH call, its size is used as a size hint.
+   */
+  BROTLI_PARAM_MEMORY_LIMIT = 11
 } BrotliEncoderParameter;
 
 /**
@@ -269,6 +335,114 @@ BROTLI_ENC_API BrotliEncoderState* BrotliEncoderCreateInstance(
  */
 BROTLI_ENC_API void BrotliEncoderDestroyInstance(BrotliEncoderState* state);
 
+/**
+ * Returns ::BrotliEncoderState instance to the initial state.
+ *
+ * After reset instance is equivalent to a freshly created one: parameters
+ * are set to default values, and a new stream could be started. Unlike
+ * destroying and creating an instance, already allocated buffers (ring buffer,
+ * hash tables, command and output storage) are kept and reused, if new
+ * parameters allow that. This makes compression of many small inputs cheaper.
+ *
+ * Output produced after reset is exactly the same as one produced by a new
+ * instance with the same parameters.
+ *
+ * @param state encoder instance to be reset
+ */
+BROTLI_ENC_API void BrotliEncoderReset(BrotliEncoderState* state);
+
+/**
+ * Opaque structure that holds a custom dictionary prepared for the encoder.
+ *
+ * Prepared dictionary contains a copy of the dictionary data and an index
+ * for fast lookups. It is immutable, so one instance could be attached to
+ * any number of encoders, including ones running concurrently.
+ */
+typedef struct BrotliEncoderPreparedDictionaryStruct
+    BrotliEncoderPreparedDictionary;
+
+/**
+ * Prepares a raw (LZ77 prefix) custom dictionary for repeated use.
+ *
+ * @p alloc_func and @p free_func @b MUST be both zero or both non-zero. In the
+ * case they are both zero, default memory allocators are used. @p opaque is
+ * passed to @p alloc_func and @p free_func when they are called.
+ *
+ * @p data is copied, so it could be released right after the call.
+ *
+ * @param data_size size of dictionary data; it @b MUST not exceed 2^30
+ * @param data dictionary data
+ * @param alloc_func custom memory allocation function
+ * @param free_func custom memory free function
+ * @param opaque custom memory manager handle
+ * @returns @c 0 if dictionary is too large, or memory could not be allocated
+ * @returns pointer to ::BrotliEncoderPreparedDictionary otherwise
+ */
+BROTLI_ENC_API BrotliEncoderPreparedDictionary* BrotliEncoderPrepareDictionary(
+    size_t data_size, const uint8_t data[BROTLI_ARRAY_PARAM(data_size)],
+    brotli_alloc_func alloc_func, brotli_free_func free_func, void* opaque);
+
+/**
+ * Deinitializes and frees ::BrotliEncoderPreparedDictionary instance.
+ *
+ * @warning Instance @b MUST NOT be destroyed while it is attached to some
+ *          encoder instance.
+ *
+ * @param dictionary prepared dictionary to be deallocated
+ */
+BROTLI_ENC_API void BrotliEncoderDestroyPreparedDictionary(
+    BrotliEncoderPreparedDictionary* dictionary);
+
+/**
+ * Attaches a prepared dictionary to the encoder instance.
+ *
+ * Compressed stream refers the dictionary as if it was placed right before the
+ * beginning of the stream (up to ::BROTLI_PARAM_LGWIN limit distances are
+ * encoded as regular backward references; beyond that the dictionary is still
+ * addressable). Decoder @b MUST be supplied with the same dictionary data to
+ * decode the stream. If several dictionaries are attached, they are logically
+ * concatenated in the order of attachment.
+ *
+ * Dictionary @b MUST be attached before the first ::BrotliEncoderCompressStream
+ * call; it stays attached until the instance is destroyed or reset. Up to
+ * @c 15 dictionaries could be attached to one instance. Dictionaries are not
+ * used at quality levels @c 0 and @c 1.
+ *
+ * @param state encoder instance
+ * @param dictionary prepared dictionary; @b MUST outlive the encoder instance,
+ *        or the stream
+ * @returns ::BROTLI_FALSE if compression has already started, or there are
+ *          too many attached dictionaries
+ * @returns ::BROTLI_TRUE otherwise
+ */
+BROTLI_ENC_API BROTLI_BOOL BrotliEncoderAttachPreparedDictionary(
+    BrotliEncoderState* state,
+    const BrotliEncoderPreparedDictionary* dictionary);
+
+/**
+ * Estimates peak memory usage of encoder instance.
+ *
+ * Result is the memory allocated by ::BrotliEncoderCompressStream when
+ * compressing with the given parameters in a single thread, including the
+ * instance itself. Parameters are sanitized in the same way as they are by
+ * ::BrotliEncoderSetParameter; @c 0 @p lgblock means "choose automatically".
+ * Ring buffer, hasher tables, command and output buffers are accounted
+ * exactly, including the copies made when they grow, as is the optimal
+ * parsing scratch; block splitting and histogram clustering scratch uses
+ * coefficients fitted to the worst inputs found. Result is an estimate,
+ * validated against measured peaks; it is far from tight for small or
+ * unknown input size, as the worst case of the input is assumed. Prepared
+ * dictionaries (see ::BrotliEncoderPrepareDictionary) are not included.
+ *
+ * @param quality quality parameter value, e.g. ::BROTLI_DEFAULT_QUALITY
+ * @param lgwin lgwin parameter value, e.g. ::BROTLI_DEFAULT_WINDOW
+ * @param lgblock lgblock parameter value, e.g. @c 0
+ * @param size_hint expected input size, @c 0 if unknown
+ * @returns estimated peak memory usage, in bytes
+ */
+BROTLI_ENC_API size_t BrotliEncoderEstimatePeakMemoryUsage(int quality,
+    int lgwin, int lgblock, size_t size_hint);
+
 /**
  * Calculates the output size bound for the given @p input_size.
  *
@@ -315,6 +489,91 @@ BROTLI_ENC_API BROTLI_BOOL BrotliEncoderCompress(
     size_t* encoded_size,
     uint8_t encoded_buffer[BROTLI_ARRAY_PARAM(*encoded_size)]);
 
+/**
+ * Performs one-shot memory-to-memory compression using multiple threads.
+ *
+ * Same as ::BrotliEncoderCompress, but input is compressed in segments that
+ * are processed concurrently; see ::BROTLI_PARAM_NUM_THREADS. Output is the
+ * same for any non-zero @p num_threads; it is slightly larger than the output
+ * of ::BrotliEncoderCompress.
+ *
+ * @param quality quality parameter value, e.g. ::BROTLI_DEFAULT_QUALITY
+ * @param lgwin lgwin parameter value, e.g. ::BROTLI_DEFAULT_WINDOW
+ * @param mode mode parameter value, e.g. ::BROTLI_DEFAULT_MODE
+ * @param num_threads maximal number of threads to use, from @c 1 to
+ *        ::BROTLI_MAX_THREADS
+ * @param input_size size of @p input_buffer
+ * @param input_buffer input data buffer with at least @p input_size
+ *        addressable bytes
+ * @param[in, out] encoded_size @b in: size of @p encoded_buffer; \n
+ *                 @b out: length of compressed data written to
+ *                 @p encoded_buffer, or @c 0 if compression fails
+ * @param encoded_buffer compressed data destination buffer
+ * @returns ::BROTLI_FALSE in case of compression error
+ * @returns ::BROTLI_FALSE if output buffer is too small
+ * @returns ::BROTLI_TRUE otherwise
+ */
+BROTLI_ENC_API BROTLI_BOOL BrotliEncoderCompressParallel(
+    int quality, int lgwin, BrotliEncoderMode mode, uint32_t num_threads,
+    size_t input_size,
+    const uint8_t input_buffer[BROTLI_ARRAY_PARAM(input_size)],
+    size_t* encoded_size,
+    uint8_t encoded_buffer[BROTLI_ARRAY_PARAM(*encoded_size)]);
+
+/**
+ * One step of an externally produced LZ77 parse of the input.
+ *
+ * @p insert_length bytes of input are emitted as literals, then
+ * @p copy_length bytes are copied from @p distance bytes back.
+ */
+typedef struct BrotliEncoderCommand {
+  /** Number of literals preceding the backward reference. */
+  uint32_t insert_length;
+  /** Length of the backward reference; @c 0 means "literals only". */
+  uint32_t copy_length;
+  /** Backward distance, from @c 1; ignored if @p copy_length is @c 0. */
+  uint32_t distance;
+} BrotliEncoderCommand;
+
+/**
+ * Performs one-shot compression of the input using the given parse.
+ *
+ * Backward reference search is skipped; only metablock building, block
+ * splitting, histogram clustering and entropy coding are done, with the effort
+ * of the given @p quality. Qualities below @c 2 are treated as @c 2.
+ *
+ * Commands must cover the input exactly: the sum of all insert and copy lengths
+ * is @p input_size. Each non-empty copy must be at least @c 2 bytes long and
+ * must not exceed the maximal metablock size for the given @p quality and
+ * @p lgwin, which is at least 32KiB; its distance must not exceed the number
+ * of preceding input bytes nor the window size. Static dictionary references
+ * are not supported.
+ *
+ * @param quality quality parameter value, e.g. ::BROTLI_DEFAULT_QUALITY
+ * @param lgwin lgwin parameter value, e.g. ::BROTLI_DEFAULT_WINDOW
+ * @param mode mode parameter value, e.g. ::BROTLI_DEFAULT_MODE
+ * @param input_size size of @p input_buffer
+ * @param input_buffer input data buffer with at least @p input_size
+ *        addressable bytes
+ * @param num_commands number of elements in @p commands
+ * @param commands parse of the input
+ * @param[in, out] encoded_size @b in: size of @p encoded_buffer; \n
+ *                 @b out: length of compressed data written to
+ *                 @p encoded_buffer, or @c 0 if compression fails
+ * @param encoded_buffer compressed data destination buffer
+ * @returns ::BROTLI_FALSE if commands are not a valid parse of the input
+ * @returns ::BROTLI_FALSE in case of compression error
+ * @returns ::BROTLI_FALSE if output buffer is too small
+ * @returns ::BROTLI_TRUE otherwise
+ */
+BROTLI_ENC_API BROTLI_BOOL BrotliEncoderCompressCommands(
+    int quality, int lgwin, BrotliEncoderMode mode, size_t input_size,
+    const uint8_t input_buffer[BROTLI_ARRAY_PARAM(input_size)],
+    size_t num_commands,
+    const BrotliEncoderCommand commands[BROTLI_ARRAY_PARAM(num_commands)],
+    size_t* encoded_size,
+    uint8_t encoded_buffer[BROTLI_ARRAY_PARAM(*encoded_size)]);
+
 /**
  * Compresses input stream to output stream.
  *
@@ -338,6 +597,11 @@ BROTLI_ENC_API BROTLI_BOOL BrotliEncoderCompress(
  *  -# actually compress data and (optionally) store it to internal buffer
  *  -# (optionally) copy compressed bytes from internal buffer to output stream
  *
+ * When @p available_out is large enough to hold the worst case encoding of
+ * the pending block (twice its size plus 503 bytes), compressed data is
+ * written directly to @p next_out and internal buffer is not involved. Bytes
+ * of output buffer past the reported output might be overwritten then.
+ *
  * Whenever all 3 tasks can't move forward anymore, or error occurs, this
  * method returns the control flow to caller.
  *
@@ -80,6 +80,7 @@ typedef enum {
   COMMAND_INVALID,
   COMMAND_TEST_INTEGRITY,
   COMMAND_NOOP,
+  COMMAND_RECOMPRESS,
   COMMAND_VERSION
 } Command;
 
@@ -91,6 +92,7 @@ typedef struct {
   /* Parameters */
   int quality;
   int lgwin;
+  int num_threads;
   int verbosity;
   BROTLI_BOOL force_overwrite;
   BROTLI_BOOL junk_source;
@@ -98,6 +100,7 @@ typedef struct {
   BROTLI_BOOL write_to_stdout;
   BROTLI_BOOL test_integrity;
   BROTLI_BOOL decompress;
+  BROTLI_BOOL recompress;
   BROTLI_BOOL large_window;
   const char* output_path;
   const char* suffix;
@@ -190,6 +193,7 @@ static Command ParseParams(Context* params) {
   BROTLI_BOOL keep_set = BROTLI_FALSE;
   BROTLI_BOOL lgwin_set = BROTLI_FALSE;
   BROTLI_BOOL suffix_set = BROTLI_FALSE;
+  BROTLI_BOOL threads_set = BROTLI_FALSE;
   BROTLI_BOOL after_dash_dash = BROTLI_FALSE;
   Command command = ParseAlias(argv[0]);
 
@@ -406,6 +410,13 @@ static Command ParseParams(Context* params) {
           return COMMAND_INVALID;
         }
         params->copy_stat = BROTLI_FALSE;
+      } else if (strcmp("recompress", arg) == 0) {
+        if (command_set) {
+          fprintf(stderr, "command already set when parsing --recompress\n");
+          return COMMAND_INVALID;
+        }
+        command_set = BROTLI_TRUE;
+        command = COMMAND_RECOMPRESS;
       } else if (strcmp("rm", arg) == 0) {
         if (keep_set) {
           fprintf(stderr, "argument --rm / -j or --keep / -k already set\n");
@@ -506,6 +517,17 @@ static Command ParseParams(Context* params) {
           }
           suffix_set = BROTLI_TRUE;
           params->suffix = value;
+        } else if (strncmp("threads", arg, key_len) == 0) {
+          if (threads_set) {
+            fprintf(stderr, "threads parameter already set\n");
+            return COMMAND_INVALID;
+          }
+          threads_set = ParseInt(value, 0,
+                                 BROTLI_MAX_THREADS, &params->num_threads);
+          if (!threads_set) {
+            fprintf(stderr, "error parsing threads value [%s]\n", value);
+            return COMMAND_INVALID;
+          }
         } else {
           fprintf(stderr, "invalid parameter: [%s]\n", arg);
           return COMMAND_INVALID;
@@ -518,8 +540,16 @@ static Command ParseParams(Context* params) {
   params->longest_path_len = longest_path_len;
   params->decompress = (command == COMMAND_DECOMPRESS);
   params->test_integrity = (command == COMMAND_TEST_INTEGRITY);
+  params->recompress = (command == COMMAND_RECOMPRESS);
 
   if (input_count > 1 && output_set) return COMMAND_INVALID;
+  if (params->recompress) {
+    /* Input and output have the same suffix; output should be explicit. */
+    if (!params->output_path && !params->write_to_stdout) {
+      fprintf(stderr, "output is required for --recompress\n");
+      return COMMAND_INVALID;
+    }
+  }
   if (params->test_integrity) {
     if (params->output_path) return COMMAND_INVALID;
     if (params->write_to_stdout) return COMMAND_INVALID;
@@ -560,6 +590,10 @@ static void PrintHelp(const char* name, BROTLI_BOOL error) {
 "  -q NUM, --quality=NUM       compression level (%d-%d)\n",
           BROTLI_MIN_QUALITY, BROTLI_MAX_QUALITY);
   fprintf(media,
+"  --recompress                re-encode compressed file(s) with the given\n"
+"                              level, reusing their backward references;\n"
+"                              window is the smallest one that fits them\n");
+  fprintf(media,
 "  -t, --test                  test compressed file integrity\n"
 "  -v, --verbose               verbose mode\n");
   fprintf(media,
@@ -578,6 +612,10 @@ static void PrintHelp(const char* name, BROTLI_BOOL error) {
 "  -S SUF, --suffix=SUF        output file suffix (default:'%s')\n",
           DEFAULT_SUFFIX);
   fprintf(media,
+"  --threads=NUM               compress using up to NUM threads (0-%d)\n"
+"                              0 disables segmented compression\n",
+          BROTLI_MAX_THREADS);
+  fprintf(media,
 "  -V, --version               display version and exit\n"
 "  -Z, --best                  use best compression level (11) (default)\n"
 "Simple options could be coalesced, i.e. '-9kf' is equivalent to '-9 -k -f'.\n"
@@ -1015,6 +1053,10 @@ static BROTLI_BOOL CompressFiles(Context* context) {
       }
       BrotliEncoderSetParameter(s, BROTLI_PARAM_LGWIN, lgwin);
     }
+    if (context->num_threads > 0) {
+      BrotliEncoderSetParameter(s,
+          BROTLI_PARAM_NUM_THREADS, (uint32_t)context->num_threads);
+    }
     if (context->input_file_length > 0) {
       uint32_t size_hint = context->input_file_length < (1 << 30) ?
           (uint32_t)context->input_file_length : (1u << 30);
@@ -1034,6 +1076,198 @@ static BROTLI_BOOL CompressFiles(Context* context) {
   return BROTLI_TRUE;
 }
 
+/* Parse of the decoded stream, collected by command callback. Recompression
+   drives both decoder and encoder, so it lives here: encoder and decoder
+   libraries do not depend on each other. */
+typedef struct {
+  BrotliEncoderCommand* commands;
+  size_t num_commands;
+  size_t capacity;
+  /* Literals not yet attached to a command. */
+  size_t insert_length;
+  size_t max_distance;
+  BROTLI_BOOL is_oom;
+} RecompressParse;
+
+/* Copies are split so that each piece fits any metablock; see
+   BrotliEncoderCompressCommands. */
+static const size_t kMaxRecompressCopyLength = 1 << 15;
+
+static void AppendRecompressCommand(RecompressParse* parse,
+    size_t copy_length, size_t distance) {
+  if (parse->num_commands == parse->capacity) {
+    size_t capacity = parse->capacity ? parse->capacity * 2 : 4096;
+    BrotliEncoderCommand* commands = (BrotliEncoderCommand*)realloc(
+        parse->commands, capacity * sizeof(BrotliEncoderCommand));
+    if (!commands) {
+      parse->is_oom = BROTLI_TRUE;
+      return;
+    }
+    parse->commands = commands;
+    parse->capacity = capacity;
+  }
+  parse->commands[parse->num_commands].insert_length =
+      (uint32_t)parse->insert_length;
+  parse->commands[parse->num_commands].copy_length = (uint32_t)copy_length;
+  parse->commands[parse->num_commands].distance = (uint32_t)distance;
+  parse->num_commands++;
+  parse->insert_length = 0;
+}
+
+static void OnRecompressCommand(void* opaque, size_t insert_length,
+    size_t copy_length, size_t distance) {
+  RecompressParse* parse = (RecompressParse*)opaque;
+  parse->insert_length += insert_length;
+  if (distance == 0) {
+    /* Dictionary words become literals. */
+    parse->insert_length += copy_length;
+  } else {
+    if (parse->max_distance < distance) parse->max_distance = distance;
+    while (copy_length > kMaxRecompressCopyLength) {
+      size_t piece = kMaxRecompressCopyLength;
+      if (copy_length - piece < 2) piece -= 2;
+      AppendRecompressCommand(parse, piece, distance);
+      copy_length -= piece;
+    }
+    AppendRecompressCommand(parse, copy_length, distance);
+  }
+  if (parse->insert_length > (1u << 30)) {
+    /* Keep insert length within uint32_t range. */
+    AppendRecompressCommand(parse, 0, 0);
+  }
+}
+
+static BROTLI_BOOL RecompressFile(Context* context, BrotliDecoderState* s) {
+  BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
+  RecompressParse parse;
+  uint8_t* decoded = NULL;
+  size_t decoded_capacity = 0;
+  size_t decoded_size = 0;
+  uint8_t* encoded = NULL;
+  size_t encoded_size;
+  int lgwin = BROTLI_MIN_WINDOW_BITS;
+  BROTLI_BOOL is_ok = BROTLI_FALSE;
+
+  memset(&parse, 0, sizeof(parse));
+  BrotliDecoderSetCommandCallback(s, OnRecompressCommand, &parse);
+  InitializeBuffers(context);
+  /* Decoded data is accumulated in memory, as encoder needs all of it. */
+  for (;;) {
+    size_t out_size = (size_t)(context->next_out - context->output);
+    if (parse.is_oom) {
+      fprintf(stderr, "out of memory\n");
+      goto done;
+    }
+    if (decoded_size + out_size > decoded_capacity) {
+      size_t capacity = decoded_capacity * 2 + out_size;
+      uint8_t* buffer = (uint8_t*)realloc(decoded, capacity);
+      if (!buffer) {
+        fprintf(stderr, "out of memory\n");
+        goto done;
+      }
+      decoded = buffer;
+      decoded_capacity = capacity;
+    }
+    if (out_size != 0) {
+      memcpy(decoded + decoded_size, context->output, out_size);
+    }
+    decoded_size += out_size;
+    context->available_out = kFileBufferSize;
+    context->next_out = context->output;
+
+    if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+      if (!HasMoreInput(context)) {
+        fprintf(stderr, "corrupt input [%s]\n",
+                PrintablePath(context->current_input_path));
+        goto done;
+      }
+      if (!ProvideInput(context)) goto done;
+    } else if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+      if ((context->available_in != 0) || (fgetc(context->fin) != EOF)) {
+        fprintf(stderr, "corrupt input [%s]\n",
+                PrintablePath(context->current_input_path));
+        goto done;
+      }
+      break;
+    } else if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+      fprintf(stderr, "corrupt input [%s]\n",
+              PrintablePath(context->current_input_path));
+      goto done;
+    }
+
+    result = BrotliDecoderDecompressStream(s, &context->available_in,
+        &context->next_in, &context->available_out, &context->next_out, 0);
+  }
+  if (parse.insert_length != 0) AppendRecompressCommand(&parse, 0, 0);
+  if (parse.is_oom) {
+    fprintf(stderr, "out of memory\n");
+    goto done;
+  }
+
+  /* Smallest window that fits all the distances of the parse. */
+  while (BROTLI_MAX_BACKWARD_LIMIT(lgwin) < (uint64_t)parse.max_distance) {
+    lgwin++;
+  }
+  encoded_size = BrotliEncoderMaxCompressedSize(decoded_size);
+  if (encoded_size == 0) encoded_size = decoded_size;
+  encoded_size += 1024;
+  encoded = (uint8_t*)malloc(encoded_size);
+  if (!encoded) {
+    fprintf(stderr, "out of memory\n");
+    goto done;
+  }
+  if (!BrotliEncoderCompressCommands(context->quality, lgwin,
+      BROTLI_DEFAULT_MODE, decoded_size, decoded, parse.num_commands,
+      parse.commands, &encoded_size, encoded)) {
+    fprintf(stderr, "failed to compress data [%s]\n",
+            PrintablePath(context->current_input_path));
+    goto done;
+  }
+  context->total_out = encoded_size;
+  fwrite(encoded, 1, encoded_size, context->fout);
+  if (ferror(context->fout)) {
+    fprintf(stderr, "failed to write output [%s]: %s\n",
+            PrintablePath(context->current_output_path), strerror(errno));
+    goto done;
+  }
+  if (context->verbosity > 0) {
+    context->end_time = clock();
+    fprintf(stderr, "Recompressed ");
+    PrintFileProcessingProgress(context);
+    fprintf(stderr, "\n");
+  }
+  is_ok = BROTLI_TRUE;
+
+done:
+  free(encoded);
+  free(decoded);
+  free(parse.commands);
+  return is_ok;
+}
+
+static BROTLI_BOOL RecompressFiles(Context* context) {
+  while (NextFile(context)) {
+    BROTLI_BOOL is_ok = BROTLI_TRUE;
+    BrotliDecoderState* s = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    if (!s) {
+      fprintf(stderr, "out of memory\n");
+      return BROTLI_FALSE;
+    }
+    BrotliDecoderSetParameter(s, BROTLI_DECODER_PARAM_LARGE_WINDOW, 1u);
+    is_ok = OpenFiles(context);
+    if (is_ok && !context->current_output_path &&
+        !context->force_overwrite && isatty(STDOUT_FILENO)) {
+      fprintf(stderr, "Use -h help. Use -f to force output to a terminal.\n");
+      is_ok = BROTLI_FALSE;
+    }
+    if (is_ok) is_ok = RecompressFile(context, s);
+    BrotliDecoderDestroyInstance(s);
+    if (!CloseFiles(context, is_ok)) is_ok = BROTLI_FALSE;
+    if (!is_ok) return BROTLI_FALSE;
+  }
+  return BROTLI_TRUE;
+}
+
 int main(int argc, char** argv) {
   Command command;
   Context context;
@@ -1042,6 +1276,7 @@ int main(int argc, char** argv) {
 
   context.quality = 11;
   context.lgwin = -1;
+  context.num_threads = 0;
   context.verbosity = 0;
   context.force_overwrite = BROTLI_FALSE;
   context.junk_source = BROTLI_FALSE;
@@ -1049,6 +1284,7 @@ int main(int argc, char** argv) {
   context.test_integrity = BROTLI_FALSE;
   context.write_to_stdout = BROTLI_FALSE;
   context.decompress = BROTLI_FALSE;
+  context.recompress = BROTLI_FALSE;
   context.large_window = BROTLI_FALSE;
   context.output_path = NULL;
   context.suffix = DEFAULT_SUFFIX;
@@ -1071,7 +1307,7 @@ int main(int argc, char** argv) {
   command = ParseParams(&context);
 
   if (command == COMMAND_COMPRESS || command == COMMAND_DECOMPRESS ||
-      command == COMMAND_TEST_INTEGRITY) {
+      command == COMMAND_TEST_INTEGRITY || command == COMMAND_RECOMPRESS) {
     if (is_ok) {
       size_t modified_path_len =
           context.longest_path_len + strlen(context.suffix) + 1;
@@ -1106,6 +1342,10 @@ int main(int argc, char** argv) {
       is_ok = DecompressFiles(&context);
       break;
 
+    case COMMAND_RECOMPRESS:
+      is_ok = RecompressFiles(&context);
+      break;
+
     case COMMAND_HELP:
     case COMMAND_INVALID:
     default:
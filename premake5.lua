@@ -28,7 +28,7 @@ configuration { "xcode4" }
   location "buildfiles/xcode4"
 
 configuration "linux"
-  links "m"
+  links { "m", "pthread" }
 
 configuration { "macosx" }
   defines { "OS_MACOSX" }
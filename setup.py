@@ -189,6 +189,7 @@ EXT_MODULES = [
             'c/dec/bit_reader.c',
             'c/dec/decode.c',
             'c/dec/huffman.c',
+            'c/dec/mirror.c',
             'c/dec/state.c',
             'c/enc/backward_references.c',
             'c/enc/backward_references_hq.c',
@@ -197,6 +198,7 @@ EXT_MODULES = [
             'c/enc/brotli_bit_stream.c',
             'c/enc/cluster.c',
             'c/enc/command.c',
+            'c/enc/compound_dictionary.c',
             'c/enc/compress_fragment.c',
             'c/enc/compress_fragment_two_pass.c',
             'c/enc/dictionary_hash.c',
@@ -204,12 +206,14 @@ EXT_MODULES = [
             'c/enc/encoder_dict.c',
             'c/enc/entropy_encode.c',
             'c/enc/fast_log.c',
+            'c/enc/find_match_length.c',
             'c/enc/histogram.c',
             'c/enc/literal_cost.c',
             'c/enc/memory.c',
             'c/enc/metablock.c',
             'c/enc/static_dict.c',
             'c/enc/utf8_util.c',
+            'c/enc/worker.c',
         ],
         depends=[
             'c/common/constants.h',
@@ -220,6 +224,7 @@ EXT_MODULES = [
             'c/common/version.h',
             'c/dec/bit_reader.h',
             'c/dec/huffman.h',
+            'c/dec/mirror.h',
             'c/dec/prefix.h',
             'c/dec/state.h',
             'c/enc/backward_references.h',
@@ -234,6 +239,7 @@ EXT_MODULES = [
             'c/enc/cluster.h',
             'c/enc/cluster_inc.h',
             'c/enc/command.h',
+            'c/enc/compound_dictionary.h',
             'c/enc/compress_fragment.h',
             'c/enc/compress_fragment_two_pass.h',
             'c/enc/dictionary_hash.h',
@@ -248,6 +254,7 @@ EXT_MODULES = [
             'c/enc/hash_longest_match64_inc.h',
             'c/enc/hash_longest_match_inc.h',
             'c/enc/hash_longest_match_quickly_inc.h',
+            'c/enc/hash_longest_match_tagged_inc.h',
             'c/enc/hash_rolling_inc.h',
             'c/enc/hash_to_binary_tree_inc.h',
             'c/enc/histogram.h',
@@ -263,6 +270,7 @@ EXT_MODULES = [
             'c/enc/static_dict.h',
             'c/enc/static_dict_lut.h',
             'c/enc/utf8_util.h',
+            'c/enc/worker.h',
             'c/enc/write_bits.h',
         ],
         include_dirs=[
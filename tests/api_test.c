@@ -0,0 +1,1119 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Tests for encoder and decoder API that are not reachable from CLI.
+
+   Usage: api_test <case> <testdata directory> */
+
+/* Mute strerror/strcpy warnings. */
+#if !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+
+#define CHECK(X) if (!(X)) {                                         \
+  fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+  exit(1);                                                              \
+}
+
+/* Chunk size used for streaming; small enough to make every stream take
+   several calls. */
+#define CHUNK_SIZE 4096
+
+static const char* testdata_dir;
+
+static uint8_t* ReadTestFile(const char* name, size_t* size) {
+  char path[1024];
+  FILE* f;
+  uint8_t* data;
+  long length;
+  int path_length = snprintf(path, sizeof(path), "%s/%s", testdata_dir, name);
+  CHECK(path_length >= 0 && (size_t)path_length < sizeof(path));
+  f = fopen(path, "rb");
+  CHECK(f != NULL);
+  CHECK(fseek(f, 0, SEEK_END) == 0);
+  length = ftell(f);
+  CHECK(length >= 0);
+  CHECK(fseek(f, 0, SEEK_SET) == 0);
+  data = (uint8_t*)malloc((size_t)length + 1);
+  CHECK(data != NULL);
+  CHECK(fread(data, 1, (size_t)length, f) == (size_t)length);
+  fclose(f);
+  *size = (size_t)length;
+  return data;
+}
+
+/* Compresses |input| with already configured |s|, feeding input and draining
+   output in CHUNK_SIZE pieces. */
+static uint8_t* StreamCompress(BrotliEncoderState* s, const uint8_t* input,
+    size_t input_size, size_t* output_size) {
+  size_t capacity = BrotliEncoderMaxCompressedSize(input_size) + CHUNK_SIZE;
+  uint8_t* output = (uint8_t*)malloc(capacity);
+  size_t pos = 0;
+  size_t total_out = 0;
+  CHECK(output != NULL);
+  for (;;) {
+    size_t chunk = input_size - pos < CHUNK_SIZE ? input_size - pos
+                                                 : CHUNK_SIZE;
+    const uint8_t* next_in = input + pos;
+    size_t available_in = chunk;
+    uint8_t* next_out = output + total_out;
+    size_t available_out = capacity - total_out < CHUNK_SIZE ?
+        capacity - total_out : CHUNK_SIZE;
+    BrotliEncoderOperation op = (pos + chunk == input_size) ?
+        BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS;
+    CHECK(BrotliEncoderCompressStream(s, op, &available_in, &next_in,
+        &available_out, &next_out, &total_out));
+    pos += chunk - available_in;
+    if (BrotliEncoderIsFinished(s)) break;
+    CHECK(total_out < capacity);
+  }
+  CHECK(pos == input_size);
+  *output_size = total_out;
+  return output;
+}
+
+/* Decompresses |input| with |s|; |expected_size| bytes of output are
+   expected. */
+static uint8_t* StreamDecompress(BrotliDecoderState* s, const uint8_t* input,
+    size_t input_size, size_t expected_size) {
+  uint8_t* output = (uint8_t*)malloc(expected_size + 1);
+  const uint8_t* next_in = input;
+  size_t available_in = 0;
+  size_t total_out = 0;
+  BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
+  CHECK(output != NULL);
+  while (result != BROTLI_DECODER_RESULT_SUCCESS) {
+    uint8_t* next_out = output + total_out;
+    size_t available_out = expected_size + 1 - total_out < CHUNK_SIZE ?
+        expected_size + 1 - total_out : CHUNK_SIZE;
+    if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+      size_t pos = (size_t)(next_in - input);
+      CHECK(pos < input_size);
+      available_in = input_size - pos < CHUNK_SIZE ? input_size - pos
+                                                   : CHUNK_SIZE;
+    }
+    result = BrotliDecoderDecompressStream(s, &available_in, &next_in,
+        &available_out, &next_out, &total_out);
+    CHECK(result != BROTLI_DECODER_RESULT_ERROR);
+  }
+  CHECK(next_in == input + input_size);
+  CHECK(total_out == expected_size);
+  return output;
+}
+
+static void Configure(BrotliEncoderState* s, int quality, int lgwin) {
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_QUALITY, (uint32_t)quality));
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_LGWIN, (uint32_t)lgwin));
+}
+
+/* Compresses |data| with a fresh instance. */
+static uint8_t* FreshCompress(int quality, int lgwin, const uint8_t* data,
+    size_t size, size_t* compressed_size) {
+  BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+  uint8_t* compressed;
+  CHECK(s != NULL);
+  Configure(s, quality, lgwin);
+  compressed = StreamCompress(s, data, size, compressed_size);
+  BrotliEncoderDestroyInstance(s);
+  return compressed;
+}
+
+static void CheckRoundtrip(const uint8_t* compressed, size_t compressed_size,
+    const uint8_t* data, size_t size) {
+  BrotliDecoderState* s = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+  uint8_t* decompressed;
+  CHECK(s != NULL);
+  decompressed = StreamDecompress(s, compressed, compressed_size, size);
+  CHECK(memcmp(decompressed, data, size) == 0);
+  free(decompressed);
+  BrotliDecoderDestroyInstance(s);
+}
+
+/* Output of reused instance must not depend on what it did before reset:
+   finished streams, abandoned streams, and different parameters. */
+static void TestEncoderReset(void) {
+  static const int kQualities[] = {0, 1, 2, 5, 9, 10, 11};
+  static const int kWindows[] = {10, 16, 22};
+  size_t sizes[2];
+  uint8_t* inputs[2];
+  BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+  size_t i;
+  CHECK(s != NULL);
+  inputs[0] = ReadTestFile("alice29.txt", &sizes[0]);
+  inputs[1] = ReadTestFile("mapsdatazrh", &sizes[1]);
+  for (i = 0; i < 2 * sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    int quality = kQualities[i % (sizeof(kQualities) / sizeof(kQualities[0]))];
+    int lgwin = kWindows[i % (sizeof(kWindows) / sizeof(kWindows[0]))];
+    const uint8_t* data = inputs[i & 1];
+    size_t size = sizes[i & 1];
+    size_t expected_size;
+    size_t actual_size;
+    uint8_t* expected = FreshCompress(quality, lgwin, data, size,
+        &expected_size);
+    uint8_t* actual;
+
+    /* Leave the previous stream unfinished every other time. */
+    if (i & 2) {
+      const uint8_t* next_in = data;
+      size_t available_in = size / 2;
+      size_t available_out = 0;
+      uint8_t* next_out = NULL;
+      BrotliEncoderReset(s);
+      Configure(s, 11 - quality, 24 - lgwin / 2);
+      CHECK(BrotliEncoderCompressStream(s, BROTLI_OPERATION_FLUSH,
+          &available_in, &next_in, &available_out, &next_out, NULL));
+    }
+    BrotliEncoderReset(s);
+    Configure(s, quality, lgwin);
+    actual = StreamCompress(s, data, size, &actual_size);
+    CHECK(actual_size == expected_size);
+    CHECK(memcmp(actual, expected, expected_size) == 0);
+    CheckRoundtrip(actual, actual_size, data, size);
+    free(actual);
+    free(expected);
+  }
+  BrotliEncoderDestroyInstance(s);
+  free(inputs[0]);
+  free(inputs[1]);
+}
+
+/* Reset decoder must decode any stream, including ones with larger window,
+   after both finished and abandoned streams. */
+static void TestDecoderReset(void) {
+  static const int kWindows[] = {24, 10, 18, 16, 22};
+  size_t size;
+  uint8_t* data = ReadTestFile("alice29.txt", &size);
+  BrotliDecoderState* s = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+  size_t i;
+  CHECK(s != NULL);
+  for (i = 0; i < sizeof(kWindows) / sizeof(kWindows[0]); ++i) {
+    size_t compressed_size;
+    uint8_t* compressed = FreshCompress((int)(i * 2 + 1), kWindows[i], data,
+        size, &compressed_size);
+    uint8_t* decompressed;
+    if (i & 1) {
+      /* Abandon the stream after the first chunk of output. */
+      const uint8_t* next_in = compressed;
+      size_t available_in = compressed_size;
+      uint8_t* buffer = (uint8_t*)malloc(CHUNK_SIZE);
+      uint8_t* next_out = buffer;
+      size_t available_out = CHUNK_SIZE;
+      CHECK(buffer != NULL);
+      BrotliDecoderReset(s);
+      CHECK(BrotliDecoderDecompressStream(s, &available_in, &next_in,
+          &available_out, &next_out, NULL) ==
+          BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+      free(buffer);
+    }
+    BrotliDecoderReset(s);
+    decompressed = StreamDecompress(s, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    free(decompressed);
+    free(compressed);
+  }
+  BrotliDecoderDestroyInstance(s);
+  free(data);
+}
+
+/* Dictionary larger than 2MiB makes encoder use bigger index buckets; since
+   it consists of repeated data, bucket and slot limits are hit as well. */
+static void TestPreparedDictionary(void) {
+  static const int kQualities[] = {2, 5, 9, 10, 11};
+  size_t size;
+  uint8_t* data = ReadTestFile("lcet10.txt", &size);
+  size_t filler_size;
+  uint8_t* filler = ReadTestFile("plrabn12.txt", &filler_size);
+  size_t dictionary_size = size + 5 * filler_size;
+  uint8_t* dictionary = (uint8_t*)malloc(dictionary_size);
+  BrotliEncoderPreparedDictionary* prepared;
+  size_t i;
+  CHECK(dictionary != NULL);
+  CHECK(dictionary_size > ((size_t)2 << 20));
+  /* Input is placed at the beginning of the dictionary, i.e. far from the
+     stream. */
+  memcpy(dictionary, data, size);
+  for (i = 0; i < 5; ++i) {
+    memcpy(dictionary + size + i * filler_size, filler, filler_size);
+  }
+  prepared = BrotliEncoderPrepareDictionary(dictionary_size, dictionary,
+      NULL, NULL, NULL);
+  CHECK(prepared != NULL);
+
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    BrotliDecoderState* d = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    size_t plain_size;
+    uint8_t* plain = FreshCompress(kQualities[i], 24, data, size, &plain_size);
+    size_t compressed_size;
+    uint8_t* compressed;
+    uint8_t* decompressed;
+    CHECK(s != NULL);
+    CHECK(d != NULL);
+    Configure(s, kQualities[i], 24);
+    CHECK(BrotliEncoderAttachPreparedDictionary(s, prepared));
+    compressed = StreamCompress(s, data, size, &compressed_size);
+    /* Whole input is a single dictionary reference, modulo block splits. */
+    CHECK(compressed_size * 20 < plain_size);
+    CHECK(BrotliDecoderAttachDictionary(d, dictionary_size, dictionary));
+    decompressed = StreamDecompress(d, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    free(decompressed);
+    free(compressed);
+    free(plain);
+    BrotliDecoderDestroyInstance(d);
+    BrotliEncoderDestroyInstance(s);
+  }
+  BrotliEncoderDestroyPreparedDictionary(prepared);
+  free(dictionary);
+  free(filler);
+  free(data);
+}
+
+/* Dictionary is split into several chunks; input refers data across chunk
+   boundaries, both within and beyond the window. */
+static void TestAttachedDictionary(void) {
+  static const int kQualities[] = {5, 11};
+  static const int kWindows[] = {16, 18};
+  static const size_t kChunks[] = {0, 30000, 70000, 71000};
+  static const uint8_t kByte = 0;
+  size_t dictionary_size;
+  uint8_t* dictionary = ReadTestFile("asyoulik.txt", &dictionary_size);
+  size_t tail_size;
+  uint8_t* tail = ReadTestFile("alice29.txt", &tail_size);
+  size_t size = 100000 + 30000;
+  uint8_t* data = (uint8_t*)malloc(size);
+  const size_t num_chunks = sizeof(kChunks) / sizeof(kChunks[0]);
+  size_t i;
+  size_t j;
+  CHECK(data != NULL);
+  CHECK(dictionary_size > 110000);
+  memcpy(data, dictionary + 10000, 100000);
+  memcpy(data + 100000, tail, 30000);
+
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    BrotliEncoderPreparedDictionary* prepared[4];
+    BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    BrotliDecoderState* d = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    size_t plain_size;
+    uint8_t* plain = FreshCompress(kQualities[i], kWindows[i], data, size,
+        &plain_size);
+    size_t compressed_size;
+    uint8_t* compressed;
+    uint8_t* decompressed;
+    CHECK(s != NULL);
+    CHECK(d != NULL);
+    Configure(s, kQualities[i], kWindows[i]);
+    for (j = 0; j < num_chunks; ++j) {
+      size_t end = (j + 1 < num_chunks) ? kChunks[j + 1] : dictionary_size;
+      prepared[j] = BrotliEncoderPrepareDictionary(end - kChunks[j],
+          dictionary + kChunks[j], NULL, NULL, NULL);
+      CHECK(prepared[j] != NULL);
+      CHECK(BrotliEncoderAttachPreparedDictionary(s, prepared[j]));
+      CHECK(BrotliDecoderAttachDictionary(d, end - kChunks[j],
+          dictionary + kChunks[j]));
+    }
+    CHECK(!BrotliDecoderAttachDictionary(d, 0, dictionary));
+    compressed = StreamCompress(s, data, size, &compressed_size);
+    CHECK(compressed_size * 3 < plain_size);
+    decompressed = StreamDecompress(d, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    /* Too late to attach. */
+    CHECK(!BrotliDecoderAttachDictionary(d, 1, &kByte));
+
+    /* Dictionaries are forgotten by reset; 15 of them could be attached. */
+    BrotliDecoderReset(d);
+    for (j = 0; j < 15; ++j) {
+      CHECK(BrotliDecoderAttachDictionary(d, 1, &kByte));
+    }
+    CHECK(!BrotliDecoderAttachDictionary(d, 1, &kByte));
+
+    free(decompressed);
+    free(compressed);
+    free(plain);
+    BrotliDecoderDestroyInstance(d);
+    BrotliEncoderDestroyInstance(s);
+    for (j = 0; j < num_chunks; ++j) {
+      BrotliEncoderDestroyPreparedDictionary(prepared[j]);
+    }
+  }
+  free(tail);
+  free(dictionary);
+  free(data);
+}
+
+/* Returns BROTLI_TRUE if |needle| occurs in |haystack|. */
+static BROTLI_BOOL Contains(const uint8_t* haystack, size_t haystack_size,
+    const uint8_t* needle, size_t needle_size) {
+  size_t i;
+  for (i = 0; i + needle_size <= haystack_size; ++i) {
+    if (memcmp(haystack + i, needle, needle_size) == 0) return BROTLI_TRUE;
+  }
+  return BROTLI_FALSE;
+}
+
+/* Random input block between text ones must be stored as is (uncompressed
+   meta-block), rather than entropy coded together with the text. */
+static void TestIncompressibleBlock(void) {
+  static const int kQualities[] = {10, 11};
+  /* Quality 10 and 11 use 256KiB input blocks with this window; input is a
+     text block, random block, its repetition, and the rest of text. Another
+     input is a single block made of random data repeated twice. */
+  const size_t block_size = (size_t)1 << 18;
+  size_t text_size;
+  uint8_t* text = ReadTestFile("plrabn12.txt", &text_size);
+  size_t size = text_size + 2 * block_size;
+  uint8_t* data = (uint8_t*)malloc(size);
+  uint8_t* repeated = (uint8_t*)malloc(block_size);
+  uint32_t seed = 12345;
+  size_t i;
+  CHECK(data != NULL);
+  CHECK(repeated != NULL);
+  CHECK(text_size > block_size);
+  memcpy(data, text, block_size);
+  for (i = block_size; i < 2 * block_size; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = (uint8_t)(seed >> 23);
+  }
+  memcpy(data + 2 * block_size, data + block_size, block_size);
+  memcpy(data + 3 * block_size, text + block_size, text_size - block_size);
+  memcpy(repeated, data + block_size, block_size / 2);
+  memcpy(repeated + block_size / 2, data + block_size, block_size / 2);
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    size_t compressed_size;
+    uint8_t* compressed =
+        FreshCompress(kQualities[i], 22, data, size, &compressed_size);
+    CHECK(Contains(compressed, compressed_size, data + block_size,
+        block_size));
+    CheckRoundtrip(compressed, compressed_size, data, size);
+    free(compressed);
+    /* Repetition of random block is still found. */
+    compressed = FreshCompress(kQualities[i], 22, data + block_size,
+        2 * block_size, &compressed_size);
+    CHECK(compressed_size < block_size + block_size / 8);
+    CheckRoundtrip(compressed, compressed_size, data + block_size,
+        2 * block_size);
+    free(compressed);
+    /* Repetition inside of the random block is found as well; block is
+       parsed after the match found by sparse search. */
+    compressed = FreshCompress(kQualities[i], 22, repeated, block_size,
+        &compressed_size);
+    CHECK(compressed_size < block_size / 2 + block_size / 16);
+    CheckRoundtrip(compressed, compressed_size, repeated, block_size);
+    free(compressed);
+  }
+  free(repeated);
+  free(data);
+  free(text);
+}
+
+static void CountDictionaryReferences(void* opaque, size_t insert_length,
+    size_t copy_length, size_t distance) {
+  (void)insert_length;
+  if (copy_length != 0 && distance == 0) ++*(size_t*)opaque;
+}
+
+/* Quality 0 and 1 reference static dictionary words in text mode only. */
+static void TestFastDictionary(void) {
+  static const int kQualities[] = {0, 1};
+  static const BrotliEncoderMode kModes[] = {
+    BROTLI_MODE_GENERIC, BROTLI_MODE_TEXT
+  };
+  size_t size;
+  uint8_t* data = ReadTestFile("alice29.txt", &size);
+  size_t i;
+  for (i = 0; i < 4; ++i) {
+    BrotliEncoderMode mode = kModes[i & 1];
+    BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    BrotliDecoderState* d = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    size_t num_references = 0;
+    size_t compressed_size;
+    uint8_t* compressed;
+    uint8_t* decompressed;
+    CHECK(s != NULL);
+    CHECK(d != NULL);
+    Configure(s, kQualities[i >> 1], 22);
+    CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_MODE, (uint32_t)mode));
+    compressed = StreamCompress(s, data, size, &compressed_size);
+    CHECK(BrotliDecoderSetCommandCallback(d, CountDictionaryReferences,
+        &num_references));
+    decompressed = StreamDecompress(d, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    CHECK((num_references != 0) == (mode == BROTLI_MODE_TEXT));
+    free(decompressed);
+    free(compressed);
+    BrotliDecoderDestroyInstance(d);
+    BrotliEncoderDestroyInstance(s);
+  }
+  free(data);
+}
+
+/* Parse of the decoded stream; dictionary references become literals. */
+typedef struct CollectedParse {
+  BrotliEncoderCommand* commands;
+  size_t num_commands;
+  size_t capacity;
+  size_t pending_literals;
+} CollectedParse;
+
+static void CollectCommand(void* opaque, size_t insert_length,
+    size_t copy_length, size_t distance) {
+  CollectedParse* parse = (CollectedParse*)opaque;
+  BrotliEncoderCommand* cmd;
+  parse->pending_literals += insert_length;
+  if (copy_length != 0 && distance == 0) {
+    parse->pending_literals += copy_length;
+    return;
+  }
+  if (parse->num_commands == parse->capacity) {
+    parse->capacity = 2 * parse->capacity + 16;
+    parse->commands = (BrotliEncoderCommand*)realloc(parse->commands,
+        parse->capacity * sizeof(BrotliEncoderCommand));
+    CHECK(parse->commands != NULL);
+  }
+  cmd = &parse->commands[parse->num_commands++];
+  cmd->insert_length = (uint32_t)parse->pending_literals;
+  cmd->copy_length = (uint32_t)copy_length;
+  cmd->distance = (uint32_t)distance;
+  parse->pending_literals = 0;
+}
+
+/* Parse taken from a decoded stream is re-encoded; malformed ones are
+   rejected. */
+static void TestCompressCommands(void) {
+  static const BrotliEncoderCommand kInvalid[][2] = {
+    {{4, 1, 4}, {3, 0, 0}},  /* Copy is too short. */
+    {{4, 4, 5}, {0, 0, 0}},  /* Distance is beyond the start of input. */
+    {{4, 4, 0}, {0, 0, 0}},  /* Distance is zero. */
+    {{4, 4, 4}, {1, 0, 0}},  /* Parse is shorter than input. */
+    {{4, 4, 4}, {0, 4, 4}},  /* Parse is longer than input. */
+  };
+  static const uint8_t kSmallInput[8] = {'a', 'b', 'c', 'd', 'a', 'b', 'c',
+                                         'd'};
+  size_t size;
+  uint8_t* data = ReadTestFile("alice29.txt", &size);
+  size_t compressed_size;
+  uint8_t* compressed = FreshCompress(5, 22, data, size, &compressed_size);
+  CollectedParse parse = {NULL, 0, 0, 0};
+  BrotliDecoderState* d = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+  size_t capacity = BrotliEncoderMaxCompressedSize(size);
+  uint8_t* recompressed = (uint8_t*)malloc(capacity);
+  uint8_t* decompressed;
+  size_t recompressed_size = capacity;
+  uint8_t small_output[64];
+  size_t i;
+  CHECK(d != NULL);
+  CHECK(recompressed != NULL);
+  CHECK(BrotliDecoderSetCommandCallback(d, CollectCommand, &parse));
+  decompressed = StreamDecompress(d, compressed, compressed_size, size);
+  free(decompressed);
+  BrotliDecoderDestroyInstance(d);
+  if (parse.pending_literals != 0) {
+    /* Stream ends with dictionary references. */
+    CollectCommand(&parse, 0, 0, 0);
+  }
+  CHECK(BrotliEncoderCompressCommands(11, 22, BROTLI_MODE_GENERIC, size, data,
+      parse.num_commands, parse.commands, &recompressed_size, recompressed));
+  CheckRoundtrip(recompressed, recompressed_size, data, size);
+  CHECK(recompressed_size < compressed_size);
+
+  /* Small input with a valid parse is accepted, malformed ones are not. */
+  {
+    const BrotliEncoderCommand valid[2] = {{4, 4, 4}, {0, 0, 0}};
+    size_t output_size = sizeof(small_output);
+    CHECK(BrotliEncoderCompressCommands(5, 22, BROTLI_MODE_GENERIC,
+        sizeof(kSmallInput), kSmallInput, 2, valid, &output_size,
+        small_output));
+    CheckRoundtrip(small_output, output_size, kSmallInput,
+        sizeof(kSmallInput));
+  }
+  for (i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); ++i) {
+    size_t output_size = sizeof(small_output);
+    CHECK(!BrotliEncoderCompressCommands(5, 22, BROTLI_MODE_GENERIC,
+        sizeof(kSmallInput), kSmallInput, 2, kInvalid[i], &output_size,
+        small_output));
+    CHECK(output_size == 0);
+  }
+  /* Distance must also fit the window. */
+  {
+    const BrotliEncoderCommand distant[2] = {{2000, 8, 2000}, {0, 0, 0}};
+    uint8_t far_input[2008];
+    memcpy(far_input, data, 2000);
+    memcpy(far_input + 2000, data, 8);
+    recompressed_size = capacity;
+    CHECK(BrotliEncoderCompressCommands(5, 16, BROTLI_MODE_GENERIC,
+        sizeof(far_input), far_input, 2, distant, &recompressed_size,
+        recompressed));
+    CheckRoundtrip(recompressed, recompressed_size, far_input,
+        sizeof(far_input));
+    recompressed_size = capacity;
+    CHECK(!BrotliEncoderCompressCommands(5, 10, BROTLI_MODE_GENERIC,
+        sizeof(far_input), far_input, 2, distant, &recompressed_size,
+        recompressed));
+  }
+  free(parse.commands);
+  free(recompressed);
+  free(compressed);
+  free(data);
+}
+
+/* Allocator that tracks peak of allocated memory. */
+typedef struct CountingAllocator {
+  size_t current;
+  size_t peak;
+  size_t num_allocations;
+} CountingAllocator;
+
+typedef union AllocationHeader {
+  size_t size;
+  double align;
+  void* ptr;
+} AllocationHeader;
+
+static void* CountingAlloc(void* opaque, size_t size) {
+  CountingAllocator* allocator = (CountingAllocator*)opaque;
+  AllocationHeader* header =
+      (AllocationHeader*)malloc(sizeof(AllocationHeader) + size);
+  if (header == NULL) return NULL;
+  header->size = size;
+  allocator->num_allocations++;
+  allocator->current += size;
+  if (allocator->current > allocator->peak) {
+    allocator->peak = allocator->current;
+  }
+  return &header[1];
+}
+
+static void CountingFree(void* opaque, void* address) {
+  CountingAllocator* allocator = (CountingAllocator*)opaque;
+  AllocationHeader* header;
+  if (address == NULL) return;
+  header = &((AllocationHeader*)address)[-1];
+  allocator->current -= header->size;
+  free(header);
+}
+
+typedef struct MemoryLimitCase {
+  int quality;
+  int lgwin;
+  size_t size_hint;
+  size_t limit;
+  size_t first_chunk;  /* Compressed with PROCESS; 0 for whole input. */
+} MemoryLimitCase;
+
+/* Compresses |data| with the given parameters and returns peak of allocated
+   memory. Stream is checked to be valid. */
+static size_t MeasureEncoderPeak(const MemoryLimitCase* c,
+    const uint8_t* data, size_t size) {
+  CountingAllocator allocator = {0, 0, 0};
+  BrotliEncoderState* s =
+      BrotliEncoderCreateInstance(CountingAlloc, CountingFree, &allocator);
+  /* Input in two parts might take a few bytes more. */
+  size_t capacity = BrotliEncoderMaxCompressedSize(size) + CHUNK_SIZE;
+  uint8_t* compressed = (uint8_t*)malloc(capacity);
+  uint8_t* next_out = compressed;
+  size_t available_out = capacity;
+  const uint8_t* next_in = data;
+  size_t available_in = c->first_chunk;
+  CHECK(s != NULL);
+  CHECK(compressed != NULL);
+  Configure(s, c->quality, c->lgwin);
+  if (c->size_hint != 0) {
+    CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_SIZE_HINT,
+        (uint32_t)c->size_hint));
+  }
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_MEMORY_LIMIT,
+      (uint32_t)c->limit));
+  if (c->first_chunk != 0) {
+    CHECK(BrotliEncoderCompressStream(s, BROTLI_OPERATION_PROCESS,
+        &available_in, &next_in, &available_out, &next_out, NULL));
+    CHECK(available_in == 0);
+  }
+  available_in = size - c->first_chunk;
+  CHECK(BrotliEncoderCompressStream(s, BROTLI_OPERATION_FINISH,
+      &available_in, &next_in, &available_out, &next_out, NULL));
+  CHECK(BrotliEncoderIsFinished(s));
+  BrotliEncoderDestroyInstance(s);
+  CHECK(allocator.current == 0);
+  CheckRoundtrip(compressed, capacity - available_out, data, size);
+  free(compressed);
+  return allocator.peak;
+}
+
+/* Encoder with memory limit must not use more memory than the limit, as long
+   as the limit is reachable. */
+static void TestMemoryLimit(void) {
+  static const MemoryLimitCase kCases[] = {
+    /* Size hint makes window shrink; it should not be relied on to size
+       hasher unless the whole input is supplied at once. */
+    {10, 24, 100000, 12u << 20, 65536},
+    {11, 24, 100000, 12u << 20, 65536},
+    {10, 24, 100000, 12u << 20, 0},
+    {11, 22, 0, 24u << 20, 65536},
+    {9, 24, 0, 8u << 20, 65536},
+    {5, 22, 0, 4u << 20, 0},
+    {1, 24, 0, 1u << 20, 65536},
+    {10, 24, 0, 16u << 20, 0},
+  };
+  size_t size;
+  uint8_t* data = ReadTestFile("lcet10.txt", &size);
+  size_t i;
+  for (i = 0; i < sizeof(kCases) / sizeof(kCases[0]); ++i) {
+    const MemoryLimitCase* c = &kCases[i];
+    /* Size hint, if any, is exact. */
+    size_t peak = MeasureEncoderPeak(c, data,
+        c->size_hint != 0 ? c->size_hint : size);
+    if (peak > c->limit) {
+      fprintf(stderr, "q%d w%d hint %d limit %d: peak %d\n", c->quality,
+          c->lgwin, (int)c->size_hint, (int)c->limit, (int)peak);
+    }
+    CHECK(peak <= c->limit);
+  }
+  free(data);
+}
+
+/* Compresses |data| with the given parameters and exact size hint; |*peak| is
+   set to the peak of allocated memory. */
+static uint8_t* CompressWithLimit(int quality, int lgwin, int lgblock,
+    size_t limit, const uint8_t* data, size_t size, size_t* compressed_size,
+    size_t* peak) {
+  CountingAllocator allocator = {0, 0, 0};
+  BrotliEncoderState* s =
+      BrotliEncoderCreateInstance(CountingAlloc, CountingFree, &allocator);
+  uint8_t* compressed;
+  CHECK(s != NULL);
+  Configure(s, quality, lgwin);
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_LGBLOCK, (uint32_t)lgblock));
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_SIZE_HINT, (uint32_t)size));
+  CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_MEMORY_LIMIT,
+      (uint32_t)limit));
+  compressed = StreamCompress(s, data, size, compressed_size);
+  BrotliEncoderDestroyInstance(s);
+  CHECK(allocator.current == 0);
+  CheckRoundtrip(compressed, *compressed_size, data, size);
+  *peak = allocator.peak;
+  return compressed;
+}
+
+/* Limit that is just below the memory estimated for quality 10 and 11 is met
+   by parsing input blocks in parts; window and quality are kept. */
+static void TestWindowedZopfli(void) {
+  static const int kQualities[] = {10, 11};
+  const int lgwin = 18;
+  const size_t size = (size_t)1 << lgwin;
+  size_t text_size;
+  uint8_t* data = ReadTestFile("lcet10.txt", &text_size);
+  size_t reference_size;
+  uint8_t* reference;
+  size_t i;
+  CHECK(text_size >= size);
+  reference = FreshCompress(9, lgwin, data, size, &reference_size);
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    const int quality = kQualities[i];
+    size_t unlimited_size;
+    size_t unlimited_peak;
+    uint8_t* unlimited = CompressWithLimit(quality, lgwin, lgwin, 0, data,
+        size, &unlimited_size, &unlimited_peak);
+    size_t limit =
+        BrotliEncoderEstimatePeakMemoryUsage(quality, lgwin, lgwin, size) - 1;
+    size_t compressed_size;
+    size_t peak;
+    uint8_t* compressed = CompressWithLimit(quality, lgwin, lgwin,
+        limit, data, size, &compressed_size, &peak);
+    CHECK(peak < unlimited_peak);
+    /* Stream header: window is not reduced. */
+    CHECK((compressed[0] & 0xF) == (((lgwin - 17) << 1) | 1));
+    /* Parse is different, but still better than the one of quality 9. */
+    CHECK(compressed_size != unlimited_size ||
+        memcmp(compressed, unlimited, compressed_size) != 0);
+    CHECK(compressed_size < reference_size);
+    free(compressed);
+    free(unlimited);
+  }
+  free(reference);
+  free(data);
+}
+
+/* Compresses the whole |data| at once with counting |allocator|; encoder is
+   offered at most |out_chunk| bytes of output per call. */
+static uint8_t* CompressWithOutputChunk(int quality, const uint8_t* data,
+    size_t size, size_t out_chunk, CountingAllocator* allocator,
+    size_t* compressed_size) {
+  BrotliEncoderState* s =
+      BrotliEncoderCreateInstance(CountingAlloc, CountingFree, allocator);
+  size_t capacity = 2 * size + 1024;
+  uint8_t* compressed = (uint8_t*)malloc(capacity);
+  const uint8_t* next_in = data;
+  size_t available_in = size;
+  size_t total_out = 0;
+  CHECK(s != NULL);
+  CHECK(compressed != NULL);
+  Configure(s, quality, 22);
+  while (!BrotliEncoderIsFinished(s)) {
+    uint8_t* next_out = compressed + total_out;
+    size_t available_out = capacity - total_out < out_chunk ?
+        capacity - total_out : out_chunk;
+    CHECK(available_out != 0);
+    CHECK(BrotliEncoderCompressStream(s, BROTLI_OPERATION_FINISH,
+        &available_in, &next_in, &available_out, &next_out, &total_out));
+  }
+  BrotliEncoderDestroyInstance(s);
+  CHECK(allocator->current == 0);
+  *compressed_size = total_out;
+  return compressed;
+}
+
+/* Metablock is written straight to the caller's output if it fits the worst
+   case; output must be the same as with the internal storage. */
+static void TestDirectOutput(void) {
+  static const int kQualities[] = {2, 5, 10};
+  size_t size;
+  uint8_t* data = ReadTestFile("alice29.txt", &size);
+  size_t i;
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    CountingAllocator direct_allocator = {0, 0, 0};
+    CountingAllocator buffered_allocator = {0, 0, 0};
+    size_t direct_size;
+    size_t buffered_size;
+    uint8_t* direct = CompressWithOutputChunk(kQualities[i], data, size,
+        2 * size + 1024, &direct_allocator, &direct_size);
+    uint8_t* buffered = CompressWithOutputChunk(kQualities[i], data, size,
+        16, &buffered_allocator, &buffered_size);
+    CHECK(direct_size == buffered_size);
+    CHECK(memcmp(direct, buffered, direct_size) == 0);
+    CheckRoundtrip(direct, direct_size, data, size);
+    /* Internal storage is not allocated at all. */
+    CHECK(direct_allocator.num_allocations <
+        buffered_allocator.num_allocations);
+    CHECK(direct_allocator.peak <= buffered_allocator.peak);
+    free(buffered);
+    free(direct);
+  }
+  free(data);
+}
+
+/* Qualities 5 to 7 with at least 1MiB size hint and 19 to 24 bit window use
+   hasher, that rejects candidates by tags; tags are matched with SSE2, unless
+   built with BROTLI_BUILD_NO_SIMD, which is covered by a separate binary. */
+static void TestTaggedHasher(void) {
+  static const char* kFiles[] = {"plrabn12.txt", "lcet10.txt", "mapsdatazrh"};
+  static const int kWindowBits[] = {19, 24};
+  uint8_t* data = NULL;
+  size_t size = 0;
+  int quality;
+  size_t i;
+  for (i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
+    size_t file_size;
+    uint8_t* file = ReadTestFile(kFiles[i], &file_size);
+    data = (uint8_t*)realloc(data, size + file_size);
+    CHECK(data != NULL);
+    memcpy(data + size, file, file_size);
+    size += file_size;
+    free(file);
+  }
+  CHECK(size >= ((size_t)1 << 20));
+  for (quality = 5; quality <= 7; ++quality) {
+    for (i = 0; i < sizeof(kWindowBits) / sizeof(kWindowBits[0]); ++i) {
+      BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+      size_t compressed_size;
+      uint8_t* compressed;
+      CHECK(s != NULL);
+      Configure(s, quality, kWindowBits[i]);
+      CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_SIZE_HINT,
+          (uint32_t)size));
+      compressed = StreamCompress(s, data, size, &compressed_size);
+      BrotliEncoderDestroyInstance(s);
+      CheckRoundtrip(compressed, compressed_size, data, size);
+      free(compressed);
+    }
+  }
+  free(data);
+}
+
+/* Mirrored ring buffer must produce the same output as the ordinary one,
+   including windows that are too small or too large for mapping. */
+static void TestMirroredRingBuffer(void) {
+  static const int kWindowBits[] = {10, 16, 22, 24, 25};
+  size_t size;
+  uint8_t* data = ReadTestFile("plrabn12.txt", &size);
+  size_t i;
+  for (i = 0; i < sizeof(kWindowBits) / sizeof(kWindowBits[0]); ++i) {
+    const int lgwin = kWindowBits[i];
+    BrotliEncoderState* s = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    CountingAllocator allocator = {0, 0, 0};
+    BrotliDecoderState* d =
+        BrotliDecoderCreateInstance(CountingAlloc, CountingFree, &allocator);
+    size_t compressed_size;
+    uint8_t* compressed;
+    uint8_t* decompressed;
+    CHECK(s != NULL);
+    CHECK(d != NULL);
+    Configure(s, 5, lgwin);
+    if (lgwin > BROTLI_MAX_WINDOW_BITS) {
+      CHECK(BrotliEncoderSetParameter(s, BROTLI_PARAM_LARGE_WINDOW, 1));
+      CHECK(BrotliDecoderSetParameter(d, BROTLI_DECODER_PARAM_LARGE_WINDOW,
+          1));
+    }
+    compressed = StreamCompress(s, data, size, &compressed_size);
+    BrotliEncoderDestroyInstance(s);
+    CHECK(BrotliDecoderSetParameter(d,
+        BROTLI_DECODER_PARAM_MIRRORED_RING_BUFFER, 1));
+    decompressed = StreamDecompress(d, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    BrotliDecoderDestroyInstance(d);
+    CHECK(allocator.current == 0);
+    /* Mapping, if any, does not go through custom allocator. */
+    CHECK(allocator.peak <= BrotliDecoderEstimatePeakMemoryUsage(lgwin, 0));
+    free(decompressed);
+    free(compressed);
+  }
+  free(data);
+}
+
+/* Decodes |compressed| into a buffer of |capacity| bytes followed by a guard
+   area; decoding succeeds only if the whole |data| fits. */
+static void CheckOneShotDecode(const uint8_t* compressed,
+    size_t compressed_size, const uint8_t* data, size_t size,
+    size_t capacity) {
+  const size_t guard_size = 64;
+  uint8_t* decoded = (uint8_t*)malloc(capacity + guard_size);
+  size_t decoded_size = capacity;
+  BrotliDecoderResult result;
+  size_t i;
+  CHECK(decoded != NULL);
+  memset(decoded, 0xA5, capacity + guard_size);
+  result = BrotliDecoderDecompress(compressed_size, compressed, &decoded_size,
+      decoded);
+  if (capacity >= size) {
+    CHECK(result == BROTLI_DECODER_RESULT_SUCCESS);
+    CHECK(decoded_size == size);
+    CHECK(memcmp(decoded, data, size) == 0);
+  } else {
+    CHECK(result == BROTLI_DECODER_RESULT_ERROR);
+  }
+  /* Output buffer is the ring buffer; nothing is written past its end. */
+  for (i = capacity; i < capacity + guard_size; ++i) {
+    CHECK(decoded[i] == 0xA5);
+  }
+  free(decoded);
+}
+
+/* One-shot decoding writes directly to the output buffer; it must fit the
+   output exactly and refuse buffers that are too small. */
+static void TestOneShotDecode(void) {
+  static const int kQualities[] = {0, 5, 11};
+  static const int kWindowBits[] = {10, 16, 22};
+  /* Ends with static dictionary words. */
+  static const char kSentence[] =
+      "It was the best of times, it was the worst of times, it was the age "
+      "of wisdom, it was the age of foolishness";
+  const size_t random_size = 65536;
+  size_t text_size;
+  uint8_t* text = ReadTestFile("alice29.txt", &text_size);
+  uint8_t* random = (uint8_t*)malloc(random_size);
+  uint32_t seed = 12345;
+  size_t i;
+  size_t j;
+  CHECK(random != NULL);
+  for (i = 0; i < random_size; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    random[i] = (uint8_t)(seed >> 23);
+  }
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    for (j = 0; j < sizeof(kWindowBits) / sizeof(kWindowBits[0]); ++j) {
+      const uint8_t* inputs[3];
+      size_t sizes[3];
+      size_t k;
+      inputs[0] = text;
+      sizes[0] = text_size;
+      /* Stored as uncompressed meta-blocks. */
+      inputs[1] = random;
+      sizes[1] = random_size;
+      inputs[2] = (const uint8_t*)kSentence;
+      sizes[2] = sizeof(kSentence) - 1;
+      for (k = 0; k < 3; ++k) {
+        size_t compressed_size;
+        uint8_t* compressed = FreshCompress(kQualities[i], kWindowBits[j],
+            inputs[k], sizes[k], &compressed_size);
+        CheckOneShotDecode(compressed, compressed_size, inputs[k], sizes[k],
+            sizes[k]);
+        CheckOneShotDecode(compressed, compressed_size, inputs[k], sizes[k],
+            sizes[k] - 1);
+        CheckOneShotDecode(compressed, compressed_size, inputs[k], sizes[k],
+            sizes[k] / 2);
+        free(compressed);
+      }
+    }
+  }
+  /* Empty output fits into empty buffer. */
+  {
+    size_t compressed_size;
+    uint8_t* compressed = FreshCompress(5, 22, text, 0, &compressed_size);
+    CheckOneShotDecode(compressed, compressed_size, text, 0, 0);
+    free(compressed);
+  }
+  free(random);
+  free(text);
+}
+
+static void TrackLongestInsert(void* opaque, size_t insert_length,
+    size_t copy_length, size_t distance) {
+  size_t* longest = (size_t*)opaque;
+  (void)copy_length;
+  (void)distance;
+  if (insert_length > *longest) *longest = insert_length;
+}
+
+/* Long literal runs with a low-entropy tree are decoded two literals per
+   look-up; rare symbols have codes longer than the root table. */
+static void TestLiteralPairs(void) {
+  /* Quality 1 and 4 do not use literal context modeling. */
+  static const int kQualities[] = {1, 4};
+  /* Small window makes literal runs wrap around the ring buffer. */
+  static const int kWindowBits[] = {16, 22};
+  const size_t size = (size_t)1 << 20;
+  uint8_t* data = (uint8_t*)malloc(size);
+  uint32_t seed = 12345;
+  size_t i;
+  size_t j;
+  CHECK(data != NULL);
+  /* Symbol group k of 8 symbols has probability about 2^-(k+1): codes are
+     4 to 15 bits long, and random enough to leave few matches. */
+  for (i = 0; i < size; ++i) {
+    uint32_t k = 0;
+    seed = seed * 1103515245u + 12345u;
+    while (k < 16 && ((seed >> (31 - k)) & 1) == 0) ++k;
+    data[i] = (uint8_t)((k << 3) | ((seed >> 8) & 7));
+  }
+  for (i = 0; i < sizeof(kQualities) / sizeof(kQualities[0]); ++i) {
+    for (j = 0; j < sizeof(kWindowBits) / sizeof(kWindowBits[0]); ++j) {
+      BrotliDecoderState* d = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+      size_t longest_insert = 0;
+      size_t compressed_size;
+      uint8_t* compressed = FreshCompress(kQualities[i], kWindowBits[j], data,
+          size, &compressed_size);
+      uint8_t* decompressed;
+      CHECK(d != NULL);
+      CHECK(BrotliDecoderSetCommandCallback(d, TrackLongestInsert,
+          &longest_insert));
+      decompressed = StreamDecompress(d, compressed, compressed_size, size);
+      CHECK(memcmp(decompressed, data, size) == 0);
+      CHECK(longest_insert >= 2048);
+      BrotliDecoderDestroyInstance(d);
+      /* One-shot decoding has the whole input available at once. */
+      CheckOneShotDecode(compressed, compressed_size, data, size, size);
+      free(decompressed);
+      free(compressed);
+    }
+  }
+  free(data);
+}
+
+/* Encoder estimate must cover the memory actually used; memory limit relies
+   on it. */
+static void TestPeakMemoryEstimate(void) {
+  static const int kEncoderWindowBits[] = {10, 18, 24};
+  static const size_t kSizes[] = {100, 20000, 0};
+  static const int kWindowBits[] = {10, 16, 22, 24};
+  size_t size;
+  uint8_t* data = ReadTestFile("lcet10.txt", &size);
+  int quality;
+  size_t i;
+  size_t j;
+  for (quality = 0; quality <= 11; ++quality) {
+    for (i = 0; i < sizeof(kEncoderWindowBits) / sizeof(kEncoderWindowBits[0]);
+        ++i) {
+      for (j = 0; j < 2 * sizeof(kSizes) / sizeof(kSizes[0]); ++j) {
+        /* Whole input with exact size hint, or in two parts without it. */
+        const BROTLI_BOOL has_hint = TO_BROTLI_BOOL(j & 1);
+        const size_t input_size = kSizes[j / 2] != 0 ? kSizes[j / 2] : size;
+        MemoryLimitCase c;
+        size_t peak;
+        size_t estimate;
+        c.quality = quality;
+        c.lgwin = kEncoderWindowBits[i];
+        c.size_hint = has_hint ? input_size : 0;
+        c.limit = 0;
+        c.first_chunk = has_hint ? 0 : input_size / 4;
+        peak = MeasureEncoderPeak(&c, data, input_size);
+        estimate = BrotliEncoderEstimatePeakMemoryUsage(c.quality, c.lgwin, 0,
+            c.size_hint);
+        if (peak > estimate) {
+          fprintf(stderr, "q%d w%d size %d hint %d: peak %d, estimate %d\n",
+              c.quality, c.lgwin, (int)input_size, (int)c.size_hint, (int)peak,
+              (int)estimate);
+        }
+        CHECK(peak <= estimate);
+      }
+    }
+  }
+  for (i = 0; i < sizeof(kWindowBits) / sizeof(kWindowBits[0]); ++i) {
+    int lgwin = kWindowBits[i];
+    size_t compressed_size;
+    uint8_t* compressed = FreshCompress(5, lgwin, data, size, &compressed_size);
+    CountingAllocator allocator = {0, 0, 0};
+    BrotliDecoderState* s =
+        BrotliDecoderCreateInstance(CountingAlloc, CountingFree, &allocator);
+    uint8_t* decompressed;
+    CHECK(s != NULL);
+    decompressed = StreamDecompress(s, compressed, compressed_size, size);
+    CHECK(memcmp(decompressed, data, size) == 0);
+    BrotliDecoderDestroyInstance(s);
+    CHECK(allocator.current == 0);
+    CHECK(allocator.peak <= BrotliDecoderEstimatePeakMemoryUsage(lgwin, size));
+    /* Output size is only used to shrink the ring buffer. */
+    CHECK(allocator.peak <= BrotliDecoderEstimatePeakMemoryUsage(lgwin, 0));
+    free(decompressed);
+    free(compressed);
+  }
+  free(data);
+}
+
+typedef struct TestCase {
+  const char* name;
+  void (*run)(void);
+} TestCase;
+
+static const TestCase kTestCases[] = {
+  {"encoder-reset", TestEncoderReset},
+  {"decoder-reset", TestDecoderReset},
+  {"prepared-dictionary", TestPreparedDictionary},
+  {"attached-dictionary", TestAttachedDictionary},
+  {"memory-limit", TestMemoryLimit},
+  {"windowed-zopfli", TestWindowedZopfli},
+  {"direct-output", TestDirectOutput},
+  {"tagged-hasher", TestTaggedHasher},
+  {"peak-memory-estimate", TestPeakMemoryEstimate},
+  {"incompressible-block", TestIncompressibleBlock},
+  {"fast-dictionary", TestFastDictionary},
+  {"compress-commands", TestCompressCommands},
+  {"mirrored-ring-buffer", TestMirroredRingBuffer},
+  {"one-shot-decode", TestOneShotDecode},
+  {"literal-pairs", TestLiteralPairs},
+};
+
+int main(int argc, char** argv) {
+  size_t i;
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <case> <testdata directory>\n", argv[0]);
+    return 2;
+  }
+  testdata_dir = argv[2];
+  for (i = 0; i < sizeof(kTestCases) / sizeof(kTestCases[0]); ++i) {
+    if (strcmp(argv[1], kTestCases[i].name) == 0) {
+      kTestCases[i].run();
+      return 0;
+    }
+  }
+  fprintf(stderr, "Unknown test case: %s\n", argv[1]);
+  return 2;
+}
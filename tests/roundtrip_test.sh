@@ -31,6 +31,10 @@ for file in $INPUTS; do
       # Test the streaming version
       cat $file | $BROTLI -cq $quality | $BROTLI -cd >$uncompressed
       diff -q $file $uncompressed
+      # Test the segmented (multi-threaded) version
+      cat $file | $BROTLI -cq $quality --lgwin=16 --threads=4 | \
+          $BROTLI -cd >$uncompressed
+      diff -q $file $uncompressed
     done
   fi
 done
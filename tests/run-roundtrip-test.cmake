@@ -1,14 +1,38 @@
 set(ENV{QEMU_LD_PREFIX} "${BROTLI_WRAPPER_LD_PREFIX}")
 
+set(EXTRA_ARGS)
+if(LGWIN)
+  list(APPEND EXTRA_ARGS --lgwin=${LGWIN})
+endif()
+if(THREADS)
+  list(APPEND EXTRA_ARGS --threads=${THREADS})
+endif()
+if(LARGE_WINDOW)
+  list(APPEND EXTRA_ARGS --large_window=${LARGE_WINDOW})
+endif()
+
 execute_process(
   WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
-  COMMAND ${BROTLI_WRAPPER} ${BROTLI_CLI} --force --quality=${QUALITY} ${INPUT} --output=${OUTPUT}.br
+  COMMAND ${BROTLI_WRAPPER} ${BROTLI_CLI} --force --quality=${QUALITY} ${EXTRA_ARGS} ${INPUT} --output=${OUTPUT}.br
   RESULT_VARIABLE result
   ERROR_VARIABLE result_stderr)
 if(result)
   message(FATAL_ERROR "Compression failed: ${result_stderr}")
 endif()
 
+if(RECOMPRESS)
+  # Re-encode the stream with the best quality, reusing its parse.
+  file(RENAME "${OUTPUT}.br" "${OUTPUT}.0.br")
+  execute_process(
+    WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+    COMMAND ${BROTLI_WRAPPER} ${BROTLI_CLI} --force --recompress --quality=11 ${OUTPUT}.0.br --output=${OUTPUT}.br
+    RESULT_VARIABLE result
+    ERROR_VARIABLE result_stderr)
+  if(result)
+    message(FATAL_ERROR "Recompression failed: ${result_stderr}")
+  endif()
+endif()
+
 execute_process(
   WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
   COMMAND ${BROTLI_WRAPPER} ${BROTLI_CLI} --force --decompress ${OUTPUT}.br --output=${OUTPUT}.unbr
@@ -34,3 +58,19 @@ function(test_file_equality f1 f2)
 endfunction()
 
 test_file_equality("${INPUT}" "${OUTPUT}.unbr")
+
+if(THREADS)
+  # Output of segmented compression should not depend on number of threads,
+  # including the case when segments have spare threads.
+  foreach(threads 1 16)
+    execute_process(
+      WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+      COMMAND ${BROTLI_WRAPPER} ${BROTLI_CLI} --force --quality=${QUALITY} --lgwin=${LGWIN} --threads=${threads} ${INPUT} --output=${OUTPUT}.${threads}.br
+      RESULT_VARIABLE result
+      ERROR_VARIABLE result_stderr)
+    if(result)
+      message(FATAL_ERROR "Compression failed: ${result_stderr}")
+    endif()
+    test_file_equality("${OUTPUT}.br" "${OUTPUT}.${threads}.br")
+  endforeach()
+endif()